@@ -61,6 +61,7 @@ import gzip
 import gc
 
 import variableclasses as vc
+import organizedata
 
 global skipCFLOGParsing
 skipCFLOGParsing = 0
@@ -223,12 +224,20 @@ def parseMe(filename):
         
         # detect empty data entry for particular metric and print a warning 
         if p[2] == '': 
-            if not p[1] in stat_missing_warned: 
-                print("WARNING: Sample entry for metric '%s' has no data. Skipping..." % p[1])
-                stat_missing_warned[p[1]] = True
+            num = []
+
+        add_sample(p[1], num)
+
+    # num holds the values of one sample as strings (text log) or numbers
+    # (binary log)
+    def add_sample(name, num):
+        if len(num) == 0:
+            if not name in stat_missing_warned: 
+                print("WARNING: Sample entry for metric '%s' has no data. Skipping..." % name)
+                stat_missing_warned[name] = True
             return
 
-        lookup_input = p[1].lower()
+        lookup_input = name.lower()
         if (lookup_input  in stat_lookuptable):
             if (lookup_input == "globalcyclecount") and (int(num[0]) % 10000 == 0):
                 print("Processing global cycle %s" % num[0])
@@ -277,16 +286,16 @@ def parseMe(filename):
                     threadcount.append(int(x))
                 count += 1
 
-            if (p[1] not in CFLOG):
-                CFLOG[p[1]] = vc.variable('',2,0)
-                CFLOG[p[1]].data.append([]) # pc[]
-                CFLOG[p[1]].data.append([]) # threadcount[]
-                CFLOG[p[1]].maxPC = 0
+            if (name not in CFLOG):
+                CFLOG[name] = vc.variable('',2,0)
+                CFLOG[name].data.append([]) # pc[]
+                CFLOG[name].data.append([]) # threadcount[]
+                CFLOG[name].maxPC = 0
 
-            CFLOG[p[1]].data[0].append(pc)
-            CFLOG[p[1]].data[1].append(threadcount)
+            CFLOG[name].data[0].append(pc)
+            CFLOG[name].data[1].append(threadcount)
             MaxPC = max(pc)
-            CFLOG[p[1]].maxPC = max(MaxPC, CFLOG[p[1]].maxPC)
+            CFLOG[name].maxPC = max(MaxPC, CFLOG[name].maxPC)
         
         else:
             pass
@@ -301,6 +310,12 @@ def parseMe(filename):
     
     yacc.yacc()
 
+    # binary log written with -visualizer_binary
+    if organizedata.isBinaryVisualizerLog(filename):
+        for name, values in organizedata.readBinaryVisualizerLog(filename):
+            add_sample(name, values)
+        return variables
+
     # detect for gzip'ed log file and gunzip on the fly
     if (filename.endswith('.gz')):
         file = gzip.open(filename, 'r')
@@ -62,6 +62,8 @@
 
 import os
 import array
+import gzip
+import struct
 #from numpy import array
 import numpy
 import lexyacctexteditor
@@ -86,6 +88,85 @@ def setCFLOGInfoFiles(sourceViewFileList):
     if CFLOGptxFile == '' and len(sourceViewFileList[1]) > 0:
         CFLOGptxFile = sourceViewFileList[1][0]
 
+# Binary visualizer log (-visualizer_binary), see src/gpgpu-sim/visualizer_log.cc
+VISUALIZER_BINARY_MAGIC = b'GPGPUVIS'
+VISUALIZER_RECORD_KEY = 1
+VISUALIZER_RECORD_COLUMNS = 3
+VISUALIZER_RAGGED_ROWS = 0xffffffff
+# visualizer_value_type: struct format and size of one value
+visualizerValueFormat = [('i', 4), ('I', 4), ('q', 8), ('Q', 8), ('d', 8)]
+
+def isBinaryVisualizerLog(filename):
+    try:
+        file = gzip.open(filename, 'rb')
+        magic = file.read(len(VISUALIZER_BINARY_MAGIC))
+        file.close()
+    except (IOError, OSError, EOFError):
+        return False
+    return magic == VISUALIZER_BINARY_MAGIC
+
+# Yields (name, values) for every row of a binary visualizer log. This is the
+# same information as the "name: values" lines of the text log, with the
+# values already converted to numbers; within a sample, rows come grouped by
+# name.
+def readBinaryVisualizerLog(filename):
+    chunks = []
+    file = gzip.open(filename, 'rb')
+    try:
+        while True:
+            chunk = file.read(1 << 20)
+            if not chunk:
+                break
+            chunks.append(chunk)
+    except EOFError:
+        # the simulator did not finish writing the log, use what is there
+        print("WARNING: %s is truncated" % filename)
+    file.close()
+    data = b''.join(chunks)
+
+    if data[0:8] != VISUALIZER_BINARY_MAGIC:
+        raise ValueError("%s is not a binary visualizer log" % filename)
+    version, = struct.unpack_from('<I', data, 8)
+    if version != 1:
+        raise ValueError("unsupported visualizer log version %d" % version)
+
+    names = {}
+    pos = 12
+    try:
+        while pos + 8 <= len(data):
+            kind, key = struct.unpack_from('<II', data, pos)
+            if kind == VISUALIZER_RECORD_KEY:
+                length, = struct.unpack_from('<I', data, pos + 8)
+                names[key] = data[pos + 12:pos + 12 + length].decode()
+                pos += 12 + length
+            elif kind == VISUALIZER_RECORD_COLUMNS:
+                type, nRows, count = struct.unpack_from('<III', data, pos + 8)
+                fmt, size = visualizerValueFormat[type]
+                pos += 20
+                if count == VISUALIZER_RAGGED_ROWS:
+                    counts = struct.unpack_from('<%dI' % nRows, data, pos)
+                    pos += 4 * nRows
+                else:
+                    counts = [count] * nRows
+                nValues = sum(counts)
+                values = struct.unpack_from('<%d%s' % (nValues, fmt), data, pos)
+                pos += nValues * size
+                if count == VISUALIZER_RAGGED_ROWS:
+                    start = 0
+                    for rowCount in counts:
+                        yield names[key], list(values[start:start + rowCount])
+                        start += rowCount
+                else:
+                    # values are stored column by column
+                    for row in range(nRows):
+                        yield names[key], list(values[row::nRows])
+            else:
+                raise ValueError("corrupt visualizer log record %d" % kind)
+    except struct.error:
+        # last sample cut short by a truncated file
+        pass
+
+
 def organizedata(fileVars):
 
     organizeFunction = {
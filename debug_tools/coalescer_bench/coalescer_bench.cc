@@ -0,0 +1,351 @@
+// Standalone check and micro-benchmark of the global memory coalescer
+// (warp_inst_t::memory_coalescing_arch() and friends in
+// src/abstract_hardware_model.cc). The current implementation is compared
+// with the reference one in coalescer_reference.inc on a set of warp access
+// patterns: every pattern must produce the same memory accesses, in the same
+// order, and the time each implementation spends is reported. See readme.txt.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <bitset>
+#include <list>
+#include <map>
+#include <vector>
+
+// The parts of abstract_hardware_model.h the coalescer uses.
+typedef unsigned long long new_addr_type;
+const unsigned MAX_MEMORY_ACCESS_SIZE = 128;
+const unsigned MAX_WARP_SIZE = 32;
+const unsigned MAX_ACCESSES_PER_INSN_PER_THREAD = 8;
+typedef std::bitset<MAX_MEMORY_ACCESS_SIZE> mem_access_byte_mask_t;
+typedef std::bitset<MAX_WARP_SIZE> active_mask_t;
+typedef std::bitset<4> mem_access_sector_mask_t;
+
+enum mem_access_type { GLOBAL_ACC_R, GLOBAL_ACC_W };
+enum _memory_space_t { global_space, local_space, param_space_local };
+enum cache_operator_type { CACHE_ALL, CACHE_GLOBAL };
+
+struct memory_space_t {
+  _memory_space_t m_type;
+  _memory_space_t get_type() const { return m_type; }
+};
+
+struct core_config {
+  unsigned mem_warp_parts;
+  unsigned warp_size;
+  int gpgpu_coalesce_arch;
+  bool gmem_skip_L1D;
+  void *gpgpu_ctx;
+};
+
+class mem_access_t {
+ public:
+  mem_access_t(mem_access_type type, new_addr_type addr, unsigned size,
+               bool wr, const active_mask_t &active_mask,
+               const mem_access_byte_mask_t &byte_mask,
+               const mem_access_sector_mask_t &sector_mask, void *ctx)
+      : m_addr(addr),
+        m_size(size),
+        m_write(wr),
+        m_warp_mask(active_mask),
+        m_byte_mask(byte_mask),
+        m_sector_mask(sector_mask) {}
+  bool operator==(const mem_access_t &o) const {
+    return m_addr == o.m_addr && m_size == o.m_size && m_write == o.m_write &&
+           m_warp_mask == o.m_warp_mask && m_byte_mask == o.m_byte_mask &&
+           m_sector_mask == o.m_sector_mask;
+  }
+
+ private:
+  new_addr_type m_addr;
+  unsigned m_size;
+  bool m_write;
+  active_mask_t m_warp_mask;
+  mem_access_byte_mask_t m_byte_mask;
+  mem_access_sector_mask_t m_sector_mask;
+};
+
+new_addr_type line_size_based_tag_func(new_addr_type address,
+                                       new_addr_type line_size) {
+  return address & ~(line_size - 1);
+}
+
+// The warp_inst_t state the coalescer reads and writes.
+struct warp_state {
+  struct per_thread_info {
+    new_addr_type memreqaddr[MAX_ACCESSES_PER_INSN_PER_THREAD];
+  };
+
+  const core_config *m_config;
+  active_mask_t m_warp_active_mask;
+  per_thread_info m_per_scalar_thread[MAX_WARP_SIZE];
+  unsigned data_size;
+  memory_space_t space;
+  cache_operator_type cache_op;
+  std::list<mem_access_t> m_accessq;
+
+  bool active(unsigned thread) const {
+    return m_warp_active_mask.test(thread);
+  }
+};
+
+#define BENCH_WARP_INST_T                                                   \
+  struct warp_inst_t : warp_state {                                         \
+    struct transaction_info {                                               \
+      std::bitset<4> chunks;                                                \
+      mem_access_byte_mask_t bytes;                                         \
+      active_mask_t active;                                                 \
+      bool test_bytes(unsigned start_bit, unsigned end_bit) {               \
+        for (unsigned i = start_bit; i <= end_bit; i++)                     \
+          if (bytes.test(i)) return true;                                   \
+        return false;                                                       \
+      }                                                                     \
+    };                                                                      \
+    void memory_coalescing_arch(bool is_write, mem_access_type access_type); \
+    void memory_coalescing_arch_atomic(bool is_write,                       \
+                                       mem_access_type access_type);        \
+    void memory_coalescing_arch_reduce_and_send(                            \
+        bool is_write, mem_access_type access_type,                         \
+        const transaction_info &info, new_addr_type addr,                   \
+        unsigned segment_size);                                             \
+  };
+
+namespace reference {
+BENCH_WARP_INST_T
+#include "coalescer_reference.inc"
+}  // namespace reference
+
+namespace current {
+BENCH_WARP_INST_T
+// extracted from src/abstract_hardware_model.cc by the Makefile
+#include "coalescer_current.inc"
+}  // namespace current
+
+// One warp memory instruction: the configuration it is coalesced under and
+// the addresses of its threads.
+struct access_pattern {
+  bool atomic;
+  core_config config;
+  cache_operator_type cache_op;
+  _memory_space_t space;
+  unsigned data_size;
+  unsigned long long active_mask;
+  new_addr_type base;
+  unsigned accesses;  // per thread
+  std::vector<new_addr_type> offsets;  // thread-major, relative to base
+};
+
+// Small LCG so generated patterns are the same on every host.
+static unsigned long long g_seed;
+static unsigned next_rand(unsigned n) {
+  g_seed = g_seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (unsigned)(g_seed >> 33) % n;
+}
+
+// Unit stride, strided, random within a few segments, scattered and wide
+// stride accesses; atomics also get lanes hitting the same address.
+static access_pattern generate_pattern() {
+  static const unsigned sizes[] = {1, 2, 4, 8, 16};
+  access_pattern p;
+  p.config.warp_size = MAX_WARP_SIZE;
+  p.config.gpgpu_ctx = NULL;
+  p.config.mem_warp_parts = next_rand(3) == 0 ? 2 : 1;
+  p.config.gpgpu_coalesce_arch = next_rand(2) ? 70 : 20;
+  p.config.gmem_skip_L1D = next_rand(2);
+  p.data_size = sizes[next_rand(5)];
+  p.cache_op = next_rand(2) ? CACHE_ALL : CACHE_GLOBAL;
+  p.space = (_memory_space_t)next_rand(3);
+  p.active_mask = 0;
+  for (unsigned t = 0; t < MAX_WARP_SIZE; t++)
+    if (next_rand(8)) p.active_mask |= 1ULL << t;
+  unsigned kind = next_rand(5);
+  p.base = (new_addr_type)next_rand(100000) * 128 + 0x10000;
+  p.atomic = next_rand(4) == 0;
+  if (p.atomic) p.space = global_space;
+  // local memory accesses are split into 4 byte chunks
+  p.accesses = (p.space != global_space && p.data_size >= 4 && !p.atomic)
+                   ? p.data_size / 4
+                   : 1;
+  new_addr_type d = p.data_size;
+  for (unsigned t = 0; t < MAX_WARP_SIZE; t++) {
+    for (unsigned k = 0; k < p.accesses; k++) {
+      new_addr_type a;
+      switch (kind) {
+        case 0:
+          a = t * d;
+          break;
+        case 1:
+          a = (t * d * 7) % 4096;
+          break;
+        case 2:
+          a = next_rand(64) * d;
+          break;
+        case 3:
+          a = (new_addr_type)next_rand(1000) * 256 + next_rand(128);
+          break;
+        default:
+          a = t * 4 * d;
+      }
+      if (p.atomic) {
+        a &= ~(d - 1);
+        if (next_rand(3) == 0) a = next_rand(4) * d;
+      } else if (kind != 3) {
+        a &= ~(d - 1);
+      }
+      p.offsets.push_back(a + k * 4);
+    }
+  }
+  return p;
+}
+
+// Text format, one pattern per line:
+//   atomic arch warp_parts skip_l1d cache_global space data_size active_mask
+//   base accesses offsets...
+// with the mask, base and offsets in hex.
+static void write_pattern(FILE *f, const access_pattern &p) {
+  fprintf(f, "%d %d %u %d %d %d %u %llx %llx %u", p.atomic,
+          p.config.gpgpu_coalesce_arch, p.config.mem_warp_parts,
+          p.config.gmem_skip_L1D, p.cache_op == CACHE_GLOBAL, p.space,
+          p.data_size, p.active_mask, p.base, p.accesses);
+  for (unsigned i = 0; i < p.offsets.size(); i++)
+    fprintf(f, " %llx", p.offsets[i]);
+  fprintf(f, "\n");
+}
+
+static bool read_pattern(FILE *f, access_pattern &p) {
+  int atomic, skip_l1d, cache_global, space;
+  int c;
+  while ((c = fgetc(f)) == '#' || c == '\n') {
+    while (c != '\n' && c != EOF) c = fgetc(f);
+  }
+  if (c == EOF) return false;
+  ungetc(c, f);
+  if (fscanf(f, "%d %d %u %d %d %d %u %llx %llx %u", &atomic,
+             &p.config.gpgpu_coalesce_arch, &p.config.mem_warp_parts,
+             &skip_l1d, &cache_global, &space, &p.data_size, &p.active_mask,
+             &p.base, &p.accesses) != 10 ||
+      p.accesses < 1 || p.accesses > MAX_ACCESSES_PER_INSN_PER_THREAD) {
+    fprintf(stderr, "malformed pattern\n");
+    exit(1);
+  }
+  p.atomic = atomic;
+  p.config.gmem_skip_L1D = skip_l1d;
+  p.config.warp_size = MAX_WARP_SIZE;
+  p.config.gpgpu_ctx = NULL;
+  p.cache_op = cache_global ? CACHE_GLOBAL : CACHE_ALL;
+  p.space = (_memory_space_t)space;
+  p.offsets.resize(MAX_WARP_SIZE * p.accesses);
+  for (unsigned i = 0; i < p.offsets.size(); i++) {
+    if (fscanf(f, "%llx", &p.offsets[i]) != 1) {
+      fprintf(stderr, "malformed pattern\n");
+      exit(1);
+    }
+  }
+  return true;
+}
+
+static void load_warp(warp_state &w, const access_pattern &p) {
+  w.m_config = &p.config;
+  w.m_warp_active_mask = active_mask_t(p.active_mask);
+  w.data_size = p.data_size;
+  w.space.m_type = p.space;
+  w.cache_op = p.cache_op;
+  memset(w.m_per_scalar_thread, 0, sizeof(w.m_per_scalar_thread));
+  for (unsigned t = 0; t < MAX_WARP_SIZE; t++)
+    for (unsigned k = 0; k < p.accesses; k++)
+      w.m_per_scalar_thread[t].memreqaddr[k] =
+          p.base + p.offsets[t * p.accesses + k];
+  w.m_accessq.clear();
+}
+
+static double now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+template <class W>
+static double coalesce(W &w, const access_pattern &p, unsigned reps) {
+  double start = now();
+  for (unsigned r = 0; r < reps; r++) {
+    w.m_accessq.clear();
+    if (p.atomic)
+      w.memory_coalescing_arch_atomic(false, GLOBAL_ACC_R);
+    else
+      w.memory_coalescing_arch(false, GLOBAL_ACC_R);
+  }
+  return now() - start;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: coalescer_bench [-reps n] <patterns file>\n"
+          "       coalescer_bench [-reps n] -random <count> [seed]\n"
+          "       coalescer_bench -record <count> [seed] > <patterns file>\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  unsigned reps = 20;
+  int a = 1;
+  if (a + 1 < argc && !strcmp(argv[a], "-reps")) {
+    reps = atoi(argv[a + 1]);
+    a += 2;
+  }
+  if (a >= argc) usage();
+
+  FILE *in = NULL;
+  unsigned long long count = 0;
+  bool record = false;
+  if (!strcmp(argv[a], "-random") || !strcmp(argv[a], "-record")) {
+    if (a + 1 >= argc) usage();
+    record = !strcmp(argv[a], "-record");
+    count = strtoull(argv[a + 1], NULL, 0);
+    g_seed = a + 2 < argc ? strtoull(argv[a + 2], NULL, 0) : 5;
+  } else {
+    in = fopen(argv[a], "r");
+    if (!in) {
+      perror(argv[a]);
+      return 1;
+    }
+  }
+
+  if (record) {
+    printf("# coalescer_bench -record %llu %llu\n", count, g_seed);
+    for (unsigned long long n = 0; n < count; n++)
+      write_pattern(stdout, generate_pattern());
+    return 0;
+  }
+
+  reference::warp_inst_t ref;
+  current::warp_inst_t cur;
+  unsigned long long cases = 0, mismatches = 0, accesses = 0;
+  double ref_time = 0, cur_time = 0;
+  access_pattern p;
+  while (in ? read_pattern(in, p) : cases < count) {
+    if (!in) p = generate_pattern();
+    load_warp(ref, p);
+    load_warp(cur, p);
+    ref_time += coalesce(ref, p, reps);
+    cur_time += coalesce(cur, p, reps);
+    if (!(ref.m_accessq == cur.m_accessq)) {
+      if (mismatches == 0) {
+        fprintf(stderr, "first mismatching pattern:\n");
+        write_pattern(stderr, p);
+      }
+      mismatches++;
+    }
+    accesses += ref.m_accessq.size();
+    cases++;
+  }
+  if (in) fclose(in);
+
+  printf("patterns %llu, accesses %llu, mismatches %llu\n", cases, accesses,
+         mismatches);
+  printf("reference %.3f s, current %.3f s (%u repetitions)\n", ref_time,
+         cur_time, reps);
+  return mismatches != 0;
+}
@@ -975,7 +975,7 @@ cudaError_t cudaLaunchInternal(const char *hostFun,
 
   if (gpu->resume_option == 1 && (grid->get_uid() == gpu->resume_kernel)) {
     char f1name[2048];
-    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.txt",
+    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.bin",
              grid->get_uid());
 
     g_checkpoint->load_global_mem(global_mem, f1name);
@@ -983,7 +983,7 @@ cudaError_t cudaLaunchInternal(const char *hostFun,
   }
   if (gpu->resume_option == 1 && (grid->get_uid() < gpu->resume_kernel)) {
     char f1name[2048];
-    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.txt",
+    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.bin",
              grid->get_uid());
 
     g_checkpoint->load_global_mem(global_mem, f1name);
@@ -3004,16 +3004,30 @@ void cuda_runtime_api::extract_ptx_files_using_cuobjdump(CUctx_st *context) {
     app_binary = std::string(pytorch_bin);
   }
 
+  // The extracted PTX only depends on the binary, so with a PTX cache the
+  // list and the files are reused by later runs of the same binary. The list
+  // is stored last and marks a complete entry.
+  bool cdp = gpgpu_ctx->device_runtime->g_cdp_enabled;
+  std::string cache_name;
+  bool cached = false;
+  if (ptx_cache_enabled()) {
+    char name[64];
+    snprintf(name, sizeof(name), "cuobjdump-%016llx",
+             ptx_cache_file_hash(app_binary.c_str(), cdp ? "cdp" : ""));
+    cache_name = name;
+    cached = ptx_cache_fetch(cache_name + ".list", ptx_list_file_name);
+  }
+
   // only want file names
   snprintf(command, 1000,
            "$CUDA_INSTALL_PATH/bin/cuobjdump -lptx %s  | cut -d \":\" -f 2 | "
            "awk '{$1=$1}1' > %s",
            app_binary.c_str(), ptx_list_file_name);
-  if (system(command) != 0) {
+  if (!cached && system(command) != 0) {
     printf("WARNING: Failed to execute cuobjdump to get list of ptx files \n");
     exit(0);
   }
-  if (!gpgpu_ctx->device_runtime->g_cdp_enabled) {
+  if (!cdp) {
     // based on the list above, dump ptx files individually. Format of dumped
     // ptx file is prog_name.unique_no.sm_<>.ptx
 
@@ -3022,16 +3036,21 @@ void cuda_runtime_api::extract_ptx_files_using_cuobjdump(CUctx_st *context) {
     while (std::getline(infile, line)) {
       // int pos = line.find(std::string(get_app_binary_name(app_binary)));
       const char *ptx_file = line.c_str();
-      printf("Extracting specific PTX file named %s \n", ptx_file);
-      snprintf(command, 1000, "$CUDA_INSTALL_PATH/bin/cuobjdump -xptx %s %s",
-               ptx_file, app_binary.c_str());
-      if (system(command) != 0) {
-        printf("ERROR: command: %s failed \n", command);
-        exit(0);
+      if (!cached || !ptx_cache_fetch(cache_name + "." + line, ptx_file)) {
+        printf("Extracting specific PTX file named %s \n", ptx_file);
+        snprintf(command, 1000,
+                 "$CUDA_INSTALL_PATH/bin/cuobjdump -xptx %s %s", ptx_file,
+                 app_binary.c_str());
+        if (system(command) != 0) {
+          printf("ERROR: command: %s failed \n", command);
+          exit(0);
+        }
+        ptx_cache_store(cache_name + "." + line, ptx_file);
       }
       context->no_of_ptx++;
     }
   }
+  if (!cached) ptx_cache_store(cache_name + ".list", ptx_list_file_name);
 
   if (!context->no_of_ptx) {
     printf(
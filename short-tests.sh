@@ -18,6 +18,7 @@ git config --system --add safe.directory '*'
 export PATH=$CUDA_INSTALL_PATH/bin:$PATH
 source ./setup_environment
 make -j
+make -C debug_tools/coalescer_bench run || exit 1
 
 git clone https://github.com/accel-sim/accel-sim-framework.git
 ./accel-sim-framework/util/job_launching/run_simulations.py -C $CONFIG -B rodinia_2.0-ft -N regress -l local
@@ -71,43 +71,26 @@ checkpoint::checkpoint() {
     mkdir("checkpoint_files", 0777);
   }
 }
-void checkpoint::load_global_mem(class memory_space *temp_mem, char *f1name) {
-  FILE *fp2 = fopen(f1name, "r");
-  assert(fp2 != NULL);
-  char line[128]; /* or other suitable maximum line size */
-  unsigned int offset = 0;
-  while (fgets(line, sizeof line, fp2) != NULL) /* read a line */
-  {
-    unsigned int index;
-    char *pch;
-    pch = strtok(line, " ");
-    if (pch[0] == 'g' || pch[0] == 's' || pch[0] == 'l') {
-      pch = strtok(NULL, " ");
-
-      std::stringstream ss;
-      ss << std::hex << pch;
-      ss >> index;
+mem_image *checkpoint::open_image(const char *fname) {
+  std::string error;
+  mem_image *image = mem_image::open(fname, error);
+  if (image == NULL)
+    printf("GPGPU-Sim: ERROR ** memory image \'%s\': %s\n", fname,
+           error.c_str());
+  return image;
+}
 
-      offset = 0;
-    } else {
-      unsigned int data;
-      std::stringstream ss;
-      ss << std::hex << pch;
-      ss >> data;
-      temp_mem->write_only(offset, index, 4, &data);
-      offset = offset + 4;
-    }
-    // fputs ( line, stdout ); /* write the line */
-  }
-  fclose(fp2);
+// The image is not read in full: its pages are copied into the memory space
+// the first time they are accessed.
+void checkpoint::load_global_mem(class memory_space *temp_mem, char *f1name) {
+  mem_image *image = open_image(f1name);
+  if (image == NULL) exit(1);
+  temp_mem->attach_image(image);
 }
 
 void checkpoint::store_global_mem(class memory_space *mem, char *fname,
-                                  char *format) {
-  FILE *fp3 = fopen(fname, "w");
-  assert(fp3 != NULL);
-  mem->print(format, fp3);
-  fclose(fp3);
+                                  bool compress) {
+  mem->store_image(fname, compress);
 }
 
 void move_warp(warp_inst_t *&dst, warp_inst_t *&src) {
@@ -152,6 +135,9 @@ void gpgpu_functional_sim_config::reg_options(class OptionParser *opp) {
                          " resume from which CTA ", "0");
   option_parser_register(opp, "-checkpoint_insn_Y", OPT_INT32,
                          &checkpoint_insn_Y, " resume from which CTA ", "0");
+  option_parser_register(opp, "-checkpoint_compress", OPT_BOOL,
+                         &checkpoint_compress,
+                         " zlib compress checkpointed memory pages", "0");
 
   option_parser_register(
       opp, "-gpgpu_ptx_convert_to_ptxplus", OPT_BOOL, &m_ptx_convert_to_ptxplus,
@@ -193,6 +179,7 @@ gpgpu_t::gpgpu_t(const gpgpu_functional_sim_config &config, gpgpu_context *ctx)
   resume_CTA = m_function_model_config.get_resume_CTA();
   checkpoint_CTA_t = m_function_model_config.get_checkpoint_CTA_t();
   checkpoint_insn_Y = m_function_model_config.get_checkpoint_insn_Y();
+  checkpoint_compress = m_function_model_config.get_checkpoint_compress();
 
   // initialize texture mappings to empty
   m_NameToTextureInfo.clear();
@@ -472,6 +459,63 @@ void warp_inst_t::generate_mem_accesses() {
   m_mem_accesses_created = true;
 }
 
+// Per-host-thread scratch space of the coalescer. The transactions of a
+// subwarp are kept in a flat array (a subwarp touches only a few segments)
+// instead of a map, so coalescing does not allocate once the array has grown
+// to its working size.
+struct coalescer_transaction {
+  new_addr_type block_address;
+  warp_inst_t::transaction_info info;
+};
+static thread_local std::vector<coalescer_transaction> tl_coalescer_trans;
+
+// The transaction of the segment at block_address, created if needed.
+// Neighbouring threads usually access the segment found last, so the search
+// starts at the back.
+static warp_inst_t::transaction_info &find_transaction(
+    std::vector<coalescer_transaction> &transactions,
+    new_addr_type block_address) {
+  for (unsigned i = transactions.size(); i-- > 0;)
+    if (transactions[i].block_address == block_address)
+      return transactions[i].info;
+  transactions.push_back(coalescer_transaction());
+  transactions.back().block_address = block_address;
+  return transactions.back().info;
+}
+
+// Stable sort by block address; transactions are sent in the order a map
+// keyed by block address (with a list per address) would yield.
+static void sort_transactions(
+    std::vector<coalescer_transaction> &transactions) {
+  for (unsigned i = 1; i < transactions.size(); i++) {
+    if (transactions[i - 1].block_address <= transactions[i].block_address)
+      continue;
+    coalescer_transaction t = transactions[i];
+    unsigned j = i;
+    for (; j > 0 && transactions[j - 1].block_address > t.block_address; j--)
+      transactions[j] = transactions[j - 1];
+    transactions[j] = t;
+  }
+}
+
+#define COALESCER_MAX_BYTE_RUN 16
+
+// Mask of the n bytes starting at idx, clipped to MAX_MEMORY_ACCESS_SIZE.
+static mem_access_byte_mask_t byte_run_mask(unsigned idx, unsigned n) {
+  static const struct byte_run_table {
+    byte_run_table() {
+      for (unsigned n = 0; n <= COALESCER_MAX_BYTE_RUN; n++)
+        for (unsigned i = 0; i < n; i++) runs[n].set(i);
+    }
+    mem_access_byte_mask_t runs[COALESCER_MAX_BYTE_RUN + 1];
+  } table;
+  if (n <= COALESCER_MAX_BYTE_RUN) return table.runs[n] << idx;
+  mem_access_byte_mask_t mask;
+  for (unsigned i = 0; i < n; i++)
+    if ((idx + i) < MAX_MEMORY_ACCESS_SIZE) mask.set(idx + i);
+  return mask;
+}
+
 void warp_inst_t::memory_coalescing_arch(bool is_write,
                                          mem_access_type access_type) {
   // see the CUDA manual where it discusses coalescing rules before reading this
@@ -507,8 +551,10 @@ void warp_inst_t::memory_coalescing_arch(bool is_write,
   }
   unsigned subwarp_size = m_config->warp_size / warp_parts;
 
+  std::vector<coalescer_transaction> &subwarp_transactions =
+      tl_coalescer_trans;
   for (unsigned subwarp = 0; subwarp < warp_parts; subwarp++) {
-    std::map<new_addr_type, transaction_info> subwarp_transactions;
+    subwarp_transactions.clear();
 
     // step 1: find all transactions generated by this subwarp
     for (unsigned thread = subwarp * subwarp_size;
@@ -541,7 +587,8 @@ void warp_inst_t::memory_coalescing_arch(bool is_write,
         unsigned chunk =
             (addr & 127) / 32;  // which 32-byte chunk within in a 128-byte
                                 // chunk does this thread access?
-        transaction_info &info = subwarp_transactions[block_address];
+        transaction_info &info =
+            find_transaction(subwarp_transactions, block_address);
 
         // can only write to one segment
         // it seems like in trace driven, a thread can write to more than one
@@ -551,8 +598,7 @@ void warp_inst_t::memory_coalescing_arch(bool is_write,
         info.chunks.set(chunk);
         info.active.set(thread);
         unsigned idx = (addr & 127);
-        for (unsigned i = 0; i < data_size_coales; i++)
-          if ((idx + i) < MAX_MEMORY_ACCESS_SIZE) info.bytes.set(idx + i);
+        info.bytes |= byte_run_mask(idx, data_size_coales);
 
         // it seems like in trace driven, a thread can write to more than one
         // segment handle this special case
@@ -562,22 +608,21 @@ void warp_inst_t::memory_coalescing_arch(bool is_write,
           new_addr_type block_address =
               line_size_based_tag_func(addr, segment_size);
           unsigned chunk = (addr & 127) / 32;
-          transaction_info &info = subwarp_transactions[block_address];
+          transaction_info &info =
+              find_transaction(subwarp_transactions, block_address);
           info.chunks.set(chunk);
           info.active.set(thread);
           unsigned idx = (addr & 127);
-          for (unsigned i = 0; i < data_size_coales; i++)
-            if ((idx + i) < MAX_MEMORY_ACCESS_SIZE) info.bytes.set(idx + i);
+          info.bytes |= byte_run_mask(idx, data_size_coales);
         }
       }
     }
 
     // step 2: reduce each transaction size, if possible
-    std::map<new_addr_type, transaction_info>::iterator t;
-    for (t = subwarp_transactions.begin(); t != subwarp_transactions.end();
-         t++) {
-      new_addr_type addr = t->first;
-      const transaction_info &info = t->second;
+    sort_transactions(subwarp_transactions);
+    for (unsigned t = 0; t < subwarp_transactions.size(); t++) {
+      new_addr_type addr = subwarp_transactions[t].block_address;
+      const transaction_info &info = subwarp_transactions[t].info;
 
       memory_coalescing_arch_reduce_and_send(is_write, access_type, info, addr,
                                              segment_size);
@@ -623,9 +668,11 @@ void warp_inst_t::memory_coalescing_arch_atomic(bool is_write,
   }
   unsigned subwarp_size = m_config->warp_size / warp_parts;
 
+  // transactions in the order they were created; a segment may have several
+  std::vector<coalescer_transaction> &subwarp_transactions =
+      tl_coalescer_trans;
   for (unsigned subwarp = 0; subwarp < warp_parts; subwarp++) {
-    std::map<new_addr_type, std::list<transaction_info> >
-        subwarp_transactions;  // each block addr maps to a list of transactions
+    subwarp_transactions.clear();
 
     // step 1: find all transactions generated by this subwarp
     for (unsigned thread = subwarp * subwarp_size;
@@ -644,49 +691,38 @@ void warp_inst_t::memory_coalescing_arch_atomic(bool is_write,
              line_size_based_tag_func(addr + data_size - 1, segment_size));
 
       // Find a transaction that does not conflict with this thread's accesses
-      bool new_transaction = true;
-      std::list<transaction_info>::iterator it;
-      transaction_info *info;
-      for (it = subwarp_transactions[block_address].begin();
-           it != subwarp_transactions[block_address].end(); it++) {
-        unsigned idx = (addr & 127);
-        if (not it->test_bytes(idx, idx + data_size - 1)) {
-          new_transaction = false;
-          info = &(*it);
+      unsigned idx = (addr & 127);
+      mem_access_byte_mask_t bytes = byte_run_mask(idx, data_size);
+      transaction_info *info = NULL;
+      for (unsigned t = 0; t < subwarp_transactions.size(); t++) {
+        if (subwarp_transactions[t].block_address == block_address &&
+            (subwarp_transactions[t].info.bytes & bytes).none()) {
+          info = &subwarp_transactions[t].info;
           break;
         }
       }
-      if (new_transaction) {
+      if (!info) {
         // Need a new transaction
-        subwarp_transactions[block_address].push_back(transaction_info());
-        info = &subwarp_transactions[block_address].back();
+        subwarp_transactions.push_back(coalescer_transaction());
+        subwarp_transactions.back().block_address = block_address;
+        info = &subwarp_transactions.back().info;
       }
       assert(info);
 
       info->chunks.set(chunk);
       info->active.set(thread);
-      unsigned idx = (addr & 127);
-      for (unsigned i = 0; i < data_size; i++) {
-        assert(!info->bytes.test(idx + i));
-        info->bytes.set(idx + i);
-      }
+      assert((info->bytes & bytes).none());
+      info->bytes |= bytes;
     }
 
     // step 2: reduce each transaction size, if possible
-    std::map<new_addr_type, std::list<transaction_info> >::iterator t_list;
-    for (t_list = subwarp_transactions.begin();
-         t_list != subwarp_transactions.end(); t_list++) {
-      // For each block addr
-      new_addr_type addr = t_list->first;
-      const std::list<transaction_info> &transaction_list = t_list->second;
-
-      std::list<transaction_info>::const_iterator t;
-      for (t = transaction_list.begin(); t != transaction_list.end(); t++) {
-        // For each transaction
-        const transaction_info &info = *t;
-        memory_coalescing_arch_reduce_and_send(is_write, access_type, info,
-                                               addr, segment_size);
-      }
+    sort_transactions(subwarp_transactions);
+    for (unsigned t = 0; t < subwarp_transactions.size(); t++) {
+      // For each transaction, by block addr
+      const transaction_info &info = subwarp_transactions[t].info;
+      memory_coalescing_arch_reduce_and_send(
+          is_write, access_type, info, subwarp_transactions[t].block_address,
+          segment_size);
     }
   }
 }
@@ -1185,6 +1221,8 @@ void simt_stack::update(simt_mask_t &thread_done, addr_vector_t &next_pc,
 }
 
 void core_t::execute_warp_inst_t(warp_inst_t &inst, unsigned warpId) {
+  if (ptx_thread_info::ptx_exec_warp_inst(this, inst, warpId)) return;
+
   for (unsigned t = 0; t < m_warp_size; t++) {
     if (inst.active(t)) {
       if (warpId == (unsigned(-1))) warpId = inst.warp_id();
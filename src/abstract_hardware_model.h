@@ -558,6 +558,7 @@ class gpgpu_functional_sim_config {
   int get_resume_CTA() const { return resume_CTA; }
   int get_checkpoint_CTA_t() const { return checkpoint_CTA_t; }
   int get_checkpoint_insn_Y() const { return checkpoint_insn_Y; }
+  bool get_checkpoint_compress() const { return checkpoint_compress; }
 
  private:
   // PTX options
@@ -573,6 +574,7 @@ class gpgpu_functional_sim_config {
   unsigned resume_CTA;
   unsigned checkpoint_CTA_t;
   int checkpoint_insn_Y;
+  bool checkpoint_compress;
   int g_ptx_inst_debug_to_file;
   char *g_ptx_inst_debug_file;
   int g_ptx_inst_debug_thread_uid;
@@ -593,6 +595,7 @@ class gpgpu_t {
   unsigned resume_CTA;
   unsigned checkpoint_CTA_t;
   int checkpoint_insn_Y;
+  bool checkpoint_compress;
 
   // Move some cycle core stats here instead of being global
   unsigned long long gpu_sim_cycle;
@@ -1280,10 +1283,13 @@ size_t get_kernel_code_size(class function_info *entry);
 class checkpoint {
  public:
   checkpoint();
-  ~checkpoint() { printf("clasfsfss destructed\n"); }
+  ~checkpoint() {}
 
+  // memory spaces are checkpointed as binary page images (see mem_image);
+  // open_image() returns NULL, after reporting why, if fname cannot be used
+  class mem_image *open_image(const char *fname);
   void load_global_mem(class memory_space *temp_mem, char *f1name);
-  void store_global_mem(class memory_space *mem, char *fname, char *format);
+  void store_global_mem(class memory_space *mem, char *fname, bool compress);
   unsigned radnom;
 };
 /*
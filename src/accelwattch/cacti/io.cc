@@ -44,6 +44,7 @@
 #include "nuca.h"
 #include "crossbar.h"
 #include "arbiter.h"
+#include "solve_cache.h"
 //#include "highradix.h"
 
 using namespace std;
@@ -2296,7 +2297,11 @@ uca_org_t cacti_interface(InputParameter  * const local_interface)
   init_tech_params(g_ip->F_sz_um, false);
   Wire winit; // Do not delete this line. It initializes wires.
 
-  solve(&fin_res);
+  if (!solve_cache_lookup(g_ip, &fin_res))
+  {
+    solve(&fin_res);
+    solve_cache_insert(g_ip, fin_res);
+  }
 
 //  g_ip->display_ip();
 //  output_UCA(&fin_res);
@@ -0,0 +1,180 @@
+// Persistent cache of CACTI array solutions, see solve_cache.h.
+//
+// File layout: "CACTISOL", u32 version, u32 sizeof(uca_org_t),
+// u32 sizeof(mem_array), then entries of u32 key length, key bytes, u32
+// value length, value bytes. The key is the list of InputParameter fields;
+// the value is the uca_org_t followed by its tag and data mem_array (each
+// preceded by a presence byte). Files written by a build with a different
+// layout are ignored and rewritten.
+
+#include "solve_cache.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+
+#define SOLVE_CACHE_VERSION 1
+
+namespace {
+
+bool g_open = false;
+bool g_dirty = false;
+std::string g_path;
+std::map<std::string, std::string> g_solutions;
+
+template <class T>
+void append(std::string &s, const T &v) {
+  s.append((const char *)&v, sizeof(T));
+}
+
+// Fields are appended one by one so that struct padding does not end up
+// in the key.
+std::string make_key(const InputParameter *ip) {
+  std::string k;
+#define KEY(f) append(k, ip->f)
+  KEY(cache_sz); KEY(line_sz); KEY(assoc); KEY(nbanks); KEY(out_w);
+  KEY(specific_tag); KEY(tag_w); KEY(access_mode);
+  KEY(obj_func_dyn_energy); KEY(obj_func_dyn_power);
+  KEY(obj_func_leak_power); KEY(obj_func_cycle_t);
+  KEY(F_sz_nm); KEY(F_sz_um);
+  KEY(num_rw_ports); KEY(num_rd_ports); KEY(num_wr_ports);
+  KEY(num_se_rd_ports); KEY(num_search_ports);
+  KEY(is_main_mem); KEY(is_cache); KEY(pure_ram); KEY(pure_cam);
+  KEY(rpters_in_htree); KEY(ver_htree_wires_over_array);
+  KEY(broadcast_addr_din_over_ver_htrees); KEY(temp);
+  KEY(ram_cell_tech_type); KEY(peri_global_tech_type);
+  KEY(data_arr_ram_cell_tech_type); KEY(data_arr_peri_global_tech_type);
+  KEY(tag_arr_ram_cell_tech_type); KEY(tag_arr_peri_global_tech_type);
+  KEY(burst_len); KEY(int_prefetch_w); KEY(page_sz_bits);
+  KEY(ic_proj_type); KEY(wire_is_mat_type); KEY(wire_os_mat_type);
+  KEY(wt); KEY(force_wiretype); KEY(nuca_cache_sz);
+  KEY(ndbl); KEY(ndwl); KEY(nspd); KEY(ndsam1); KEY(ndsam2); KEY(ndcm);
+  KEY(force_cache_config);
+  KEY(cache_level); KEY(cores); KEY(nuca_bank_count); KEY(force_nuca_bank);
+  KEY(delay_wt); KEY(dynamic_power_wt); KEY(leakage_power_wt);
+  KEY(cycle_time_wt); KEY(area_wt);
+  KEY(delay_wt_nuca); KEY(dynamic_power_wt_nuca); KEY(leakage_power_wt_nuca);
+  KEY(cycle_time_wt_nuca); KEY(area_wt_nuca);
+  KEY(delay_dev); KEY(dynamic_power_dev); KEY(leakage_power_dev);
+  KEY(cycle_time_dev); KEY(area_dev);
+  KEY(delay_dev_nuca); KEY(dynamic_power_dev_nuca);
+  KEY(leakage_power_dev_nuca); KEY(cycle_time_dev_nuca); KEY(area_dev_nuca);
+  KEY(ed); KEY(nuca);
+  KEY(fast_access); KEY(block_sz); KEY(tag_assoc); KEY(data_assoc);
+  KEY(is_seq_acc); KEY(fully_assoc); KEY(nsets);
+  KEY(add_ecc_b_);
+  KEY(throughput); KEY(latency); KEY(pipelinable); KEY(pipeline_stages);
+  KEY(per_stage_vector); KEY(with_clock_grid);
+#undef KEY
+  return k;
+}
+
+void append_array(std::string &s, const mem_array *arr) {
+  s.push_back(arr != NULL);
+  if (arr) s.append((const char *)arr, sizeof(mem_array));
+}
+
+// Returns a copy of the array stored at s[pos], or NULL if there is none.
+mem_array *extract_array(const std::string &s, size_t &pos) {
+  if (!s[pos++]) return NULL;
+  mem_array *arr = new mem_array;
+  memcpy((void *)arr, s.data() + pos, sizeof(mem_array));
+  pos += sizeof(mem_array);
+  arr->arr_min = NULL;  // owned by solve() and freed there
+  return arr;
+}
+
+bool read_u32(FILE *f, unsigned &v) { return fread(&v, 4, 1, f) == 1; }
+
+bool read_string(FILE *f, std::string &s) {
+  unsigned len;
+  if (!read_u32(f, len)) return false;
+  s.resize(len);
+  return len == 0 || fread(&s[0], len, 1, f) == 1;
+}
+
+void write_u32(FILE *f, unsigned v) { fwrite(&v, 4, 1, f); }
+
+}  // namespace
+
+void solve_cache_open(const char *path) {
+  g_open = true;
+  g_dirty = false;
+  g_path = path;
+  g_solutions.clear();
+
+  FILE *f = fopen(path, "rb");
+  if (!f) return;
+  char magic[8];
+  unsigned version, uca_size, arr_size;
+  if (fread(magic, 8, 1, f) == 1 && !memcmp(magic, "CACTISOL", 8) &&
+      read_u32(f, version) && version == SOLVE_CACHE_VERSION &&
+      read_u32(f, uca_size) && uca_size == sizeof(uca_org_t) &&
+      read_u32(f, arr_size) && arr_size == sizeof(mem_array)) {
+    // a truncated file (e.g. written by a killed run) keeps its complete
+    // entries
+    std::string key, value;
+    while (read_string(f, key) && read_string(f, value))
+      g_solutions[key] = value;
+  }
+  fclose(f);
+}
+
+bool solve_cache_lookup(const InputParameter *ip, uca_org_t *fin_res) {
+  if (!g_open) return false;
+  std::map<std::string, std::string>::const_iterator s =
+      g_solutions.find(make_key(ip));
+  if (s == g_solutions.end()) return false;
+  const std::string &v = s->second;
+  memcpy((void *)fin_res, v.data(), sizeof(uca_org_t));
+  size_t pos = sizeof(uca_org_t);
+  fin_res->tag_array2 = extract_array(v, pos);
+  fin_res->data_array2 = extract_array(v, pos);
+  return true;
+}
+
+void solve_cache_insert(const InputParameter *ip, const uca_org_t &fin_res) {
+  if (!g_open) return;
+  std::string v((const char *)&fin_res, sizeof(uca_org_t));
+  append_array(v, fin_res.tag_array2);
+  append_array(v, fin_res.data_array2);
+  g_solutions[make_key(ip)] = v;
+  g_dirty = true;
+}
+
+void solve_cache_close() {
+  if (g_open && g_dirty) {
+    // concurrent runs with the same configuration may write the cache at
+    // the same time, so each writes a private file and renames it
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.%d", g_path.c_str(), (int)getpid());
+    FILE *f = fopen(tmp, "wb");
+    if (f) {
+      fwrite("CACTISOL", 8, 1, f);
+      write_u32(f, SOLVE_CACHE_VERSION);
+      write_u32(f, sizeof(uca_org_t));
+      write_u32(f, sizeof(mem_array));
+      for (std::map<std::string, std::string>::const_iterator s =
+               g_solutions.begin();
+           s != g_solutions.end(); ++s) {
+        write_u32(f, s->first.size());
+        fwrite(s->first.data(), s->first.size(), 1, f);
+        write_u32(f, s->second.size());
+        fwrite(s->second.data(), s->second.size(), 1, f);
+      }
+      bool ok = !ferror(f);
+      ok = fclose(f) == 0 && ok;
+      if (!ok || rename(tmp, g_path.c_str()) != 0) {
+        fprintf(stderr, "McPAT: cannot write array solution cache %s\n",
+                g_path.c_str());
+        remove(tmp);
+      }
+    } else {
+      fprintf(stderr, "McPAT: cannot write array solution cache %s\n",
+              g_path.c_str());
+    }
+  }
+  g_open = false;
+  g_solutions.clear();
+}
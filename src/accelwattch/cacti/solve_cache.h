@@ -0,0 +1,29 @@
+// Persistent cache of CACTI array solutions.
+//
+// McPAT sizes every array structure of the modelled processor by calling
+// cacti_interface(), whose solve() sweeps all array organizations and is by
+// far the most expensive part of building a Processor. The solution only
+// depends on the InputParameter of the call, so solutions found once are
+// stored in a cache file and reused by later runs with the same
+// configuration.
+
+#ifndef __SOLVE_CACHE_H__
+#define __SOLVE_CACHE_H__
+
+#include "cacti_interface.h"
+
+// Load the solutions stored in path (if the file exists and was written by
+// a compatible build) and start recording new ones.
+void solve_cache_open(const char *path);
+
+// Fill fin_res with the stored solution for ip. Returns false if there is
+// none or no cache is open.
+bool solve_cache_lookup(const InputParameter *ip, uca_org_t *fin_res);
+
+// Remember the solution solve() found for ip.
+void solve_cache_insert(const InputParameter *ip, const uca_org_t &fin_res);
+
+// Write the cache file back if new solutions were recorded and stop caching.
+void solve_cache_close();
+
+#endif
@@ -29,6 +29,7 @@
 
 #include "gpgpu_sim_wrapper.h"
 #include <sys/stat.h>
+#include "cacti/solve_cache.h"
 #define SP_BASE_POWER 0
 #define SFU_BASE_POWER 0
 
@@ -76,8 +77,25 @@ enum pwr_cmp_t {
   NUM_COMPONENTS_MODELLED
 };
 
+// Start caching CACTI array solutions in cache_dir. The cache file is named
+// after a hash of the XML contents, which include the technology node.
+static void open_solve_cache(const char* cache_dir, const char* xmlfile) {
+  FILE* f = fopen(xmlfile, "rb");
+  if (!f) return;
+  unsigned long long hash = 14695981039346656037ULL;  // FNV-1a
+  int c;
+  while ((c = getc(f)) != EOF) hash = (hash ^ c) * 1099511628211ULL;
+  fclose(f);
+  mkdir(cache_dir, 0777);
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/accelwattch-%016llx.cache", cache_dir,
+           hash);
+  solve_cache_open(path);
+}
+
 gpgpu_sim_wrapper::gpgpu_sim_wrapper(bool power_simulation_enabled,
-                                     char* xmlfile, int power_simulation_mode, bool dvfs_enabled) {
+                                     char* xmlfile, int power_simulation_mode,
+                                     bool dvfs_enabled, char* cache_dir) {
   kernel_sample_count = 0;
   total_sample_count = 0;
 
@@ -120,10 +138,14 @@ gpgpu_sim_wrapper::gpgpu_sim_wrapper(bool power_simulation_enabled,
 
   gpu_stat_sample_freq = 0;
   p = new ParseXML();
+  bool cache = false;
   if (g_power_simulation_enabled) {
     p->parse(xml_filename);
+    cache = cache_dir && *cache_dir;
+    if (cache) open_solve_cache(cache_dir, xml_filename);
   }
   proc = new Processor(p);
+  if (cache) solve_cache_close();
   power_trace_file = NULL;
   metric_trace_file = NULL;
   steady_state_tacking_file = NULL;
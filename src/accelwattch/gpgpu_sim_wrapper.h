@@ -82,7 +82,11 @@ struct PowerscalingCoefficients{
 
 class gpgpu_sim_wrapper {
  public:
-  gpgpu_sim_wrapper(bool power_simulation_enabled, char* xmlfile, int power_simulation_mode, bool dvfs_enabled);
+  // cache_dir (may be NULL or empty) holds the persistent cache of CACTI
+  // array solutions, see cacti/solve_cache.h
+  gpgpu_sim_wrapper(bool power_simulation_enabled, char* xmlfile,
+                    int power_simulation_mode, bool dvfs_enabled,
+                    char* cache_dir);
   ~gpgpu_sim_wrapper();
 
   void init_mcpat(char* xmlfile, char* powerfile, char* power_trace_file,
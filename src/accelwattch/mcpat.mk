@@ -69,6 +69,7 @@ SRCS  = \
   processor.cc \
   router.cc \
   sharedcache.cc \
+  solve_cache.cc \
   subarray.cc \
   technology.cc \
   uca.cc \
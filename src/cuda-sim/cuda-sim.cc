@@ -1992,16 +1992,7 @@ void ptx_thread_info::ptx_exec_inst(warp_inst_t &inst, unsigned lane_id) {
                         [m_gpu->gpgpu_ctx->func_sim->g_ptx_kernel_count],
                     (int)pI->get_opcode());
     }
-    if ((m_gpu->gpgpu_ctx->func_sim->g_ptx_sim_num_insn % 100000) == 0) {
-      dim3 ctaid = get_ctaid();
-      dim3 tid = get_tid();
-      DPRINTF(LIVENESS,
-              "GPGPU-Sim PTX: %u instructions simulated : ctaid=(%u,%u,%u) "
-              "tid=(%u,%u,%u)\n",
-              m_gpu->gpgpu_ctx->func_sim->g_ptx_sim_num_insn, ctaid.x, ctaid.y,
-              ctaid.z, tid.x, tid.y, tid.z);
-      fflush(stdout);
-    }
+    report_liveness();
 
     // "Return values"
     if (!skip) {
@@ -2021,6 +2012,582 @@ void ptx_thread_info::ptx_exec_inst(warp_inst_t &inst, unsigned lane_id) {
   }
 }
 
+void ptx_thread_info::report_liveness() {
+  if ((m_gpu->gpgpu_ctx->func_sim->g_ptx_sim_num_insn % 100000) == 0) {
+    dim3 ctaid = get_ctaid();
+    dim3 tid = get_tid();
+    DPRINTF(LIVENESS,
+            "GPGPU-Sim PTX: %u instructions simulated : ctaid=(%u,%u,%u) "
+            "tid=(%u,%u,%u)\n",
+            m_gpu->gpgpu_ctx->func_sim->g_ptx_sim_num_insn, ctaid.x, ctaid.y,
+            ctaid.z, tid.x, tid.y, tid.z);
+    fflush(stdout);
+  }
+}
+
+// Operations handled by ptx_thread_info::ptx_exec_warp_inst(). Each one
+// produces exactly the 64-bit register value the corresponding *_impl()
+// function would write for a plain register destination. These are the
+// integer instructions whose result depends only on their source values;
+// anything with a carry/overflow output, a floating point type (the
+// rounding mode is host state), or a memory, texture, call or control flow
+// effect stays on the per-thread path.
+enum warp_alu_op_t {
+  WARP_ALU_MOV,
+  WARP_ALU_ADD32,
+  WARP_ALU_ADD64,
+  WARP_ALU_SUB32,
+  WARP_ALU_SUB64,
+  WARP_ALU_AND,
+  WARP_ALU_OR,
+  WARP_ALU_XOR,
+  WARP_ALU_SETP,
+  WARP_ALU_CVT,
+  WARP_ALU_MUL,
+  WARP_ALU_MAD,
+  WARP_ALU_SHL,
+  WARP_ALU_SHR,
+  WARP_ALU_MIN,
+  WARP_ALU_MAX
+};
+
+// shared with setp_impl() and cvt_impl() (instructions.cc)
+bool CmpOp(int type, ptx_reg_t a, ptx_reg_t b, unsigned cmpop);
+extern ptx_reg_t (*g_cvt_fn[11][11])(ptx_reg_t x, unsigned from_width,
+                                     unsigned to_width, int to_sign,
+                                     int rounding_mode, int saturation_mode);
+
+// Signed/unsigned integer types (the integer formats of g_cvt_fn).
+static bool warp_alu_int_type(unsigned type) {
+  switch (type) {
+    case S8_TYPE:
+    case S16_TYPE:
+    case S32_TYPE:
+    case S64_TYPE:
+    case U8_TYPE:
+    case U16_TYPE:
+    case U32_TYPE:
+    case U64_TYPE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The integer types mul_impl(), mad_def(), min_impl() and max_impl() handle.
+static bool warp_alu_mul_type(unsigned type) {
+  return type == S16_TYPE || type == S32_TYPE || type == S64_TYPE ||
+         type == U16_TYPE || type == U32_TYPE || type == U64_TYPE;
+}
+
+// mul and mad: .lo, .hi or .wide for 16/32-bit types, .lo for 64-bit ones
+// (the others assert or are not implemented by the per-thread path).
+static bool warp_alu_mul_mode(const ptx_instruction *pI, unsigned type) {
+  if (type == S64_TYPE || type == U64_TYPE)
+    return pI->is_lo() && !pI->is_hi() && !pI->is_wide();
+  return pI->is_lo() || pI->is_hi() || pI->is_wide();
+}
+
+// Register, literal and builtin operands are read without side effects.
+static bool warp_alu_simple_operand(const operand_info &op) {
+  if (op.is_vector() || op.is_memory_operand() ||
+      op.get_addr_space() != undefined_space ||
+      op.get_double_operand_type() != 0 || op.get_operand_lohi() != 0)
+    return false;
+  return op.is_reg() || op.is_literal() || op.is_builtin();
+}
+
+static bool warp_alu_decode(const ptx_instruction *pI, warp_alu_op_t &op) {
+  if (pI->is_exit() || pI->has_memory_read() || pI->has_memory_write())
+    return false;
+
+  unsigned type = pI->get_type();
+  bool int32 = (type == S32_TYPE || type == U32_TYPE);
+  bool int64 = (type == S64_TYPE || type == U64_TYPE);
+  switch (pI->get_opcode()) {
+    case MOV_OP:
+      op = WARP_ALU_MOV;
+      break;
+    case ADD_OP:
+      if (pI->rounding_mode() != RN_OPTION || !(int32 || int64)) return false;
+      op = int32 ? WARP_ALU_ADD32 : WARP_ALU_ADD64;
+      break;
+    case SUB_OP:
+      int32 = int32 || type == B32_TYPE;
+      int64 = int64 || type == B64_TYPE;
+      if (!(int32 || int64)) return false;
+      op = int32 ? WARP_ALU_SUB32 : WARP_ALU_SUB64;
+      break;
+    case AND_OP:
+      op = WARP_ALU_AND;
+      break;
+    case OR_OP:
+      op = WARP_ALU_OR;
+      break;
+    case XOR_OP:
+      op = WARP_ALU_XOR;
+      break;
+    case SETP_OP:
+      // integer compares writing a single predicate, no boolOp/c operand
+      if (!(warp_alu_int_type(type) || type == B16_TYPE ||
+            type == B32_TYPE || type == B64_TYPE) ||
+          pI->get_num_operands() != 3)
+        return false;
+      op = WARP_ALU_SETP;
+      break;
+    case CVT_OP:
+      // int-to-int only, no saturation, rounding or negation
+      if (!warp_alu_int_type(type) || !warp_alu_int_type(pI->get_type2()) ||
+          pI->rounding_mode() != RN_OPTION || pI->saturation_mode() ||
+          pI->is_neg())
+        return false;
+      op = WARP_ALU_CVT;
+      break;
+    case MUL_OP:
+      if (!warp_alu_mul_type(type) || !warp_alu_mul_mode(pI, type))
+        return false;
+      op = WARP_ALU_MUL;
+      break;
+    case MAD_OP:
+      if (!warp_alu_mul_type(type) || !warp_alu_mul_mode(pI, type) ||
+          pI->get_num_operands() != 4)
+        return false;
+      op = WARP_ALU_MAD;
+      break;
+    case SHL_OP:
+      if (!(type == B16_TYPE || type == U16_TYPE || type == B32_TYPE ||
+            type == U32_TYPE || type == B64_TYPE || type == U64_TYPE))
+        return false;
+      op = WARP_ALU_SHL;
+      break;
+    case SHR_OP:
+      if (!(type == B16_TYPE || type == B32_TYPE || type == B64_TYPE ||
+            warp_alu_mul_type(type)))
+        return false;
+      op = WARP_ALU_SHR;
+      break;
+    case MIN_OP:
+    case MAX_OP:
+      if (!warp_alu_mul_type(type)) return false;
+      op = pI->get_opcode() == MIN_OP ? WARP_ALU_MIN : WARP_ALU_MAX;
+      break;
+    default:
+      return false;
+  }
+  // predicates, pack/unpack and ptxplus register pairs have special semantics
+  if (type == PRED_TYPE || type == BB64_TYPE || type == BB128_TYPE ||
+      type == FF64_TYPE)
+    return false;
+
+  const operand_info &dst = pI->dst();
+  if (!dst.is_reg() || dst.is_vector() ||
+      dst.get_addr_space() != undefined_space ||
+      dst.get_double_operand_type() != 0 || dst.get_operand_lohi() != 0)
+    return false;
+  if (!warp_alu_simple_operand(pI->src1())) return false;
+  if (op != WARP_ALU_MOV && op != WARP_ALU_CVT &&
+      !warp_alu_simple_operand(pI->src2()))
+    return false;
+  if (op == WARP_ALU_MAD && !warp_alu_simple_operand(pI->src3()))
+    return false;
+  return true;
+}
+
+// The integer cases of mul_impl() and mad_def() (without carry in), written
+// through the same union members so the upper register bits match.
+static unsigned long long warp_alu_mad(unsigned type, bool wide, bool hi,
+                                       bool mad, ptx_reg_t a, ptx_reg_t b,
+                                       ptx_reg_t c) {
+  ptx_reg_t d, t;
+  switch (type) {
+    case S16_TYPE:
+      if (mad) {
+        t.s32 = a.s16 * b.s16;
+        if (wide)
+          d.s32 = t.s32 + c.s32;
+        else if (hi)
+          d.s16 = (t.s32 >> 16) + c.s16;
+        else
+          d.s16 = t.s16 + c.s16;
+      } else {
+        t.s32 = ((int)a.s16) * ((int)b.s16);
+        if (wide)
+          d.s32 = t.s32;
+        else if (hi)
+          d.s16 = (t.s32 >> 16);
+        else
+          d.s16 = t.s16;
+      }
+      break;
+    case S32_TYPE:
+      if (mad) {
+        t.s64 = a.s32 * b.s32;
+        if (wide)
+          d.s64 = t.s64 + c.s64;
+        else if (hi)
+          d.s32 = (t.s64 >> 32) + c.s32;
+        else
+          d.s32 = t.s32 + c.s32;
+      } else {
+        t.s64 = ((long long)a.s32) * ((long long)b.s32);
+        if (wide)
+          d.s64 = t.s64;
+        else if (hi)
+          d.s32 = (t.s64 >> 32);
+        else
+          d.s32 = t.s32;
+      }
+      break;
+    case S64_TYPE:
+      d.s64 = a.s64 * b.s64 + (mad ? c.s64 : 0);
+      break;
+    case U16_TYPE:
+      if (mad) {
+        t.u32 = a.u16 * b.u16;
+        if (wide)
+          d.u32 = t.u32 + c.u32;
+        else if (hi)
+          d.u16 = (t.u32 + c.u16) >> 16;
+        else
+          d.u16 = t.u16 + c.u16;
+      } else {
+        t.u32 = ((unsigned)a.u16) * ((unsigned)b.u16);
+        if (wide)
+          d.u32 = t.u32;
+        else if (hi)
+          d.u16 = (t.u32 >> 16);
+        else
+          d.u16 = t.u16;
+      }
+      break;
+    case U32_TYPE:
+      if (mad) {
+        t.u64 = a.u32 * b.u32;
+        if (wide)
+          d.u64 = t.u64 + c.u64;
+        else if (hi)
+          d.u32 = (t.u64 + c.u32) >> 32;
+        else
+          d.u32 = t.u32 + c.u32;
+      } else {
+        t.u64 = ((unsigned long long)a.u32) * ((unsigned long long)b.u32);
+        if (wide)
+          d.u64 = t.u64;
+        else if (hi)
+          d.u32 = (t.u64 >> 32);
+        else
+          d.u32 = t.u32;
+      }
+      break;
+    case U64_TYPE:
+      d.u64 = a.u64 * b.u64 + (mad ? c.u64 : 0);
+      break;
+  }
+  return d.u64;
+}
+
+// shl_impl() and shr_impl()
+static unsigned long long warp_alu_shift(unsigned type, bool left,
+                                         ptx_reg_t a, ptx_reg_t b) {
+  ptx_reg_t d;
+  switch (type) {
+    case B16_TYPE:
+    case U16_TYPE:
+      if (b.u16 >= 16)
+        d.u16 = 0;
+      else if (left)
+        d.u16 = (unsigned short)((a.u16 << b.u16) & 0xFFFF);
+      else
+        d.u16 = (unsigned short)((a.u16 >> b.u16) & 0xFFFF);
+      break;
+    case B32_TYPE:
+    case U32_TYPE:
+      if (b.u32 >= 32)
+        d.u32 = 0;
+      else if (left)
+        d.u32 = (unsigned)((a.u32 << b.u32) & 0xFFFFFFFF);
+      else
+        d.u32 = (unsigned)((a.u32 >> b.u32) & 0xFFFFFFFF);
+      break;
+    case B64_TYPE:
+    case U64_TYPE:
+      if (b.u32 >= 64)
+        d.u64 = 0;
+      else if (left)
+        d.u64 = (a.u64 << b.u64);
+      else
+        d.u64 = (a.u64 >> b.u64);
+      break;
+    case S16_TYPE:
+      if (b.u16 < 16)
+        d.s64 = (a.s16 >> b.s16);
+      else
+        d.s64 = a.s16 < 0 ? -1 : 0;
+      break;
+    case S32_TYPE:
+      if (b.u32 < 32)
+        d.s64 = (a.s32 >> b.s32);
+      else
+        d.s64 = a.s32 < 0 ? -1 : 0;
+      break;
+    case S64_TYPE:
+      if (b.u64 < 64) {
+        d.s64 = (a.s64 >> b.u64);
+      } else if (a.s64 < 0) {
+        if (b.s32 < 0) {
+          d.u64 = -1;
+          d.s32 = 0;
+        } else {
+          d.s64 = -1;
+        }
+      } else {
+        d.s64 = 0;
+      }
+      break;
+  }
+  return d.u64;
+}
+
+// min_impl() and max_impl()
+static unsigned long long warp_alu_minmax(unsigned type, bool min,
+                                          ptx_reg_t a, ptx_reg_t b) {
+  ptx_reg_t d;
+  switch (type) {
+    case U16_TYPE:
+      d.u16 = (a.u16 < b.u16) == min ? a.u16 : b.u16;
+      break;
+    case U32_TYPE:
+      d.u32 = (a.u32 < b.u32) == min ? a.u32 : b.u32;
+      break;
+    case U64_TYPE:
+      d.u64 = (a.u64 < b.u64) == min ? a.u64 : b.u64;
+      break;
+    case S16_TYPE:
+      d.s16 = (a.s16 < b.s16) == min ? a.s16 : b.s16;
+      break;
+    case S32_TYPE:
+      d.s32 = (a.s32 < b.s32) == min ? a.s32 : b.s32;
+      break;
+    case S64_TYPE:
+      d.s64 = (a.s64 < b.s64) == min ? a.s64 : b.s64;
+      break;
+  }
+  return d.u64;
+}
+
+// Gather one source operand of every executing lane into a flat array.
+static void warp_alu_gather(const operand_info &src, const operand_info &dst,
+                            unsigned type, ptx_thread_info *const *lanes,
+                            unsigned n, unsigned long long *values) {
+  if (src.is_literal()) {
+    unsigned long long v =
+        lanes[0]->get_operand_value(src, dst, type, lanes[0], 1).u64;
+    for (unsigned i = 0; i < n; i++) values[i] = v;
+  } else if (src.is_reg() && !src.get_operand_neg()) {
+    const symbol *reg = src.get_symbol();
+    for (unsigned i = 0; i < n; i++) values[i] = lanes[i]->get_reg(reg).u64;
+  } else {
+    for (unsigned i = 0; i < n; i++)
+      values[i] = lanes[i]->get_operand_value(src, dst, type, lanes[i], 1).u64;
+  }
+}
+
+bool ptx_thread_info::ptx_exec_warp_inst(core_t *core, warp_inst_t &inst,
+                                         unsigned warpId) {
+  unsigned warp_size = core->get_warp_size();
+  unsigned t = 0;
+  while (t < warp_size && !inst.active(t)) t++;
+  if (t == warp_size) return false;
+  if (warpId == (unsigned)-1) warpId = inst.warp_id();
+  ptx_thread_info **threads = core->get_thread_info() + warp_size * warpId;
+
+  // anything that traces or classifies individual thread instructions needs
+  // the full per-thread path
+  ptx_thread_info *first = threads[t];
+  cuda_sim *func_sim = first->m_gpu->gpgpu_ctx->func_sim;
+  if (g_debug_execution >= 5 ||
+      first->m_gpu->get_config().get_ptx_inst_debug_to_file() ||
+      func_sim->gpgpu_ptx_instruction_classification)
+    return false;
+
+  const ptx_instruction *pI = first->m_func_info->get_instruction(inst.pc);
+  warp_alu_op_t op;
+  if (!warp_alu_decode(pI, op)) return false;
+
+  // Pass 1: per-lane instruction fetch and predicate evaluation. Lanes that
+  // execute are packed densely so the value arrays below are contiguous.
+  unsigned lane_ids[MAX_WARP_SIZE];
+  bool lane_skip[MAX_WARP_SIZE];
+  ptx_thread_info *exec_lanes[MAX_WARP_SIZE];
+  unsigned n_lanes = 0, n_exec = 0;
+  for (; t < warp_size; t++) {
+    if (!inst.active(t)) continue;
+    ptx_thread_info *thread = threads[t];
+    addr_t pc = thread->next_instr();
+    assert(pc == inst.pc);
+    thread->set_npc(pc + pI->inst_size());
+    thread->clearRPC();
+    thread->m_last_set_operand_value.u64 = 0;
+    if (thread->is_done()) {
+      printf(
+          "attempted to execute instruction on a thread that is already "
+          "done.\n");
+      assert(0);
+    }
+
+    bool skip = false;
+    if (pI->has_pred()) {
+      const operand_info &pred = pI->get_pred();
+      ptx_reg_t pred_value =
+          thread->get_operand_value(pred, pred, PRED_TYPE, thread, 0);
+      if (pI->get_pred_mod() == -1) {
+        skip = (pred_value.pred & 0x0001) ^ pI->get_pred_neg();
+      } else {
+        skip = !pred_lookup(pI->get_pred_mod(), pred_value.pred & 0x000F);
+      }
+    }
+    lane_ids[n_lanes] = t;
+    lane_skip[n_lanes] = skip;
+    n_lanes++;
+    if (!skip) exec_lanes[n_exec++] = thread;
+  }
+
+  // Pass 2: gather sources, compute for all executing lanes with the
+  // opcode/type dispatch hoisted out of the lane loop.
+  const operand_info &dst = pI->dst();
+  unsigned type = pI->get_type();
+  // cvt reads its source as the second (from) type
+  unsigned src_type = op == WARP_ALU_CVT ? pI->get_type2() : type;
+  unsigned long long a[MAX_WARP_SIZE], b[MAX_WARP_SIZE], c[MAX_WARP_SIZE];
+  unsigned long long d[MAX_WARP_SIZE];
+  if (n_exec) {
+    warp_alu_gather(pI->src1(), dst, src_type, exec_lanes, n_exec, a);
+    if (op != WARP_ALU_MOV && op != WARP_ALU_CVT)
+      warp_alu_gather(pI->src2(), dst, type, exec_lanes, n_exec, b);
+    if (op == WARP_ALU_MAD)
+      warp_alu_gather(pI->src3(), dst, type, exec_lanes, n_exec, c);
+  }
+  const unsigned long long lo32 = 0xFFFFFFFFULL;
+  switch (op) {
+    case WARP_ALU_MOV:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i];
+      break;
+    case WARP_ALU_ADD32:
+      for (unsigned i = 0; i < n_exec; i++)
+        d[i] = (a[i] & lo32) + (b[i] & lo32);
+      break;
+    case WARP_ALU_ADD64:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i] + b[i];
+      break;
+    case WARP_ALU_SUB32:
+      // the constant keeps the borrow in bit 32, as in sub_impl()
+      for (unsigned i = 0; i < n_exec; i++)
+        d[i] = (a[i] & lo32) - (b[i] & lo32) + 0x100000000ULL;
+      break;
+    case WARP_ALU_SUB64:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i] - b[i];
+      break;
+    case WARP_ALU_AND:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i] & b[i];
+      break;
+    case WARP_ALU_OR:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i] | b[i];
+      break;
+    case WARP_ALU_XOR:
+      for (unsigned i = 0; i < n_exec; i++) d[i] = a[i] ^ b[i];
+      break;
+    case WARP_ALU_SETP: {
+      unsigned cmpop = pI->get_cmpop();
+      for (unsigned i = 0; i < n_exec; i++) {
+        ptx_reg_t ra, rb, r;
+        ra.u64 = a[i];
+        rb.u64 = b[i];
+        // inverted as in setp_impl(), ptxplus uses 1 for a set zero flag
+        r.pred = (CmpOp(type, ra, rb, cmpop) == 0);
+        d[i] = r.u64;
+      }
+      break;
+    }
+    case WARP_ALU_CVT: {
+      size_t from_width, to_width;
+      int from_sign, to_sign;
+      unsigned src_fmt =
+          type_info_key::type_decode(src_type, from_width, from_sign);
+      unsigned dst_fmt = type_info_key::type_decode(type, to_width, to_sign);
+      ptx_reg_t (*fn)(ptx_reg_t, unsigned, unsigned, int, int, int) =
+          g_cvt_fn[src_fmt][dst_fmt];
+      for (unsigned i = 0; i < n_exec; i++) {
+        ptx_reg_t x;
+        x.u64 = a[i];
+        if (fn) x = fn(x, from_width, to_width, to_sign, RN_OPTION, 0);
+        d[i] = x.u64;
+      }
+      break;
+    }
+    case WARP_ALU_MUL:
+    case WARP_ALU_MAD: {
+      bool wide = pI->is_wide(), hi = pI->is_hi();
+      bool mad = op == WARP_ALU_MAD;
+      for (unsigned i = 0; i < n_exec; i++) {
+        ptx_reg_t ra, rb, rc;
+        ra.u64 = a[i];
+        rb.u64 = b[i];
+        if (mad) rc.u64 = c[i];
+        d[i] = warp_alu_mad(type, wide, hi, mad, ra, rb, rc);
+      }
+      break;
+    }
+    case WARP_ALU_SHL:
+    case WARP_ALU_SHR:
+      for (unsigned i = 0; i < n_exec; i++) {
+        ptx_reg_t ra, rb;
+        ra.u64 = a[i];
+        rb.u64 = b[i];
+        d[i] = warp_alu_shift(type, op == WARP_ALU_SHL, ra, rb);
+      }
+      break;
+    case WARP_ALU_MIN:
+    case WARP_ALU_MAX:
+      for (unsigned i = 0; i < n_exec; i++) {
+        ptx_reg_t ra, rb;
+        ra.u64 = a[i];
+        rb.u64 = b[i];
+        d[i] = warp_alu_minmax(type, op == WARP_ALU_MIN, ra, rb);
+      }
+      break;
+  }
+
+  // Pass 3: write back and retire lane by lane, in the same order as the
+  // per-thread path so the timing model observes identical updates.
+  const symbol *dst_reg = dst.get_symbol();
+  for (unsigned i = 0, e = 0; i < n_lanes; i++) {
+    unsigned lane_id = lane_ids[i];
+    ptx_thread_info *thread = threads[lane_id];
+    if (lane_skip[i]) {
+      inst.set_not_active(lane_id);
+    } else {
+      ptx_reg_t data;
+      data.u64 = d[e++];
+      thread->set_reg(dst_reg, data);
+    }
+    thread->update_pc();
+    func_sim->g_ptx_sim_num_insn++;
+    if (!thread->m_functionalSimulationMode)
+      ptx_file_line_stats_add_exec_count(pI);
+    thread->report_liveness();
+    if (!lane_skip[i]) {
+      inst.space = undefined_space;
+      inst.set_addr(lane_id, 0xFEEBDAED);
+      inst.data_size = 0;
+      assert(inst.memory_op == no_memory_op);
+    }
+
+    core->checkExecutionStatusAndUpdate(inst, lane_id,
+                                        warp_size * warpId + lane_id);
+  }
+  return true;
+}
+
 void cuda_sim::set_param_gpgpu_num_shaders(int num_shaders) {
   gpgpu_param_num_shaders = num_shaders;
 }
@@ -2522,11 +3089,11 @@ void cuda_sim::gpgpu_cuda_ptx_sim_main_func(kernel_info_t &kernel,
 
   if (cp_op == 1) {
     char f1name[2048];
-    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.txt",
+    snprintf(f1name, 2048, "checkpoint_files/global_mem_%d.bin",
              kernel.get_uid());
     g_checkpoint->store_global_mem(
         gpgpu_ctx->the_gpgpusim->g_the_gpu->get_global_memory(), f1name,
-        (char *)"%08x");
+        gpgpu_ctx->the_gpgpusim->g_the_gpu->checkpoint_compress);
   }
 
   // registering this kernel as done
@@ -2658,9 +3225,6 @@ void functionalCoreSim::execute(int inst_count, unsigned ctaid_cp) {
     }
   }
 
-  checkpoint *g_checkpoint;
-  g_checkpoint = new checkpoint();
-
   ptx_reg_t regval;
   regval.u64 = 123;
 
@@ -2669,20 +3233,22 @@ void functionalCoreSim::execute(int inst_count, unsigned ctaid_cp) {
       (m_kernel->get_uid() == m_gpu->checkpoint_kernel) &&
       (ctaid_cp >= m_gpu->checkpoint_CTA) &&
       (ctaid_cp < m_gpu->checkpoint_CTA_t)) {
+    // only built when checkpointing, the constructor creates the directory
+    checkpoint g_checkpoint;
     char fname[2048];
-    snprintf(fname, 2048, "checkpoint_files/shared_mem_%d.txt", ctaid - 1);
-    g_checkpoint->store_global_mem(m_thread[0]->m_shared_mem, fname,
-                                   (char *)"%08x");
+    snprintf(fname, 2048, "checkpoint_files/shared_mem_%d.bin", ctaid - 1);
+    g_checkpoint.store_global_mem(m_thread[0]->m_shared_mem, fname,
+                                   m_gpu->checkpoint_compress);
     for (int i = 0; i < 32 * m_warp_count; i++) {
       char fname[2048];
       snprintf(fname, 2048, "checkpoint_files/thread_%d_%d_reg.txt", i,
                ctaid - 1);
       m_thread[i]->print_reg_thread(fname);
       char f1name[2048];
-      snprintf(f1name, 2048, "checkpoint_files/local_mem_thread_%d_%d_reg.txt",
+      snprintf(f1name, 2048, "checkpoint_files/local_mem_thread_%d_%d.bin",
                i, ctaid - 1);
-      g_checkpoint->store_global_mem(m_thread[i]->m_local_mem, f1name,
-                                     (char *)"%08x");
+      g_checkpoint.store_global_mem(m_thread[i]->m_local_mem, f1name,
+                                     m_gpu->checkpoint_compress);
       m_thread[i]->set_done();
       m_thread[i]->exitCore();
       m_thread[i]->registerExit();
@@ -175,12 +175,65 @@ void video_mem_instruction(const ptx_instruction *pI, ptx_thread_info *thread,
 
 void sign_extend(ptx_reg_t &data, unsigned src_size, const operand_info &dst);
 
+ptx_reg_t *reg_file_t::find(const symbol *reg) {
+  const symbol_table *scope = reg->reg_scope();
+  if (scope != NULL && scope == m_scope) {
+    unsigned slot = reg->reg_num();
+    if (slot < m_defined.size() && m_defined[slot] != NULL)
+      return &m_value[slot];
+    return NULL;
+  }
+  if (m_other.empty()) return NULL;
+  reg_map_t::iterator r = m_other.find(reg);
+  return (r == m_other.end()) ? NULL : &r->second;
+}
+
+void reg_file_t::set(const symbol *reg, const ptx_reg_t &value) {
+  const symbol_table *scope = reg->reg_scope();
+  if (scope != NULL) {
+    if (m_scope == NULL) m_scope = scope;
+    if (scope == m_scope) {
+      unsigned slot = reg->reg_num();
+      if (slot >= m_defined.size()) {
+        m_value.resize(slot + 1);
+        m_defined.resize(slot + 1, NULL);
+      }
+      m_value[slot] = value;
+      if (m_defined[slot] == NULL) {
+        m_defined[slot] = reg;
+        m_n_defined++;
+      }
+      return;
+    }
+  }
+  m_other[reg] = value;
+}
+
+void reg_file_t::clear() {
+  m_scope = NULL;
+  if (m_n_defined)
+    std::fill(m_defined.begin(), m_defined.end(), (const symbol *)NULL);
+  m_n_defined = 0;
+  m_other.clear();
+}
+
+void reg_file_t::get_all(
+    std::vector<std::pair<const symbol *, ptx_reg_t> > &regs) const {
+  for (unsigned slot = 0; slot < m_defined.size(); slot++) {
+    if (m_defined[slot])
+      regs.push_back(std::make_pair(m_defined[slot], m_value[slot]));
+  }
+  reg_map_t::const_iterator r;
+  for (r = m_other.begin(); r != m_other.end(); ++r)
+    regs.push_back(std::make_pair(r->first, r->second));
+}
+
 void ptx_thread_info::set_reg(const symbol *reg, const ptx_reg_t &value) {
   assert(reg != NULL);
   if (reg->name() == "_") return;
-  assert(!m_regs.empty());
+  assert(m_reg_depth > 0);
   assert(reg->uid() > 0);
-  m_regs.back()[reg] = value;
+  cur_regs().set(reg, value);
   if (m_enable_debug_trace) m_debug_trace_regs_modified.back()[reg] = value;
   m_last_set_operand_value = value;
 }
@@ -189,12 +242,11 @@ void ptx_thread_info::print_reg_thread(char *fname) {
   FILE *fp = fopen(fname, "w");
   assert(fp != NULL);
 
-  int size = m_regs.size();
-
-  if (size > 0) {
-    reg_map_t reg = m_regs.back();
+  if (m_reg_depth > 0) {
+    std::vector<std::pair<const symbol *, ptx_reg_t> > reg;
+    cur_regs().get_all(reg);
 
-    reg_map_t::const_iterator it;
+    std::vector<std::pair<const symbol *, ptx_reg_t> >::const_iterator it;
     for (it = reg.begin(); it != reg.end(); ++it) {
       const std::string &name = it->first->name();
       const std::string &dec = it->first->decl_location();
@@ -202,7 +254,6 @@ void ptx_thread_info::print_reg_thread(char *fname) {
       fprintf(fp, "%s %llu %s %d\n", name.c_str(), it->second, dec.c_str(),
               size);
     }
-    // m_regs.pop_back();
   }
   fclose(fp);
 }
@@ -223,7 +274,7 @@ void ptx_thread_info::resume_reg_thread(char *fname, symbol_table *symtab) {
     data = atoi(pch);
     pch = strtok(NULL, " ");
     pch = strtok(NULL, " ");
-    m_regs.back()[reg] = data;
+    cur_regs().set(reg, data);
   }
   fclose(fp2);
 }
@@ -231,9 +282,9 @@ void ptx_thread_info::resume_reg_thread(char *fname, symbol_table *symtab) {
 ptx_reg_t ptx_thread_info::get_reg(const symbol *reg) {
   static bool unfound_register_warned = false;
   assert(reg != NULL);
-  assert(!m_regs.empty());
-  reg_map_t::iterator regs_iter = m_regs.back().find(reg);
-  if (regs_iter == m_regs.back().end()) {
+  assert(m_reg_depth > 0);
+  ptx_reg_t *value = cur_regs().find(reg);
+  if (value == NULL) {
     assert(reg->type()->get_key().is_reg());
     const std::string &name = reg->name();
     unsigned call_uid = m_callstack.back().m_call_uid;
@@ -251,11 +302,10 @@ ptx_reg_t ptx_thread_info::get_reg(const symbol *reg) {
           file_loc.c_str(), name.c_str(), call_uid);
       unfound_register_warned = true;
     }
-    regs_iter = m_regs.back().find(reg);
+    value = cur_regs().find(reg);
   }
-  if (m_enable_debug_trace)
-    m_debug_trace_regs_read.back()[reg] = regs_iter->second;
-  return regs_iter->second;
+  if (m_enable_debug_trace) m_debug_trace_regs_read.back()[reg] = *value;
+  return *value;
 }
 
 ptx_reg_t ptx_thread_info::get_operand_value(const operand_info &op,
@@ -535,9 +585,9 @@ void ptx_thread_info::get_vector_operand_values(const operand_info &op,
     const symbol *sym = NULL;
     sym = op.vec_symbol(idx);
     if (strcmp(sym->name().c_str(), "_") != 0) {
-      reg_map_t::iterator reg_iter = m_regs.back().find(sym);
-      assert(reg_iter != m_regs.back().end());
-      ptx_regs[idx] = reg_iter->second;
+      ptx_reg_t *value = cur_regs().find(sym);
+      assert(value != NULL);
+      ptx_regs[idx] = *value;
     }
   }
 }
@@ -572,7 +622,7 @@ void ptx_thread_info::set_operand_value(const operand_info &dst,
     ptx_reg_t predValue;
 
     const symbol *sym = dst.vec_symbol(0);
-    predValue.u64 = (m_regs.back()[sym].u64) & ~(0x0C);
+    predValue.u64 = (cur_regs().get(sym).u64) & ~(0x0C);
     predValue.u64 |= ((overflow & 0x01) << 3);
     predValue.u64 |= ((carry & 0x01) << 2);
 
@@ -685,9 +735,9 @@ void ptx_thread_info::set_operand_value(const operand_info &dst,
 
       if (dst.get_operand_lohi() == 1) {
         setValue.u64 =
-            ((m_regs.back()[regName].u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
+            ((cur_regs().get(regName).u64) & (~(0xFFFF))) + (data.u64 & 0xFFFF);
       } else if (dst.get_operand_lohi() == 2) {
-        setValue.u64 = ((m_regs.back()[regName].u64) & (~(0xFFFF0000))) +
+        setValue.u64 = ((cur_regs().get(regName).u64) & (~(0xFFFF0000))) +
                        ((data.u64 << 16) & 0xFFFF0000);
       }
 
@@ -735,11 +785,11 @@ void ptx_thread_info::set_operand_value(const operand_info &dst,
       set_reg(name2, setValue2);
     } else {
       if (dst.get_operand_lohi() == 1) {
-        setValue.u64 = ((m_regs.back()[dst.get_symbol()].u64) & (~(0xFFFF))) +
+        setValue.u64 = ((cur_regs().get(dst.get_symbol()).u64) & (~(0xFFFF))) +
                        (data.u64 & 0xFFFF);
       } else if (dst.get_operand_lohi() == 2) {
         setValue.u64 =
-            ((m_regs.back()[dst.get_symbol()].u64) & (~(0xFFFF0000))) +
+            ((cur_regs().get(dst.get_symbol()).u64) & (~(0xFFFF0000))) +
             ((data.u64 << 16) & 0xFFFF0000);
       }
       set_reg(dst.get_symbol(), setValue);
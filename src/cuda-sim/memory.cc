@@ -27,7 +27,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "memory.h"
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 #include "../../libcuda/gpgpu_context.h"
 #include "../debug.h"
 
@@ -36,6 +42,8 @@ memory_space_impl<BSIZE>::memory_space_impl(std::string name,
                                             unsigned hash_size) {
   m_name = name;
   MEM_MAP_RESIZE(hash_size);
+  m_last_region_idx = 0;
+  m_last_region = NULL;
 
   m_log2_block_size = -1;
   for (unsigned n = 0, mask = 1; mask != 0; mask <<= 1, n++) {
@@ -47,10 +55,132 @@ memory_space_impl<BSIZE>::memory_space_impl(std::string name,
   assert(m_log2_block_size != (unsigned)-1);
 }
 
+template <unsigned BSIZE>
+memory_space_impl<BSIZE>::~memory_space_impl() {
+  std::vector<mem_region *> regions(m_direct);
+  typename mem_map<mem_addr_t, mem_region *>::iterator i;
+  for (i = m_sparse.begin(); i != m_sparse.end(); ++i)
+    regions.push_back(i->second);
+  size_t bytes = (size_t)REGION_BLOCKS * BSIZE;
+  for (unsigned n = 0; n < regions.size(); n++) {
+    if (regions[n] == NULL) continue;
+    if (bytes >= MEM_REGION_MMAP_BYTES)
+      munmap(regions[n]->m_data, bytes);
+    else
+      free(regions[n]->m_data);
+    delete regions[n];
+  }
+  for (unsigned n = 0; n < m_images.size(); n++) delete m_images[n];
+}
+
+template <unsigned BSIZE>
+typename memory_space_impl<BSIZE>::mem_region *
+memory_space_impl<BSIZE>::find_region(mem_addr_t region_idx,
+                                      bool alloc) const {
+  if (m_last_region != NULL && region_idx == m_last_region_idx)
+    return m_last_region;
+
+  mem_region *r = NULL;
+  if (region_idx < DIRECT_REGIONS) {
+    if (region_idx < m_direct.size()) r = m_direct[region_idx];
+  } else {
+    typename mem_map<mem_addr_t, mem_region *>::const_iterator i =
+        m_sparse.find(region_idx);
+    if (i != m_sparse.end()) r = i->second;
+  }
+  if (r == NULL) {
+    if (!alloc) return NULL;
+    size_t bytes = (size_t)REGION_BLOCKS * BSIZE;
+    r = new mem_region;
+    if (bytes >= MEM_REGION_MMAP_BYTES) {
+      void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (p == MAP_FAILED) {
+        printf("GPGPU-Sim PTX: ERROR * cannot map %zu bytes for memory "
+               "\'%s\'\n",
+               bytes, m_name.c_str());
+        exit(1);
+      }
+      r->m_data = (unsigned char *)p;
+    } else {
+      r->m_data = (unsigned char *)calloc(1, bytes);
+    }
+    memset(r->m_present, 0, sizeof(r->m_present));
+    if (region_idx < DIRECT_REGIONS) {
+      if (region_idx >= m_direct.size()) m_direct.resize(region_idx + 1, NULL);
+      m_direct[region_idx] = r;
+    } else {
+      m_sparse[region_idx] = r;
+    }
+  }
+  m_last_region_idx = region_idx;
+  m_last_region = r;
+  return r;
+}
+
+template <unsigned BSIZE>
+unsigned char *memory_space_impl<BSIZE>::add_block(mem_addr_t blk_idx) const {
+  mem_region *r = find_region(blk_idx / REGION_BLOCKS, true);
+  unsigned n = blk_idx % REGION_BLOCKS;
+  r->m_present[n / 64] |= 1ULL << (n % 64);
+  return r->m_data + n * BSIZE;
+}
+
+// Copy block blk_idx out of the newest attached image that holds it. Returns
+// NULL when no image has the block, which then reads as zeros.
+template <unsigned BSIZE>
+unsigned char *memory_space_impl<BSIZE>::fault_in(mem_addr_t blk_idx) const {
+  unsigned char *b = NULL;
+  for (unsigned n = m_images.size(); n-- > 0;) {
+    if (!m_images[n]->has_page(blk_idx)) continue;
+    if (b == NULL) {
+      b = add_block(blk_idx);
+      m_images[n]->load_page(blk_idx, b);
+    } else {
+      // older images' copies of the block are shadowed from now on
+      m_images[n]->drop_page(blk_idx);
+    }
+  }
+  if (b != NULL) release_images();
+  return b;
+}
+
+// Free the images none of whose pages can be faulted in any more.
+template <unsigned BSIZE>
+void memory_space_impl<BSIZE>::release_images() const {
+  unsigned kept = 0;
+  for (unsigned n = 0; n < m_images.size(); n++) {
+    if (m_images[n]->consumed())
+      delete m_images[n];
+    else
+      m_images[kept++] = m_images[n];
+  }
+  m_images.resize(kept);
+}
+
+// indices of all blocks that have been written, in address order
+template <unsigned BSIZE>
+void memory_space_impl<BSIZE>::present_blocks(
+    std::vector<mem_addr_t> &blocks) const {
+  std::map<mem_addr_t, const mem_region *> regions;
+  for (mem_addr_t r = 0; r < m_direct.size(); r++)
+    if (m_direct[r] != NULL) regions[r] = m_direct[r];
+  typename mem_map<mem_addr_t, mem_region *>::const_iterator i;
+  for (i = m_sparse.begin(); i != m_sparse.end(); ++i)
+    regions[i->first] = i->second;
+
+  typename std::map<mem_addr_t, const mem_region *>::const_iterator r;
+  for (r = regions.begin(); r != regions.end(); ++r) {
+    for (unsigned n = 0; n < REGION_BLOCKS; n++)
+      if (r->second->present(n)) blocks.push_back(r->first * REGION_BLOCKS + n);
+  }
+}
+
 template <unsigned BSIZE>
 void memory_space_impl<BSIZE>::write_only(mem_addr_t offset, mem_addr_t index,
                                           size_t length, const void *data) {
-  m_data[index].write(offset, length, (const unsigned char *)data);
+  assert(offset + length <= BSIZE);
+  memcpy(block(index) + offset, data, length);
 }
 
 template <unsigned BSIZE>
@@ -63,8 +193,7 @@ void memory_space_impl<BSIZE>::write(mem_addr_t addr, size_t length,
   if ((addr + length) <= (index + 1) * BSIZE) {
     // fast route for intra-block access
     unsigned offset = addr & (BSIZE - 1);
-    unsigned nbytes = length;
-    m_data[index].write(offset, nbytes, (const unsigned char *)data);
+    memcpy(block(index) + offset, data, length);
   } else {
     // slow route for inter-block access
     unsigned nbytes_remain = length;
@@ -80,8 +209,8 @@ void memory_space_impl<BSIZE>::write(mem_addr_t addr, size_t length,
       }
 
       size_t tx_bytes = access_limit - offset;
-      m_data[page].write(offset, tx_bytes,
-                         &((const unsigned char *)data)[src_offset]);
+      memcpy(block(page) + offset, &((const unsigned char *)data)[src_offset],
+             tx_bytes);
 
       // advance pointers
       src_offset += tx_bytes;
@@ -117,16 +246,14 @@ void memory_space_impl<BSIZE>::read_single_block(mem_addr_t blk_idx,
         (addr + length), (blk_idx + 1) * BSIZE, blk_idx, BSIZE);
     throw 1;
   }
-  typename map_t::const_iterator i = m_data.find(blk_idx);
-  if (i == m_data.end()) {
-    for (size_t n = 0; n < length; n++)
-      ((unsigned char *)data)[n] = (unsigned char)0;
+  const unsigned char *b = find_block(blk_idx);
+  if (b == NULL) {
+    memset(data, 0, length);
     // printf("GPGPU-Sim PTX:  WARNING reading %zu bytes from unititialized
     // memory at address 0x%x in space %s\n", length, addr, m_name.c_str() );
   } else {
     unsigned offset = addr & (BSIZE - 1);
-    unsigned nbytes = length;
-    i->second.read(offset, nbytes, (unsigned char *)data);
+    memcpy(data, b + offset, length);
   }
 }
 
@@ -166,11 +293,18 @@ void memory_space_impl<BSIZE>::read(mem_addr_t addr, size_t length,
 
 template <unsigned BSIZE>
 void memory_space_impl<BSIZE>::print(const char *format, FILE *fout) const {
-  typename map_t::const_iterator i_page;
-
-  for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) {
-    fprintf(fout, "%s %08llx:", m_name.c_str(), i_page->first);
-    i_page->second.print(format, fout);
+  std::vector<mem_addr_t> blocks;
+  present_blocks(blocks);
+  for (unsigned n = 0; n < blocks.size(); n++) {
+    fprintf(fout, "%s %08llx:", m_name.c_str(), blocks[n]);
+    const unsigned *i_data = (const unsigned *)find_block(blocks[n]);
+    for (unsigned d = 0; d < BSIZE / sizeof(unsigned); d++) {
+      fprintf(fout, "\n");
+      fprintf(fout, format, i_data[d]);
+      fprintf(fout, " ");
+    }
+    fprintf(fout, "\n");
+    fflush(fout);
   }
 }
 
@@ -179,11 +313,254 @@ void memory_space_impl<BSIZE>::set_watch(addr_t addr, unsigned watchpoint) {
   m_watchpoints[watchpoint] = addr;
 }
 
+template <unsigned BSIZE>
+void memory_space_impl<BSIZE>::attach_image(mem_image *image) {
+  if (image->page_size() != BSIZE) {
+    // written by a memory space with a different page size, no lazy loading
+    unsigned char *buf = (unsigned char *)malloc(image->page_size());
+    for (unsigned long long n = 0; n < image->num_pages(); n++) {
+      mem_addr_t blk_idx = image->page_index(n);
+      image->load_page(blk_idx, buf);
+      write(blk_idx * image->page_size(), image->page_size(), buf, NULL, NULL);
+    }
+    free(buf);
+    delete image;
+    return;
+  }
+  // pages this space already holds are never faulted in again, so the image
+  // has to override them now
+  std::vector<mem_addr_t> blocks;
+  present_blocks(blocks);
+  for (unsigned n = 0; n < blocks.size(); n++)
+    image->load_page(blocks[n], find_block(blocks[n]));
+  m_images.push_back(image);
+  if (image->num_pages() <= MEM_IMAGE_EAGER_PAGES) {
+    // small images (the local memory of a thread, say) are not worth keeping
+    // open: copy them in now
+    for (unsigned long long n = 0; n < image->num_pages(); n++)
+      blocks.push_back(image->page_index(n));
+    for (unsigned n = 0; n < blocks.size(); n++) find_block(blocks[n]);
+  }
+  release_images();
+}
+
+template <unsigned BSIZE>
+void memory_space_impl<BSIZE>::store_image(const char *fname,
+                                           bool compress) const {
+  // pages of attached images that were never touched are part of the state;
+  // faulting them in releases the images, so collect the indices first
+  std::vector<mem_addr_t> blocks;
+  for (unsigned n = 0; n < m_images.size(); n++) {
+    for (unsigned long long p = 0; p < m_images[n]->num_pages(); p++)
+      blocks.push_back(m_images[n]->page_index(p));
+  }
+  for (unsigned n = 0; n < blocks.size(); n++) find_block(blocks[n]);
+  blocks.clear();
+  present_blocks(blocks);
+
+  FILE *fout = fopen(fname, "wb");
+  if (fout == NULL) {
+    printf("GPGPU-Sim PTX: ERROR ** cannot write memory image \'%s\'\n",
+           fname);
+    exit(1);
+  }
+  mem_image_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MEM_IMAGE_MAGIC, sizeof(header.magic));
+  header.version = MEM_IMAGE_VERSION;
+  header.page_size = BSIZE;
+  header.n_pages = blocks.size();
+  fwrite(&header, sizeof(header), 1, fout);
+
+  std::vector<mem_image_page> index;
+  index.reserve(blocks.size());
+  unsigned long long offset = sizeof(header);
+  std::vector<unsigned char> packed(compressBound(BSIZE));
+  for (unsigned n = 0; n < blocks.size(); n++) {
+    mem_image_page entry;
+    entry.blk_idx = blocks[n];
+    entry.offset = offset;
+    entry.stored_size = 0;
+    entry.flags = 0;
+    const unsigned char *raw = find_block(blocks[n]);
+
+    bool zero = true;
+    for (unsigned b = 0; b < BSIZE && zero; b++) zero = raw[b] == 0;
+    if (zero) {
+      entry.flags = MEM_IMAGE_ZERO;
+      index.push_back(entry);
+      continue;
+    }
+
+    const unsigned char *payload = raw;
+    entry.stored_size = BSIZE;
+    if (compress) {
+      uLongf packed_size = packed.size();
+      if (compress2(&packed[0], &packed_size, raw, BSIZE, Z_BEST_SPEED) ==
+              Z_OK &&
+          packed_size < BSIZE) {
+        payload = &packed[0];
+        entry.stored_size = packed_size;
+        entry.flags = MEM_IMAGE_ZLIB;
+      }
+    }
+    fwrite(payload, 1, entry.stored_size, fout);
+    offset += entry.stored_size;
+    index.push_back(entry);
+  }
+
+  // keep the index naturally aligned for the reader's mapping
+  static const unsigned char pad[8] = {0};
+  unsigned n_pad = (8 - offset % 8) % 8;
+  fwrite(pad, 1, n_pad, fout);
+  header.index_offset = offset + n_pad;
+  if (!index.empty())
+    fwrite(&index[0], sizeof(mem_image_page), index.size(), fout);
+  fseek(fout, 0, SEEK_SET);
+  fwrite(&header, sizeof(header), 1, fout);
+  fclose(fout);
+}
+
 template class memory_space_impl<32>;
 template class memory_space_impl<64>;
 template class memory_space_impl<8192>;
 template class memory_space_impl<16 * 1024>;
 
+mem_image::mem_image(const char *fname)
+    : m_fname(fname),
+      m_map(NULL),
+      m_map_size(0),
+      m_mapped(false),
+      m_header(NULL),
+      m_pages(NULL),
+      m_pending(0) {}
+
+mem_image *mem_image::open(const char *fname, std::string &error) {
+  mem_image *image = new mem_image(fname);
+  if (!image->init(error)) {
+    delete image;
+    return NULL;
+  }
+  return image;
+}
+
+bool mem_image::init(std::string &error) {
+  int fd = ::open(m_fname.c_str(), O_RDONLY);
+  if (fd == -1) {
+    error = std::string("cannot open file: ") + strerror(errno);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    error = std::string("cannot stat file: ") + strerror(errno);
+    close(fd);
+    return false;
+  }
+  m_map_size = st.st_size;
+  if (m_map_size < sizeof(mem_image_header)) {
+    close(fd);
+    error = "truncated header";
+    return false;
+  }
+  if (m_map_size >= MEM_IMAGE_MMAP_BYTES) {
+    m_map = mmap(NULL, m_map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m_map == MAP_FAILED) {
+      m_map = NULL;
+      error = std::string("mmap failed: ") + strerror(errno);
+      if (errno == ENOMEM) error += " (mapping limit vm.max_map_count?)";
+      close(fd);
+      return false;
+    }
+    m_mapped = true;
+  } else {
+    m_map = malloc(m_map_size);
+    size_t done = 0;
+    while (done < m_map_size) {
+      ssize_t n = read(fd, (char *)m_map + done, m_map_size - done);
+      if (n <= 0) {
+        error = std::string("read failed: ") +
+                (n == 0 ? "unexpected end of file" : strerror(errno));
+        close(fd);
+        return false;
+      }
+      done += n;
+    }
+  }
+  close(fd);
+
+  m_header = (const mem_image_header *)m_map;
+  if (memcmp(m_header->magic, MEM_IMAGE_MAGIC, sizeof(m_header->magic)) ||
+      m_header->version != MEM_IMAGE_VERSION) {
+    error = "not a memory image or unsupported version";
+    return false;
+  }
+  if (m_header->index_offset > m_map_size ||
+      m_header->n_pages >
+          (m_map_size - m_header->index_offset) / sizeof(mem_image_page)) {
+    error = "truncated page index";
+    return false;
+  }
+  m_pages =
+      (const mem_image_page *)((const char *)m_map + m_header->index_offset);
+  for (unsigned long long n = 0; n < m_header->n_pages; n++) {
+    if (m_pages[n].offset + m_pages[n].stored_size > m_header->index_offset) {
+      error = "page payload out of bounds";
+      return false;
+    }
+    if (m_pages[n].flags == 0 && m_pages[n].stored_size != page_size()) {
+      error = "bad page size";
+      return false;
+    }
+    m_lookup[m_pages[n].blk_idx] = n;
+  }
+  m_consumed.assign(m_header->n_pages, false);
+  m_pending = m_header->n_pages;
+  return true;
+}
+
+mem_image::~mem_image() {
+  if (m_mapped)
+    munmap(m_map, m_map_size);
+  else
+    free(m_map);
+}
+
+void mem_image::consume(unsigned long long n) {
+  if (m_consumed[n]) return;
+  m_consumed[n] = true;
+  m_pending--;
+}
+
+bool mem_image::load_page(mem_addr_t blk_idx, unsigned char *dst) {
+  mem_map<mem_addr_t, unsigned long long>::const_iterator i =
+      m_lookup.find(blk_idx);
+  if (i == m_lookup.end()) return false;
+  const mem_image_page &entry = m_pages[i->second];
+  const unsigned char *src = (const unsigned char *)m_map + entry.offset;
+  if (entry.flags & MEM_IMAGE_ZERO) {
+    memset(dst, 0, page_size());
+  } else if (entry.flags & MEM_IMAGE_ZLIB) {
+    uLongf size = page_size();
+    if (uncompress(dst, &size, src, entry.stored_size) != Z_OK ||
+        size != page_size()) {
+      printf("GPGPU-Sim PTX: ERROR ** memory image \'%s\': corrupt "
+             "compressed page 0x%llx\n",
+             m_fname.c_str(), blk_idx);
+      exit(1);
+    }
+  } else {
+    memcpy(dst, src, page_size());
+  }
+  consume(i->second);
+  return true;
+}
+
+void mem_image::drop_page(mem_addr_t blk_idx) {
+  mem_map<mem_addr_t, unsigned long long>::const_iterator i =
+      m_lookup.find(blk_idx);
+  if (i != m_lookup.end()) consume(i->second);
+}
+
 void g_print_memory_space(memory_space *mem, const char *format = "%08x",
                           FILE *fout = stdout) {
   mem->print(format, fout);
@@ -36,7 +36,7 @@
 #if tr1_hash_map_ismap == 1
 #define MEM_MAP_RESIZE(hash_size)
 #else
-#define MEM_MAP_RESIZE(hash_size) (m_data.rehash(hash_size))
+#define MEM_MAP_RESIZE(hash_size) (m_sparse.rehash(hash_size))
 #endif
 
 #include <assert.h>
@@ -45,47 +45,80 @@
 #include <string.h>
 #include <map>
 #include <string>
+#include <vector>
 
 typedef address_type mem_addr_t;
 
 #define MEM_BLOCK_SIZE (4 * 1024)
 
-template <unsigned BSIZE>
-class mem_storage {
- public:
-  mem_storage(const mem_storage &another) {
-    m_data = (unsigned char *)calloc(1, BSIZE);
-    memcpy(m_data, another.m_data, BSIZE);
-  }
-  mem_storage() { m_data = (unsigned char *)calloc(1, BSIZE); }
-  ~mem_storage() { free(m_data); }
+// Read-only view of a binary memory image written by
+// memory_space::store_image(). A page is only copied out (and inflated, if it
+// was stored compressed) when the memory space it is attached to first
+// touches it, and the image is released once every page was copied out or
+// overwritten. Images below MEM_IMAGE_MMAP_BYTES are read into memory rather
+// than mapped, since a resume attaches one for every thread's local memory and
+// one mapping each could exceed the per-process limit (vm.max_map_count).
+//
+// File layout: a mem_image_header, the page payloads, then an array of
+// n_pages mem_image_page entries starting at index_offset.
+#define MEM_IMAGE_MAGIC "GPGPUMEM"
+#define MEM_IMAGE_VERSION 1
+#define MEM_IMAGE_ZLIB 0x1  // payload is zlib compressed
+#define MEM_IMAGE_ZERO 0x2  // page is all zeros, no payload
+#define MEM_IMAGE_MMAP_BYTES (1 << 20)
+// images with at most this many pages are copied in when they are attached
+#define MEM_IMAGE_EAGER_PAGES 16
+
+struct mem_image_header {
+  char magic[8];
+  unsigned version;
+  unsigned page_size;
+  unsigned long long n_pages;
+  unsigned long long index_offset;
+};
 
-  void write(unsigned offset, size_t length, const unsigned char *data) {
-    assert(offset + length <= BSIZE);
-    memcpy(m_data + offset, data, length);
-  }
+struct mem_image_page {
+  unsigned long long blk_idx;
+  unsigned long long offset;
+  unsigned stored_size;
+  unsigned flags;
+};
 
-  void read(unsigned offset, size_t length, unsigned char *data) const {
-    assert(offset + length <= BSIZE);
-    memcpy(data, m_data + offset, length);
+class mem_image {
+ public:
+  // NULL, with the reason in error, if fname is not a readable memory image
+  static mem_image *open(const char *fname, std::string &error);
+  ~mem_image();
+
+  unsigned page_size() const { return m_header->page_size; }
+  unsigned long long num_pages() const { return m_header->n_pages; }
+  mem_addr_t page_index(unsigned long long n) const {
+    return m_pages[n].blk_idx;
   }
-
-  void print(const char *format, FILE *fout) const {
-    unsigned int *i_data = (unsigned int *)m_data;
-    for (int d = 0; d < (BSIZE / sizeof(unsigned int)); d++) {
-      if (d % 1 == 0) {
-        fprintf(fout, "\n");
-      }
-      fprintf(fout, format, i_data[d]);
-      fprintf(fout, " ");
-    }
-    fprintf(fout, "\n");
-    fflush(fout);
+  bool has_page(mem_addr_t blk_idx) const {
+    return m_lookup.find(blk_idx) != m_lookup.end();
   }
+  // copy page blk_idx into dst (page_size() bytes), false if not in the image
+  bool load_page(mem_addr_t blk_idx, unsigned char *dst);
+  // page blk_idx was taken from a newer image and is never needed again
+  void drop_page(mem_addr_t blk_idx);
+  // every page was loaded or dropped
+  bool consumed() const { return m_pending == 0; }
 
  private:
-  unsigned m_nbytes;
-  unsigned char *m_data;
+  mem_image(const char *fname);
+  bool init(std::string &error);
+  void consume(unsigned long long n);
+
+  std::string m_fname;
+  void *m_map;  // mapped file, or a heap copy of it if !m_mapped
+  size_t m_map_size;
+  bool m_mapped;
+  const mem_image_header *m_header;
+  const mem_image_page *m_pages;
+  mem_map<mem_addr_t, unsigned long long> m_lookup;
+  std::vector<bool> m_consumed;
+  unsigned long long m_pending;
 };
 
 class ptx_thread_info;
@@ -101,12 +134,27 @@ class memory_space {
   virtual void read(mem_addr_t addr, size_t length, void *data) const = 0;
   virtual void print(const char *format, FILE *fout) const = 0;
   virtual void set_watch(addr_t addr, unsigned watchpoint) = 0;
+  // binary checkpoints: store_image() writes every page to fname,
+  // attach_image() takes ownership of an image whose pages replace the
+  // current contents and are faulted in lazily
+  virtual void store_image(const char *fname, bool compress) const = 0;
+  virtual void attach_image(mem_image *image) = 0;
 };
 
+// Regions at least this large are reserved with mmap, so the host only backs
+// the parts of them that are actually touched.
+#define MEM_REGION_MMAP_BYTES (1 << 20)
+
+// Simulated memory is kept in regions of REGION_BLOCKS contiguous blocks,
+// found through a two-level lookup: regions below DIRECT_REGIONS (which covers
+// the global heap and every local and shared space) are indexed directly, the
+// rest through a hash map. The last region touched is cached, so runs of
+// accesses to the same region skip the lookup altogether.
 template <unsigned BSIZE>
 class memory_space_impl : public memory_space {
  public:
   memory_space_impl(std::string name, unsigned hash_size);
+  virtual ~memory_space_impl();
 
   virtual void write(mem_addr_t addr, size_t length, const void *data,
                      ptx_thread_info *thd, const ptx_instruction *pI);
@@ -117,13 +165,54 @@ class memory_space_impl : public memory_space {
 
   virtual void set_watch(addr_t addr, unsigned watchpoint);
 
+  virtual void store_image(const char *fname, bool compress) const;
+  virtual void attach_image(mem_image *image);
+
  private:
+  static const unsigned REGION_BLOCKS = BSIZE < 4096 ? 64 : 256;
+  static const mem_addr_t DIRECT_REGIONS = 64 * 1024;
+
+  struct mem_region {
+    unsigned char *m_data;
+    // blocks that were written or faulted in from an image; the others read
+    // as zeros and are left out of print() and store_image()
+    unsigned long long m_present[(REGION_BLOCKS + 63) / 64];
+
+    bool present(unsigned n) const {
+      return (m_present[n / 64] >> (n % 64)) & 1;
+    }
+  };
+
   void read_single_block(mem_addr_t blk_idx, mem_addr_t addr, size_t length,
                          void *data) const;
+  mem_region *find_region(mem_addr_t region_idx, bool alloc) const;
+  unsigned char *add_block(mem_addr_t blk_idx) const;
+  unsigned char *fault_in(mem_addr_t blk_idx) const;
+  void release_images() const;
+  void present_blocks(std::vector<mem_addr_t> &blocks) const;
+
+  // block blk_idx, or NULL if it was never written
+  unsigned char *find_block(mem_addr_t blk_idx) const {
+    mem_region *r = find_region(blk_idx / REGION_BLOCKS, false);
+    unsigned n = blk_idx % REGION_BLOCKS;
+    if (r != NULL && r->present(n)) return r->m_data + n * BSIZE;
+    return m_images.empty() ? NULL : fault_in(blk_idx);
+  }
+  // block blk_idx, allocated if needed
+  unsigned char *block(mem_addr_t blk_idx) {
+    unsigned char *b = find_block(blk_idx);
+    return b ? b : add_block(blk_idx);
+  }
+
   std::string m_name;
   unsigned m_log2_block_size;
-  typedef mem_map<mem_addr_t, mem_storage<BSIZE> > map_t;
-  map_t m_data;
+  // blocks of attached images are added on first touch, which may happen on a
+  // read
+  mutable std::vector<mem_region *> m_direct;
+  mutable mem_map<mem_addr_t, mem_region *> m_sparse;
+  mutable mem_addr_t m_last_region_idx;
+  mutable mem_region *m_last_region;
+  mutable std::vector<mem_image *> m_images;  // oldest first
   std::map<unsigned, mem_addr_t> m_watchpoints;
 };
 
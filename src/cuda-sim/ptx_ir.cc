@@ -37,12 +37,14 @@ typedef void *yyscan_t;
 #include <stdlib.h>
 #include <algorithm>
 #include <list>
+#include <sstream>
 #include "assert.h"
 #include "opcodes.h"
 #include "ptx.tab.h"
 
 #include "../../libcuda/gpgpu_context.h"
 #include "cuda-sim.h"
+#include "ptx_loader.h"
 
 #define STR_SIZE 1024
 
@@ -604,29 +606,94 @@ bool function_info::connect_break_targets()  // connecting break instructions
 
   return modified;
 }
+// The control flow analysis only depends on the order of the instructions,
+// their sizes, predication, labels and branch targets: name the cached result
+// after a hash of those.
+std::string function_info::pdom_cache_name() const {
+  std::stringstream cfg;
+  std::list<ptx_instruction *>::const_iterator i;
+  for (i = m_instructions.begin(); i != m_instructions.end(); i++) {
+    const ptx_instruction *pI = *i;
+    if (pI->is_label()) {
+      cfg << pI->get_label()->name() << ":\n";
+      continue;
+    }
+    int op = pI->get_opcode();
+    cfg << op << " " << pI->inst_size() << " " << pI->has_pred();
+    if (op == BRA_OP || op == BREAKADDR_OP) cfg << " " << pI->dst().name();
+    cfg << "\n";
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "pdom-%016llx.bin",
+           ptx_cache_hash(cfg.str()));
+  return name;
+}
+
+// Entry layout: the number of basic blocks, then the immediate postdominator
+// and immediate dominator of each block (-1 for none).
+bool function_info::load_pdom_cache(const std::string &name) {
+  std::string data;
+  if (!ptx_cache_read(name, data)) return false;
+  unsigned n = m_basic_blocks.size();
+  if (data.size() != sizeof(unsigned) + 2 * n * sizeof(int)) return false;
+  unsigned count;
+  memcpy(&count, data.data(), sizeof(count));
+  if (count != n) return false;
+  std::vector<int> ids(2 * n);
+  memcpy(&ids[0], data.data() + sizeof(count), ids.size() * sizeof(int));
+  for (unsigned i = 0; i < ids.size(); i++)
+    if (ids[i] < -1 || ids[i] >= (int)n) return false;
+  for (unsigned i = 0; i < n; i++) {
+    m_basic_blocks[i]->immediatepostdominator_id = ids[2 * i];
+    m_basic_blocks[i]->immediatedominator_id = ids[2 * i + 1];
+  }
+  printf("GPGPU-Sim PTX: reusing cached postdominators for \'%s\'\n",
+         m_name.c_str());
+  return true;
+}
+
+void function_info::store_pdom_cache(const std::string &name) const {
+  unsigned n = m_basic_blocks.size();
+  std::string data((const char *)&n, sizeof(n));
+  for (unsigned i = 0; i < n; i++) {
+    int ids[2] = {m_basic_blocks[i]->immediatepostdominator_id,
+                  m_basic_blocks[i]->immediatedominator_id};
+    data.append((const char *)ids, sizeof(ids));
+  }
+  ptx_cache_write(name, data);
+}
+
 void function_info::do_pdom() {
   create_basic_blocks();
   connect_basic_blocks();
-  bool modified = false;
-  do {
-    find_dominators();
-    find_idominators();
-    modified = connect_break_targets();
-  } while (modified == true);
-
-  if (g_debug_execution >= 50) {
-    print_basic_blocks();
-    print_basic_block_links();
-    print_basic_block_dot();
-  }
-  if (g_debug_execution >= 2) {
-    print_dominators();
-  }
-  find_postdominators();
-  find_ipostdominators();
-  if (g_debug_execution >= 50) {
-    print_postdominators();
-    print_ipostdominators();
+  // only the immediate (post)dominators are cached, so the debug dumps of the
+  // full sets need the analysis to run
+  std::string cache_name;
+  if (ptx_cache_enabled() && g_debug_execution < 2)
+    cache_name = pdom_cache_name();
+  if (cache_name.empty() || !load_pdom_cache(cache_name)) {
+    bool modified = false;
+    do {
+      find_dominators();
+      find_idominators();
+      modified = connect_break_targets();
+    } while (modified == true);
+
+    if (g_debug_execution >= 50) {
+      print_basic_blocks();
+      print_basic_block_links();
+      print_basic_block_dot();
+    }
+    if (g_debug_execution >= 2) {
+      print_dominators();
+    }
+    find_postdominators();
+    find_ipostdominators();
+    if (g_debug_execution >= 50) {
+      print_postdominators();
+      print_ipostdominators();
+    }
+    if (!cache_name.empty()) store_pdom_cache(cache_name);
   }
   printf("GPGPU-Sim PTX: pre-decoding instructions for \'%s\'...\n",
          m_name.c_str());
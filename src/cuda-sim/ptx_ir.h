@@ -187,6 +187,7 @@ class symbol {
     m_is_tex = false;
     m_is_func_addr = false;
     m_reg_num_valid = false;
+    m_reg_scope = NULL;
     m_function = NULL;
     m_reg_num = (unsigned)-1;
     m_arch_reg_num = (unsigned)-1;
@@ -217,6 +218,10 @@ class symbol {
     m_reg_num = regno;
     m_arch_reg_num = arch_regno;
   }
+  // scope in which reg_num() is unique; registers of the same scope share a
+  // dense per-thread register frame indexed by reg_num() (see reg_file_t)
+  void set_reg_scope(const symbol_table *scope) { m_reg_scope = scope; }
+  const symbol_table *reg_scope() const { return m_reg_scope; }
 
   void set_address(addr_t addr) {
     m_address_valid = true;
@@ -295,6 +300,7 @@ class symbol {
   unsigned m_reg_num;
   unsigned m_arch_reg_num;
   bool m_reg_num_valid;
+  const symbol_table *m_reg_scope;
 
   std::list<operand_info> m_initializer;
 };
@@ -1302,6 +1308,11 @@ class function_info {
 
   unsigned get_function_size() { return m_instructions.size(); }
 
+  // persistent cache of the do_pdom() results, see -gpgpu_ptx_cache_dir
+  std::string pdom_cache_name() const;
+  bool load_pdom_cache(const std::string &name);
+  void store_pdom_cache(const std::string &name) const;
+
   void ptx_assemble();
 
   unsigned ptx_get_inst_op(ptx_thread_info *thread);
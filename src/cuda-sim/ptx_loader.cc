@@ -28,6 +28,9 @@
 
 #include "ptx_loader.h"
 #include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <fstream>
 #include <sstream>
@@ -56,6 +59,7 @@ extern int ptxinfo_lex_destroy(yyscan_t scanner);
 
 static bool g_save_embedded_ptx;
 static int g_occupancy_sm_number;
+static char *g_ptx_cache_dir;
 
 bool ptxinfo_data::keep_intermediate_files() {
   return g_keep_intermediate_files;
@@ -79,6 +83,164 @@ void gpgpu_context::ptx_reg_options(option_parser_t opp) {
                          "usage for computing GPU occupancy. "
                          "This parameter is required in the config.",
                          "0");
+  option_parser_register(opp, "-gpgpu_ptx_cache_dir", OPT_CSTR,
+                         &g_ptx_cache_dir,
+                         "directory caching the PTX extracted by cuobjdump, "
+                         "the ptxas resource usage and the kernels' "
+                         "postdominator analysis across runs "
+                         "(empty: no caching)",
+                         "");
+}
+
+bool ptx_cache_enabled() { return g_ptx_cache_dir && *g_ptx_cache_dir; }
+
+static unsigned long long fnv_hash(unsigned long long hash, const void *data,
+                                   size_t n) {
+  const unsigned char *p = (const unsigned char *)data;
+  for (size_t i = 0; i < n; i++) hash = (hash ^ p[i]) * 1099511628211ULL;
+  return hash;
+}
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+
+unsigned long long ptx_cache_hash(const char *filename,
+                                  const std::string &salt) {
+  unsigned long long hash = FNV_OFFSET_BASIS;
+  FILE *f = fopen(filename, "rb");
+  if (f) {
+    unsigned char buf[1 << 16];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      hash = fnv_hash(hash, buf, n);
+    fclose(f);
+  }
+  return fnv_hash(hash, salt.data(), salt.size());
+}
+
+unsigned long long ptx_cache_hash(const std::string &data) {
+  return fnv_hash(FNV_OFFSET_BASIS, data.data(), data.size());
+}
+
+unsigned long long ptx_cache_file_hash(const char *filename,
+                                       const std::string &salt) {
+  struct stat st;
+  char path[PATH_MAX];
+  if (!ptx_cache_enabled() || stat(filename, &st) != 0 ||
+      realpath(filename, path) == NULL)
+    return ptx_cache_hash(filename, salt);
+
+  std::stringstream stamp;
+  stamp << path << "|" << st.st_size << "|" << st.st_mtim.tv_sec << "."
+        << st.st_mtim.tv_nsec << "|" << salt << "\n";
+  char name[64];
+  snprintf(name, sizeof(name), "stamp-%016llx.txt",
+           ptx_cache_hash(stamp.str()));
+  // the entry repeats the stamp, so a colliding name is not taken for a hit
+  std::string entry;
+  unsigned long long hash;
+  if (ptx_cache_read(name, entry) && entry.size() > stamp.str().size() &&
+      entry.compare(0, stamp.str().size(), stamp.str()) == 0 &&
+      sscanf(entry.c_str() + stamp.str().size(), "%llx", &hash) == 1)
+    return hash;
+
+  hash = ptx_cache_hash(filename, salt);
+  char line[32];
+  snprintf(line, sizeof(line), "%016llx\n", hash);
+  ptx_cache_write(name, stamp.str() + line);
+  return hash;
+}
+
+static bool copy_file(const char *src, const char *dst) {
+  FILE *in = fopen(src, "rb");
+  if (!in) return false;
+  FILE *out = fopen(dst, "wb");
+  if (!out) {
+    fclose(in);
+    return false;
+  }
+  char buf[1 << 16];
+  size_t n;
+  bool ok = true;
+  while (ok && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+    ok = fwrite(buf, 1, n, out) == n;
+  ok = !ferror(in) && ok;
+  fclose(in);
+  ok = fclose(out) == 0 && ok;
+  return ok;
+}
+
+bool ptx_cache_fetch(const std::string &name, const char *dest_file) {
+  if (!ptx_cache_enabled()) return false;
+  std::string path = std::string(g_ptx_cache_dir) + "/" + name;
+  if (!copy_file(path.c_str(), dest_file)) return false;
+  printf("GPGPU-Sim PTX: reusing cached %s\n", path.c_str());
+  return true;
+}
+
+// Runs sharing the cache may store the same entry concurrently, so entries
+// are written to a private file that is then renamed into place.
+static std::string cache_temp_path(const std::string &name) {
+  mkdir(g_ptx_cache_dir, 0777);
+  std::stringstream tmp;
+  tmp << g_ptx_cache_dir << "/" << name << "." << getpid();
+  return tmp.str();
+}
+
+static void cache_commit(const std::string &name, const std::string &tmp,
+                         bool ok) {
+  std::string path = std::string(g_ptx_cache_dir) + "/" + name;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    printf("GPGPU-Sim PTX: WARNING ** could not write cache entry %s\n",
+           path.c_str());
+    remove(tmp.c_str());
+  }
+}
+
+void ptx_cache_store(const std::string &name, const char *src_file) {
+  if (!ptx_cache_enabled()) return;
+  std::string tmp = cache_temp_path(name);
+  cache_commit(name, tmp, copy_file(src_file, tmp.c_str()));
+}
+
+bool ptx_cache_read(const std::string &name, std::string &data) {
+  if (!ptx_cache_enabled()) return false;
+  std::string path = std::string(g_ptx_cache_dir) + "/" + name;
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  data.clear();
+  char buf[1 << 16];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.append(buf, n);
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+void ptx_cache_write(const std::string &name, const std::string &data) {
+  if (!ptx_cache_enabled()) return;
+  std::string tmp = cache_temp_path(name);
+  FILE *f = fopen(tmp.c_str(), "wb");
+  bool ok = f != NULL;
+  if (f) {
+    ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+  }
+  cache_commit(name, tmp, ok);
+}
+
+// Name of the cache entry holding the ptxas report for ptx_file compiled with
+// flags. The report also depends on the CUDA installation providing ptxas.
+static std::string ptxas_cache_name(const char *ptx_file, const char *flags) {
+  std::string salt(flags);
+  const char *roots[] = {"PTXAS_CUDA_INSTALL_PATH", "CUDA_INSTALL_PATH"};
+  for (unsigned i = 0; i < 2; i++) {
+    const char *root = getenv(roots[i]);
+    salt += std::string("|") + (root ? root : "");
+  }
+  char name[64];
+  snprintf(name, sizeof(name), "ptxas-%016llx.txt",
+           ptx_cache_hash(ptx_file, salt));
+  return name;
 }
 
 void gpgpu_context::print_ptx_file(const char *p, unsigned source_num,
@@ -440,6 +602,12 @@ void gpgpu_context::gpgpu_ptxinfo_load_from_string(const char *p_for_info,
                g_occupancy_sm_number);
 #endif
 
+    std::string cache_name;
+    if (ptx_cache_enabled()) {
+      cache_name = ptxas_cache_name(fname2, extra_flags);
+      if (ptx_cache_fetch(cache_name, tempfile_ptxinfo)) continue;
+    }
+
     snprintf(commandline, 1024,
              "$PTXAS_CUDA_INSTALL_PATH/bin/ptxas %s -v %s --output-file  "
              "/dev/null 2> %s",
@@ -473,6 +641,7 @@ void gpgpu_context::gpgpu_ptxinfo_load_from_string(const char *p_for_info,
         exit(1);
       }
     }
+    ptx_cache_store(cache_name, tempfile_ptxinfo);
   }
 
   // TODO: duplicate code! move it into a function so that it can be reused!
@@ -522,17 +691,24 @@ void gpgpu_context::gpgpu_ptxinfo_load_from_string(const char *p_for_info,
                sm_version);
 #endif
 
-    snprintf(
-        commandline, 1024,
-        "$CUDA_INSTALL_PATH/bin/ptxas %s -v %s --output-file  /dev/null 2> %s",
-        extra_flags, fname2, tempfile_ptxinfo);
-    printf("GPGPU-Sim PTX: generating ptxinfo using \"%s\"\n", commandline);
-    fflush(stdout);
-    result = system(commandline);
-    if (result != 0) {
-      printf("GPGPU-Sim PTX: ERROR ** while loading PTX (b) %d\n", result);
-      printf("               Ensure ptxas is in your path.\n");
-      exit(1);
+    std::string cache_name;
+    if (ptx_cache_enabled())
+      cache_name = ptxas_cache_name(fname2, extra_flags);
+    if (!ptx_cache_fetch(cache_name, tempfile_ptxinfo)) {
+      snprintf(commandline, 1024,
+               "$CUDA_INSTALL_PATH/bin/ptxas %s -v %s --output-file  "
+               "/dev/null 2> %s",
+               extra_flags, fname2, tempfile_ptxinfo);
+      printf("GPGPU-Sim PTX: generating ptxinfo using \"%s\"\n",
+             commandline);
+      fflush(stdout);
+      result = system(commandline);
+      if (result != 0) {
+        printf("GPGPU-Sim PTX: ERROR ** while loading PTX (b) %d\n", result);
+        printf("               Ensure ptxas is in your path.\n");
+        exit(1);
+      }
+      ptx_cache_store(cache_name, tempfile_ptxinfo);
     }
   }
 
@@ -50,4 +50,27 @@ class ptxinfo_data {
       const std::string elf_str);
 };
 
+// Persistent cache of the files the CUDA tools produce while loading an
+// application (the PTX cuobjdump extracts and the resource usage ptxas
+// reports) and of the postdominator analysis of each kernel, kept in the
+// directory given by -gpgpu_ptx_cache_dir. Entries are named by the caller,
+// normally after a hash of their input.
+bool ptx_cache_enabled();
+// 64-bit FNV-1a hash of the contents of filename followed by salt
+unsigned long long ptx_cache_hash(const char* filename,
+                                  const std::string& salt);
+unsigned long long ptx_cache_hash(const std::string& data);
+// Same as ptx_cache_hash(filename, salt), for large files hashed on every
+// run: the result is cached under the file's path, size and modification
+// time, and the contents are only read again when one of them changes.
+unsigned long long ptx_cache_file_hash(const char* filename,
+                                       const std::string& salt);
+// Copy the cache entry name to dest_file; false if there is no such entry.
+bool ptx_cache_fetch(const std::string& name, const char* dest_file);
+// Copy src_file into the cache as entry name.
+void ptx_cache_store(const std::string& name, const char* src_file);
+// Whole entries held in memory; read fails if there is no such entry.
+bool ptx_cache_read(const std::string& name, std::string& data);
+void ptx_cache_write(const std::string& name, const std::string& data);
+
 #endif
@@ -385,6 +385,7 @@ void ptx_recognizer::add_identifier(const char *identifier, int array_dim,
         arch_regnum = 0;
       }
       g_last_symbol->set_regno(regnum, arch_regnum);
+      g_last_symbol->set_reg_scope(g_current_symbol_table);
     } break;
     case shared_space:
       printf("GPGPU-Sim PTX: allocating shared region for \"%s\" ", identifier);
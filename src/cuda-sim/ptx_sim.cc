@@ -173,7 +173,8 @@ ptx_thread_info::ptx_thread_info(kernel_info_t &kernel) : m_kernel(kernel) {
   m_hw_sid = -1;
   m_last_dram_callback.function = NULL;
   m_last_dram_callback.instruction = NULL;
-  m_regs.push_back(reg_map_t());
+  m_reg_depth = 0;
+  push_reg_frame();
   m_debug_trace_regs_modified.push_back(reg_map_t());
   m_debug_trace_regs_read.push_back(reg_map_t());
   m_callstack.push_back(stack_entry());
@@ -413,7 +414,7 @@ void ptx_thread_info::callstack_push(unsigned pc, unsigned rpc,
   assert(m_func_info != NULL);
   m_callstack.push_back(stack_entry(m_symbol_table, m_func_info, pc, rpc,
                                     return_var_src, return_var_dst, call_uid));
-  m_regs.push_back(reg_map_t());
+  push_reg_frame();
   m_debug_trace_regs_modified.push_back(reg_map_t());
   m_debug_trace_regs_read.push_back(reg_map_t());
   m_local_mem_stack_pointer += m_func_info->local_mem_framesize();
@@ -460,7 +461,7 @@ bool ptx_thread_info::callstack_pop() {
     m_local_mem_stack_pointer -= m_func_info->local_mem_framesize();
   }
   m_callstack.pop_back();
-  m_regs.pop_back();
+  pop_reg_frame();
   m_debug_trace_regs_modified.pop_back();
   m_debug_trace_regs_read.pop_back();
 
@@ -507,14 +508,14 @@ bool ptx_thread_info::callstack_pop_plus() {
 
 void ptx_thread_info::dump_callstack() const {
   std::list<stack_entry>::const_iterator c = m_callstack.begin();
-  std::list<reg_map_t>::const_iterator r = m_regs.begin();
+  unsigned r = 0;
 
   printf("\n\n");
   printf("Call stack for thread uid = %u (sc=%u, hwtid=%u)\n", m_uid, m_hw_sid,
          m_hw_tid);
-  while (c != m_callstack.end() && r != m_regs.end()) {
+  while (c != m_callstack.end() && r < m_reg_depth) {
     const stack_entry &c_e = *c;
-    const reg_map_t &regs = *r;
+    const reg_file_t &regs = m_regs[r];
     if (!c_e.m_valid) {
       printf("  <entry>                              #regs = %zu\n",
              regs.size());
@@ -527,7 +528,7 @@ void ptx_thread_info::dump_callstack() const {
     c++;
     r++;
   }
-  if (c != m_callstack.end() || r != m_regs.end()) {
+  if (c != m_callstack.end() || r != m_reg_depth) {
     printf("  *** mismatch in m_regs and m_callstack sizes ***\n");
   }
   printf("\n\n");
@@ -549,14 +550,15 @@ const ptx_instruction *ptx_thread_info::get_inst(addr_t pc) const {
 }
 
 void ptx_thread_info::dump_regs(FILE *fp) {
-  if (m_regs.empty()) return;
-  if (m_regs.back().empty()) return;
+  if (m_reg_depth == 0) return;
+  if (cur_regs().empty()) return;
   fprintf(fp, "Register File Contents:\n");
   fflush(fp);
-  reg_map_t::const_iterator r;
-  for (r = m_regs.back().begin(); r != m_regs.back().end(); ++r) {
-    const symbol *sym = r->first;
-    ptx_reg_t value = r->second;
+  std::vector<std::pair<const symbol *, ptx_reg_t> > regs;
+  cur_regs().get_all(regs);
+  for (unsigned r = 0; r < regs.size(); r++) {
+    const symbol *sym = regs[r].first;
+    ptx_reg_t value = regs[r].second;
     std::string name = sym->name();
     print_reg(fp, name, value, m_symbol_table);
   }
@@ -226,6 +226,40 @@ struct stack_entry {
   unsigned m_call_uid;
 };
 
+typedef tr1_hash_map<const symbol *, ptx_reg_t> reg_map_t;
+
+// Register values of one call frame. Registers declared in a function are
+// numbered densely by the parser (symbol::reg_num() within
+// symbol::reg_scope()), so the frame binds to the scope of the first register
+// written and keeps those registers in a flat array indexed by reg_num().
+// Registers from any other scope (e.g. ptxplus frames shared across calls)
+// fall back to a hash map.
+class reg_file_t {
+ public:
+  reg_file_t() : m_scope(NULL), m_n_defined(0) {}
+
+  // NULL if the register has not been written in this frame
+  ptx_reg_t *find(const symbol *reg);
+  void set(const symbol *reg, const ptx_reg_t &value);
+  // value of the register, or zero if it has not been written
+  ptx_reg_t get(const symbol *reg) {
+    ptx_reg_t *value = find(reg);
+    return value ? *value : ptx_reg_t();
+  }
+  void clear();
+  bool empty() const { return size() == 0; }
+  size_t size() const { return m_n_defined + m_other.size(); }
+  // (register, value) pairs in slot order, then the fallback registers
+  void get_all(std::vector<std::pair<const symbol *, ptx_reg_t> > &regs) const;
+
+ private:
+  const symbol_table *m_scope;
+  std::vector<ptx_reg_t> m_value;
+  std::vector<const symbol *> m_defined;  // NULL for slots not yet written
+  unsigned m_n_defined;
+  reg_map_t m_other;
+};
+
 class ptx_version {
  public:
   ptx_version() {
@@ -306,6 +340,12 @@ class ptx_thread_info {
 
   void ptx_fetch_inst(inst_t &inst) const;
   void ptx_exec_inst(warp_inst_t &inst, unsigned lane_id);
+  // Execute a side-effect free integer instruction on plain registers (see
+  // warp_alu_op_t in cuda-sim.cc) for all active lanes of a warp at once.
+  // Returns false without touching any thread state if the instruction has
+  // to go through ptx_exec_inst() lane by lane instead.
+  static bool ptx_exec_warp_inst(core_t *core, warp_inst_t &inst,
+                                 unsigned warpId);
 
   const ptx_version &get_ptx_version() const;
   void set_reg(const symbol *reg, const ptx_reg_t &value);
@@ -472,6 +512,8 @@ class ptx_thread_info {
   ptx_reg_t m_last_set_operand_value;
 
  private:
+  void report_liveness();
+
   bool m_functionalSimulationMode;
   unsigned m_uid;
   kernel_info_t &m_kernel;
@@ -506,8 +548,22 @@ class ptx_thread_info {
   std::list<stack_entry> m_callstack;
   unsigned m_local_mem_stack_pointer;
 
-  typedef tr1_hash_map<const symbol *, ptx_reg_t> reg_map_t;
-  std::list<reg_map_t> m_regs;
+  // one register frame per call depth; frames above m_reg_depth are kept
+  // around so calls reuse their storage instead of reallocating it
+  std::vector<reg_file_t> m_regs;
+  unsigned m_reg_depth;
+  reg_file_t &cur_regs() {
+    assert(m_reg_depth > 0);
+    return m_regs[m_reg_depth - 1];
+  }
+  void push_reg_frame() {
+    if (m_regs.size() == m_reg_depth) m_regs.push_back(reg_file_t());
+    m_regs[m_reg_depth++].clear();
+  }
+  void pop_reg_frame() {
+    assert(m_reg_depth > 0);
+    m_reg_depth--;
+  }
   std::list<reg_map_t> m_debug_trace_regs_modified;
   std::list<reg_map_t> m_debug_trace_regs_read;
   bool m_enable_debug_trace;
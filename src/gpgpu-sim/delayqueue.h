@@ -36,12 +36,14 @@
 #include "../statwrapper.h"
 #include "gpu-misc.h"
 
-template <class T>
-struct fifo_data {
-  T* m_data;
-  fifo_data* m_next;
-};
-
+// Initial ring size of queues whose maximum length is large; the ring doubles
+// whenever it fills up until it can hold max_len entries.
+#define FIFO_PIPELINE_INIT_CAPACITY 64
+
+// FIFO with an optional minimum length: while holding fewer than min_len
+// entries it is padded with NULL entries, which delays the data behind them.
+// Entries live in a power-of-two ring buffer, so pushing and popping never
+// allocate once the ring has reached its working size.
 template <class T>
 class fifo_pipeline {
  public:
@@ -52,54 +54,38 @@ class fifo_pipeline {
     m_max_len = maxlen;
     m_length = 0;
     m_n_element = 0;
-    m_head = NULL;
-    m_tail = NULL;
+    m_head = 0;
+    unsigned init = m_max_len < FIFO_PIPELINE_INIT_CAPACITY
+                        ? m_max_len
+                        : FIFO_PIPELINE_INIT_CAPACITY;
+    if (init <= m_min_len) init = m_min_len + 1;
+    m_capacity = 1;
+    while (m_capacity < init) m_capacity <<= 1;
+    m_ring = new T*[m_capacity];
     for (unsigned i = 0; i < m_min_len; i++) push(NULL);
   }
 
-  ~fifo_pipeline() {
-    while (m_head) {
-      m_tail = m_head;
-      m_head = m_head->m_next;
-      delete m_tail;
-    }
-  }
+  ~fifo_pipeline() { delete[] m_ring; }
 
   void push(T* data) {
     assert(m_length < m_max_len);
-    if (m_head) {
-      if (m_tail->m_data || m_length < m_min_len) {
-        m_tail->m_next = new fifo_data<T>();
-        m_tail = m_tail->m_next;
-        m_length++;
-        m_n_element++;
-      }
-    } else {
-      m_head = m_tail = new fifo_data<T>();
-      m_length++;
-      m_n_element++;
+    if (m_length && !slot(m_length - 1) && m_length >= m_min_len) {
+      // data takes the place of a trailing delay entry
+      slot(m_length - 1) = data;
+      return;
     }
-    m_tail->m_next = NULL;
-    m_tail->m_data = data;
+    if (m_length == m_capacity) grow();
+    slot(m_length) = data;
+    m_length++;
+    m_n_element++;
   }
 
   T* pop() {
-    fifo_data<T>* next;
     T* data;
-    if (m_head) {
-      next = m_head->m_next;
-      data = m_head->m_data;
-      if (m_head == m_tail) {
-        assert(next == NULL);
-        m_tail = NULL;
-      }
-      delete m_head;
-      m_head = next;
+    if (m_length) {
+      data = m_ring[m_head];
+      m_head = (m_head + 1) & (m_capacity - 1);
       m_length--;
-      if (m_length == 0) {
-        assert(m_head == NULL);
-        m_tail = m_head;
-      }
       m_n_element--;
       if (m_min_len && m_length < m_min_len) {
         push(NULL);
@@ -112,8 +98,8 @@ class fifo_pipeline {
   }
 
   T* top() const {
-    if (m_head) {
-      return m_head->m_data;
+    if (m_length) {
+      return m_ring[m_head];
     } else {
       return NULL;
     }
@@ -131,22 +117,14 @@ class fifo_pipeline {
     } else {
       // in this branch imply that the original min_len is larger then 0
       // ie. head != 0
-      assert(m_head);
+      assert(m_length);
       m_min_len = new_min_len;
-      while ((m_length > m_min_len) && (m_tail->m_data == 0)) {
-        fifo_data<T>* iter;
-        iter = m_head;
-        while (iter && (iter->m_next != m_tail)) iter = iter->m_next;
-        if (!iter) {
-          // there is only one node, and that node is empty
-          assert(m_head->m_data == 0);
+      while ((m_length > m_min_len) && (slot(m_length - 1) == 0)) {
+        if (m_length == 1) {
+          // there is only one entry, and that entry is empty
           pop();
         } else {
-          // there are more than one node, and tail node is empty
-          assert(iter->m_next == m_tail);
-          delete m_tail;
-          m_tail = iter;
-          m_tail->m_next = 0;
+          // there are more than one entry, and the tail entry is empty
           m_length--;
         }
       }
@@ -157,22 +135,31 @@ class fifo_pipeline {
   bool is_avilable_size(unsigned size) const {
     return (m_max_len && m_length + size - 1 >= m_max_len);
   }
-  bool empty() const { return m_head == NULL; }
+  bool empty() const { return m_length == 0; }
   unsigned get_n_element() const { return m_n_element; }
   unsigned get_length() const { return m_length; }
   unsigned get_max_len() const { return m_max_len; }
 
   void print() const {
-    fifo_data<T>* ddp = m_head;
     printf("%s(%d): ", m_name, m_length);
-    while (ddp) {
-      printf("%p ", ddp->m_data);
-      ddp = ddp->m_next;
-    }
+    for (unsigned i = 0; i < m_length; i++)
+      printf("%p ", m_ring[(m_head + i) & (m_capacity - 1)]);
     printf("\n");
   }
 
  private:
+  // i-th entry from the head
+  T*& slot(unsigned i) { return m_ring[(m_head + i) & (m_capacity - 1)]; }
+
+  void grow() {
+    T** ring = new T*[2 * m_capacity];
+    for (unsigned i = 0; i < m_length; i++) ring[i] = slot(i);
+    delete[] m_ring;
+    m_ring = ring;
+    m_head = 0;
+    m_capacity *= 2;
+  }
+
   const char* m_name;
 
   unsigned int m_min_len;
@@ -180,8 +167,9 @@ class fifo_pipeline {
   unsigned int m_length;
   unsigned int m_n_element;
 
-  fifo_data<T>* m_head;
-  fifo_data<T>* m_tail;
+  T** m_ring;
+  unsigned int m_capacity;  // power of two
+  unsigned int m_head;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "l2cache.h"
 #include "mem_fetch.h"
 #include "mem_latency_stat.h"
+#include "visualizer_log.h"
 
 #ifdef DRAM_VERIFY
 int PRINT_CYCLE = 0;
@@ -94,6 +95,7 @@ dram_t::dram_t(unsigned int partition_id, const memory_config *config,
   bkgrp_parallsim_rw = 0;
 
   rw = READ;  // read mode is default
+  m_quiescent = false;
 
   bkgrp = (bankgrp_t **)calloc(sizeof(bankgrp_t *), m_config->nbkgrp);
   bkgrp[0] = (bankgrp_t *)calloc(sizeof(bank_t), m_config->nbkgrp);
@@ -254,6 +256,7 @@ void dram_t::push(class mem_fetch *data) {
   data->set_status(IN_PARTITION_MC_INTERFACE_QUEUE,
                    m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle);
   mrqq->push(mrq);
+  m_quiescent = false;
 
   // stats...
   n_req += 1;
@@ -286,7 +289,42 @@ void dram_t::scheduler_fifo() {
   b ^= a;          \
   a ^= b;
 
+bool dram_t::quiescent() const {
+  if (!mrqq->empty() || rwq->get_n_element()) return false;
+  if (m_config->scheduler_type == DRAM_FRFCFS && !m_frfcfs_scheduler->idle())
+    return false;
+  if (RRDc || CCDc || RTWc || WTRc) return false;
+  for (unsigned j = 0; j < m_config->nbk; j++) {
+    if (bk[j]->mrq || bk[j]->RCDc || bk[j]->RASc || bk[j]->RCc || bk[j]->RPc ||
+        bk[j]->RCDWRc || bk[j]->WTPc || bk[j]->RTPc)
+      return false;
+  }
+  for (unsigned j = 0; j < m_config->nbkgrp; j++) {
+    if (bkgrp[j]->CCDLc || bkgrp[j]->RTPLc) return false;
+  }
+  return true;
+}
+
+// The effect of cycle() on a quiescent channel: no command can issue, every
+// bank is idle and no timing counter is running.
+void dram_t::idle_cycle() {
+  for (unsigned j = 0; j < m_config->nbk; j++) bk[j]->n_idle++;
+  n_nop++;
+  n_nop_partial++;
+  n_cmd++;
+  n_cmd_partial++;
+  idle_bw++;
+#ifdef DRAM_VISUALIZE
+  visualize();
+#endif
+}
+
 void dram_t::cycle() {
+  if (m_quiescent) {
+    idle_cycle();
+    return;
+  }
+
   if (!returnq->full()) {
     dram_req_t *cmd = rwq->pop();
     if (cmd) {
@@ -549,6 +587,8 @@ void dram_t::cycle() {
 #ifdef DRAM_VISUALIZE
   visualize();
 #endif
+
+  m_quiescent = quiescent();
 }
 
 bool dram_t::issue_col_command(int j) {
@@ -812,21 +852,32 @@ void dram_t::print_stat(FILE *simFile) {
   max_mrqs_temp = 0;
 }
 
-void dram_t::visualizer_print(gzFile visualizer_file) {
+// one "<name>: <partition> <value>" row of the visualizer log
+static void visualizer_print_row(visualizer_log *log, const char *name,
+                                 unsigned id, unsigned value) {
+  log->begin_row(name);
+  log->add(id);
+  log->add(value);
+  log->end_row();
+}
+
+void dram_t::visualizer_print(visualizer_log *log) {
   // dram specific statistics
-  gzprintf(visualizer_file, "dramncmd: %u %u\n", id, n_cmd_partial);
-  gzprintf(visualizer_file, "dramnop: %u %u\n", id, n_nop_partial);
-  gzprintf(visualizer_file, "dramnact: %u %u\n", id, n_act_partial);
-  gzprintf(visualizer_file, "dramnpre: %u %u\n", id, n_pre_partial);
-  gzprintf(visualizer_file, "dramnreq: %u %u\n", id, n_req_partial);
-  gzprintf(visualizer_file, "dramavemrqs: %u %u\n", id,
-           n_cmd_partial ? (ave_mrqs_partial / n_cmd_partial) : 0);
+  visualizer_print_row(log, "dramncmd", id, n_cmd_partial);
+  visualizer_print_row(log, "dramnop", id, n_nop_partial);
+  visualizer_print_row(log, "dramnact", id, n_act_partial);
+  visualizer_print_row(log, "dramnpre", id, n_pre_partial);
+  visualizer_print_row(log, "dramnreq", id, n_req_partial);
+  visualizer_print_row(log, "dramavemrqs", id,
+                       n_cmd_partial ? (ave_mrqs_partial / n_cmd_partial) : 0);
 
   // utilization and efficiency
-  gzprintf(visualizer_file, "dramutil: %u %u\n", id,
-           n_cmd_partial ? 100 * bwutil_partial / n_cmd_partial : 0);
-  gzprintf(visualizer_file, "drameff: %u %u\n", id,
-           n_activity_partial ? 100 * bwutil_partial / n_activity_partial : 0);
+  visualizer_print_row(
+      log, "dramutil", id,
+      n_cmd_partial ? 100 * bwutil_partial / n_cmd_partial : 0);
+  visualizer_print_row(
+      log, "drameff", id,
+      n_activity_partial ? 100 * bwutil_partial / n_activity_partial : 0);
 
   // reset for next interval
   bwutil_partial = 0;
@@ -839,19 +890,24 @@ void dram_t::visualizer_print(gzFile visualizer_file) {
   n_req_partial = 0;
 
   // dram access type classification
+  static const struct {
+    const char *name;
+    mem_access_type type;
+  } access_rows[] = {{"dramglobal_acc_r", GLOBAL_ACC_R},
+                     {"dramglobal_acc_w", GLOBAL_ACC_W},
+                     {"dramlocal_acc_r", LOCAL_ACC_R},
+                     {"dramlocal_acc_w", LOCAL_ACC_W},
+                     {"dramconst_acc_r", CONST_ACC_R},
+                     {"dramtexture_acc_r", TEXTURE_ACC_R}};
   for (unsigned j = 0; j < m_config->nbk; j++) {
-    gzprintf(visualizer_file, "dramglobal_acc_r: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[GLOBAL_ACC_R][id][j]);
-    gzprintf(visualizer_file, "dramglobal_acc_w: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[GLOBAL_ACC_W][id][j]);
-    gzprintf(visualizer_file, "dramlocal_acc_r: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[LOCAL_ACC_R][id][j]);
-    gzprintf(visualizer_file, "dramlocal_acc_w: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[LOCAL_ACC_W][id][j]);
-    gzprintf(visualizer_file, "dramconst_acc_r: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[CONST_ACC_R][id][j]);
-    gzprintf(visualizer_file, "dramtexture_acc_r: %u %u %u\n", id, j,
-             m_stats->mem_access_type_stats[TEXTURE_ACC_R][id][j]);
+    for (unsigned r = 0; r < sizeof(access_rows) / sizeof(access_rows[0]);
+         r++) {
+      log->begin_row(access_rows[r].name);
+      log->add(id);
+      log->add(j);
+      log->add(m_stats->mem_access_type_stats[access_rows[r].type][id][j]);
+      log->end_row();
+    }
   }
 }
 
@@ -121,7 +121,7 @@ class dram_t {
   unsigned que_length() const;
   bool returnq_full() const;
   unsigned int queue_limit() const;
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
 
   class mem_fetch *return_queue_pop();
   class mem_fetch *return_queue_top();
@@ -155,6 +155,13 @@ class dram_t {
   bool issue_col_command(int j);
   bool issue_row_command(int j);
 
+  // A quiescent channel has no queued or in-service requests and all timing
+  // constraints have expired; until the next push() every cycle() is then
+  // identical, so only its statistics need to be advanced (idle_cycle()).
+  bool quiescent() const;
+  void idle_cycle();
+  bool m_quiescent;
+
   unsigned int RRDc;
   unsigned int CCDc;
   unsigned int RTWc;  // read to write penalty applies across banks
@@ -32,6 +32,132 @@
 #include "gpu-sim.h"
 #include "mem_latency_stat.h"
 
+frfcfs_queue::frfcfs_queue(unsigned n_banks, unsigned capacity)
+    : m_n_banks(n_banks), m_capacity(capacity ? capacity : 64) {
+  m_log2_slots = 4;
+  while ((1u << m_log2_slots) < 2 * m_capacity) m_log2_slots++;
+  m_node.resize(m_capacity);
+  m_bin.resize(m_capacity);
+  for (int i = m_capacity - 1; i >= 0; i--) {
+    m_free_node.push_back(i);
+    m_free_bin.push_back(i);
+  }
+  bank_t empty_bank = {-1, -1, 0};
+  m_bank.assign(n_banks, empty_bank);
+  m_slot.assign(n_banks << m_log2_slots, -1);
+}
+
+// only reached when the scheduler queue size is unbounded (0)
+void frfcfs_queue::grow() {
+  unsigned old_capacity = m_capacity;
+  m_capacity *= 2;
+  m_node.resize(m_capacity);
+  m_bin.resize(m_capacity);
+  for (int i = m_capacity - 1; i >= (int)old_capacity; i--) {
+    m_free_node.push_back(i);
+    m_free_bin.push_back(i);
+  }
+  if ((1u << m_log2_slots) >= 2 * m_capacity) return;
+  std::vector<int> old_slot;
+  old_slot.swap(m_slot);
+  unsigned old_n_slots = 1u << m_log2_slots;
+  m_log2_slots++;
+  m_slot.assign(m_n_banks << m_log2_slots, -1);
+  for (unsigned bank = 0; bank < m_n_banks; bank++) {
+    for (unsigned i = 0; i < old_n_slots; i++) {
+      int bin = old_slot[bank * old_n_slots + i];
+      if (bin != -1) insert_slot(bank, bin);
+    }
+  }
+}
+
+int frfcfs_queue::find_row(unsigned bank, unsigned row) const {
+  const int *s = slots(bank);
+  unsigned mask = (1u << m_log2_slots) - 1;
+  for (unsigned i = slot_of(row);; i = (i + 1) & mask) {
+    if (s[i] == -1) return -1;
+    if (m_bin[s[i]].row == row) return s[i];
+  }
+}
+
+void frfcfs_queue::insert_slot(unsigned bank, int bin) {
+  int *s = slots(bank);
+  unsigned mask = (1u << m_log2_slots) - 1;
+  unsigned i = slot_of(m_bin[bin].row);
+  while (s[i] != -1) i = (i + 1) & mask;
+  s[i] = bin;
+}
+
+// linear probing without tombstones: entries after the removed one are
+// shifted back into the hole unless that would move them before their home
+// slot
+void frfcfs_queue::erase_slot(unsigned bank, unsigned row) {
+  int *s = slots(bank);
+  unsigned mask = (1u << m_log2_slots) - 1;
+  unsigned i = slot_of(row);
+  while (m_bin[s[i]].row != row) i = (i + 1) & mask;
+  for (unsigned j = (i + 1) & mask; s[j] != -1; j = (j + 1) & mask) {
+    unsigned k = slot_of(m_bin[s[j]].row);
+    if ((j > i) ? (k <= i || k > j) : (k <= i && k > j)) {
+      s[i] = s[j];
+      i = j;
+    }
+  }
+  s[i] = -1;
+}
+
+void frfcfs_queue::push(dram_req_t *req) {
+  if (m_free_node.empty()) grow();
+  int n = m_free_node.back();
+  m_free_node.pop_back();
+  bank_t &b = m_bank[req->bk];
+  m_node[n].req = req;
+  m_node[n].newer = -1;
+  m_node[n].older = b.newest;
+  m_node[n].row_next = -1;
+  if (b.newest != -1)
+    m_node[b.newest].newer = n;
+  else
+    b.oldest = n;
+  b.newest = n;
+  b.size++;
+
+  int bin = find_row(req->bk, req->row);
+  if (bin == -1) {
+    bin = m_free_bin.back();
+    m_free_bin.pop_back();
+    m_bin[bin].row = req->row;
+    m_bin[bin].head = n;
+    m_bin[bin].tail = n;
+    insert_slot(req->bk, bin);
+  } else {
+    m_node[m_bin[bin].tail].row_next = n;
+    m_bin[bin].tail = n;
+  }
+}
+
+bool frfcfs_queue::pop_row(unsigned bank, int bin) {
+  int n = m_bin[bin].head;
+  const node_t &nd = m_node[n];
+  bank_t &b = m_bank[bank];
+  if (nd.newer != -1)
+    m_node[nd.newer].older = nd.older;
+  else
+    b.newest = nd.older;
+  if (nd.older != -1)
+    m_node[nd.older].newer = nd.newer;
+  else
+    b.oldest = nd.newer;
+  b.size--;
+  m_free_node.push_back(n);
+
+  m_bin[bin].head = nd.row_next;
+  if (m_bin[bin].head != -1) return false;
+  erase_slot(bank, m_bin[bin].row);
+  m_free_bin.push_back(bin);
+  return true;
+}
+
 frfcfs_scheduler::frfcfs_scheduler(const memory_config *config, dram_t *dm,
                                    memory_stats_t *stats) {
   m_config = config;
@@ -39,32 +165,23 @@ frfcfs_scheduler::frfcfs_scheduler(const memory_config *config, dram_t *dm,
   m_num_pending = 0;
   m_num_write_pending = 0;
   m_dram = dm;
-  m_queue = new std::list<dram_req_t *>[m_config->nbk];
-  m_bins = new std::map<
-      unsigned, std::list<std::list<dram_req_t *>::iterator> >[m_config->nbk];
-  m_last_row =
-      new std::list<std::list<dram_req_t *>::iterator> *[m_config->nbk];
+  m_queue = new frfcfs_queue(m_config->nbk,
+                             m_config->gpgpu_frfcfs_dram_sched_queue_size);
+  m_last_row = new int[m_config->nbk];
   curr_row_service_time = new unsigned[m_config->nbk];
   row_service_timestamp = new unsigned[m_config->nbk];
   for (unsigned i = 0; i < m_config->nbk; i++) {
-    m_queue[i].clear();
-    m_bins[i].clear();
-    m_last_row[i] = NULL;
+    m_last_row[i] = -1;
     curr_row_service_time[i] = 0;
     row_service_timestamp[i] = 0;
   }
+  m_write_queue = NULL;
+  m_last_write_row = NULL;
   if (m_config->seperate_write_queue_enabled) {
-    m_write_queue = new std::list<dram_req_t *>[m_config->nbk];
-    m_write_bins = new std::map<
-        unsigned, std::list<std::list<dram_req_t *>::iterator> >[m_config->nbk];
-    m_last_write_row =
-        new std::list<std::list<dram_req_t *>::iterator> *[m_config->nbk];
-
-    for (unsigned i = 0; i < m_config->nbk; i++) {
-      m_write_queue[i].clear();
-      m_write_bins[i].clear();
-      m_last_write_row[i] = NULL;
-    }
+    m_write_queue = new frfcfs_queue(
+        m_config->nbk, m_config->gpgpu_frfcfs_dram_write_queue_size);
+    m_last_write_row = new int[m_config->nbk];
+    for (unsigned i = 0; i < m_config->nbk; i++) m_last_write_row[i] = -1;
   }
   m_mode = READ_MODE;
 }
@@ -73,16 +190,11 @@ void frfcfs_scheduler::add_req(dram_req_t *req) {
   if (m_config->seperate_write_queue_enabled && req->data->is_write()) {
     assert(m_num_write_pending < m_config->gpgpu_frfcfs_dram_write_queue_size);
     m_num_write_pending++;
-    m_write_queue[req->bk].push_front(req);
-    std::list<dram_req_t *>::iterator ptr = m_write_queue[req->bk].begin();
-    m_write_bins[req->bk][req->row].push_front(ptr);  // newest reqs to the
-                                                      // front
+    m_write_queue->push(req);
   } else {
     assert(m_num_pending < m_config->gpgpu_frfcfs_dram_sched_queue_size);
     m_num_pending++;
-    m_queue[req->bk].push_front(req);
-    std::list<dram_req_t *>::iterator ptr = m_queue[req->bk].begin();
-    m_bins[req->bk][req->row].push_front(ptr);  // newest reqs to the front
+    m_queue->push(req);
   }
 }
 
@@ -109,11 +221,8 @@ void frfcfs_scheduler::data_collection(unsigned int bank) {
 dram_req_t *frfcfs_scheduler::schedule(unsigned bank, unsigned curr_row) {
   // row
   bool rowhit = true;
-  std::list<dram_req_t *> *m_current_queue = m_queue;
-  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> >
-      *m_current_bins = m_bins;
-  std::list<std::list<dram_req_t *>::iterator> **m_current_last_row =
-      m_last_row;
+  frfcfs_queue *m_current_queue = m_queue;
+  int *m_current_last_row = m_last_row;
 
   if (m_config->seperate_write_queue_enabled) {
     if (m_mode == READ_MODE &&
@@ -131,30 +240,26 @@ dram_req_t *frfcfs_scheduler::schedule(unsigned bank, unsigned curr_row) {
 
   if (m_mode == WRITE_MODE) {
     m_current_queue = m_write_queue;
-    m_current_bins = m_write_bins;
     m_current_last_row = m_last_write_row;
   }
 
-  if (m_current_last_row[bank] == NULL) {
-    if (m_current_queue[bank].empty()) return NULL;
-
-    std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> >::iterator
-        bin_ptr = m_current_bins[bank].find(curr_row);
-    if (bin_ptr == m_current_bins[bank].end()) {
-      dram_req_t *req = m_current_queue[bank].back();
-      bin_ptr = m_current_bins[bank].find(req->row);
-      assert(bin_ptr !=
-             m_current_bins[bank].end());  // where did the request go???
-      m_current_last_row[bank] = &(bin_ptr->second);
+  if (m_current_last_row[bank] == -1) {
+    if (m_current_queue->empty(bank)) return NULL;
+
+    int bin = m_current_queue->find_row(bank, curr_row);
+    if (bin == -1) {
+      dram_req_t *req = m_current_queue->oldest(bank);
+      bin = m_current_queue->find_row(bank, req->row);
+      assert(bin != -1);  // where did the request go???
+      m_current_last_row[bank] = bin;
       data_collection(bank);
       rowhit = false;
     } else {
-      m_current_last_row[bank] = &(bin_ptr->second);
+      m_current_last_row[bank] = bin;
       rowhit = true;
     }
   }
-  std::list<dram_req_t *>::iterator next = m_current_last_row[bank]->back();
-  dram_req_t *req = (*next);
+  dram_req_t *req = m_current_queue->row_front(m_current_last_row[bank]);
 
   // rowblp stats
   m_dram->access_num++;
@@ -174,13 +279,8 @@ dram_req_t *frfcfs_scheduler::schedule(unsigned bank, unsigned curr_row) {
 
   m_stats->concurrent_row_access[m_dram->id][bank]++;
   m_stats->row_access[m_dram->id][bank]++;
-  m_current_last_row[bank]->pop_back();
-
-  m_current_queue[bank].erase(next);
-  if (m_current_last_row[bank]->empty()) {
-    m_current_bins[bank].erase(req->row);
-    m_current_last_row[bank] = NULL;
-  }
+  if (m_current_queue->pop_row(bank, m_current_last_row[bank]))
+    m_current_last_row[bank] = -1;
 #ifdef DEBUG_FAST_IDEAL_SCHED
   if (req)
     printf("%08u : DRAM(%u) scheduling memory request to bank=%u, row=%u\n",
@@ -198,9 +298,17 @@ dram_req_t *frfcfs_scheduler::schedule(unsigned bank, unsigned curr_row) {
   return req;
 }
 
+bool frfcfs_scheduler::idle() const {
+  if (m_num_pending || m_num_write_pending) return false;
+  // with an empty write queue the scheduler only stays in read mode
+  return !m_config->seperate_write_queue_enabled ||
+         (m_mode == READ_MODE &&
+          m_num_write_pending < m_config->write_high_watermark);
+}
+
 void frfcfs_scheduler::print(FILE *fp) {
   for (unsigned b = 0; b < m_config->nbk; b++) {
-    printf(" %u: queue length = %u\n", b, (unsigned)m_queue[b].size());
+    printf(" %u: queue length = %u\n", b, m_queue->size(b));
   }
 }
 
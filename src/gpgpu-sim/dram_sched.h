@@ -29,8 +29,7 @@
 #ifndef dram_sched_h_INCLUDED
 #define dram_sched_h_INCLUDED
 
-#include <list>
-#include <map>
+#include <vector>
 #include "dram.h"
 #include "gpu-misc.h"
 #include "gpu-sim.h"
@@ -38,6 +37,67 @@
 
 enum memory_mode { READ_MODE = 0, WRITE_MODE };
 
+// Requests waiting in one DRAM channel, kept per bank in arrival order and,
+// within a bank, binned per row. Requests and row bins live in preallocated
+// pools linked by index, and each bank finds its bins through an
+// open-addressed row table, so queueing and scheduling never allocate. The
+// pools only grow when the scheduler queue is unbounded.
+class frfcfs_queue {
+ public:
+  frfcfs_queue(unsigned n_banks, unsigned capacity);
+
+  void push(dram_req_t *req);
+  bool empty(unsigned bank) const { return m_bank[bank].size == 0; }
+  unsigned size(unsigned bank) const { return m_bank[bank].size; }
+  // oldest request queued for a bank
+  dram_req_t *oldest(unsigned bank) const {
+    return m_node[m_bank[bank].oldest].req;
+  }
+  // row bin holding requests to (bank, row), -1 if there are none
+  int find_row(unsigned bank, unsigned row) const;
+  // oldest request of a row bin
+  dram_req_t *row_front(int bin) const { return m_node[m_bin[bin].head].req; }
+  // remove the oldest request of a row bin, true if that emptied (and
+  // released) the bin
+  bool pop_row(unsigned bank, int bin);
+
+ private:
+  struct node_t {
+    dram_req_t *req;
+    int newer, older;  // bank list
+    int row_next;      // next newer request to the same row
+  };
+  struct bin_t {
+    unsigned row;
+    int head, tail;  // oldest and newest request to the row
+  };
+  struct bank_t {
+    int newest, oldest;
+    unsigned size;
+  };
+
+  unsigned slot_of(unsigned row) const {
+    return (row * 2654435761u) >> (32 - m_log2_slots);
+  }
+  int *slots(unsigned bank) { return &m_slot[bank << m_log2_slots]; }
+  const int *slots(unsigned bank) const {
+    return &m_slot[bank << m_log2_slots];
+  }
+  void insert_slot(unsigned bank, int bin);
+  void erase_slot(unsigned bank, unsigned row);
+  void grow();
+
+  unsigned m_n_banks;
+  unsigned m_capacity;
+  unsigned m_log2_slots;  // row table size per bank, kept >= 2 * m_capacity
+  std::vector<node_t> m_node;
+  std::vector<bin_t> m_bin;
+  std::vector<int> m_free_node;
+  std::vector<int> m_free_bin;
+  std::vector<bank_t> m_bank;
+  std::vector<int> m_slot;  // bin index or -1, per bank
+};
+
 class frfcfs_scheduler {
  public:
   frfcfs_scheduler(const memory_config *config, dram_t *dm,
@@ -48,23 +108,22 @@ class frfcfs_scheduler {
   void print(FILE *fp);
   unsigned num_pending() const { return m_num_pending; }
   unsigned num_write_pending() const { return m_num_write_pending; }
+  // true if schedule() would return NULL without changing any state
+  bool idle() const;
 
  private:
   const memory_config *m_config;
   dram_t *m_dram;
   unsigned m_num_pending;
   unsigned m_num_write_pending;
-  std::list<dram_req_t *> *m_queue;
-  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> > *m_bins;
-  std::list<std::list<dram_req_t *>::iterator> **m_last_row;
+  frfcfs_queue *m_queue;
+  int *m_last_row;  // row bin being serviced per bank, -1 if none
   unsigned *curr_row_service_time;  // one set of variables for each bank.
   unsigned *row_service_timestamp;  // tracks when scheduler began servicing
                                     // current row
 
-  std::list<dram_req_t *> *m_write_queue;
-  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> >
-      *m_write_bins;
-  std::list<std::list<dram_req_t *>::iterator> **m_last_write_row;
+  frfcfs_queue *m_write_queue;
+  int *m_last_write_row;
 
   enum memory_mode m_mode;
   memory_stats_t *m_stats;
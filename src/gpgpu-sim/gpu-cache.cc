@@ -169,14 +169,26 @@ unsigned l2_cache_config::set_index(new_addr_type addr) const {
 }
 
 tag_array::~tag_array() {
-  unsigned cache_lines_num = m_config.get_max_num_lines();
-  for (unsigned i = 0; i < cache_lines_num; ++i) delete m_lines[i];
+  if (m_line_blocks || m_sector_blocks) {
+    delete[] m_line_blocks;
+    delete[] m_sector_blocks;
+  } else {
+    unsigned cache_lines_num = m_config.get_max_num_lines();
+    for (unsigned i = 0; i < cache_lines_num; ++i) delete m_lines[i];
+  }
   delete[] m_lines;
+  delete[] m_tags;
 }
 
 tag_array::tag_array(cache_config &config, int core_id, int type_id,
                      cache_block_t **new_lines)
-    : m_config(config), m_lines(new_lines) {
+    : m_config(config),
+      m_lines(new_lines),
+      m_line_blocks(NULL),
+      m_sector_blocks(NULL) {
+  unsigned cache_lines_num = config.get_max_num_lines();
+  m_tags = new new_addr_type[cache_lines_num];
+  for (unsigned i = 0; i < cache_lines_num; ++i) m_tags[i] = m_lines[i]->m_tag;
   init(core_id, type_id);
 }
 
@@ -185,18 +197,22 @@ void tag_array::update_cache_parameters(cache_config &config) {
 }
 
 tag_array::tag_array(cache_config &config, int core_id, int type_id)
-    : m_config(config) {
+    : m_config(config), m_line_blocks(NULL), m_sector_blocks(NULL) {
   // assert( m_config.m_write_policy == READ_ONLY ); Old assert
   unsigned cache_lines_num = config.get_max_num_lines();
   m_lines = new cache_block_t *[cache_lines_num];
   if (config.m_cache_type == NORMAL) {
+    m_line_blocks = new line_cache_block[cache_lines_num];
     for (unsigned i = 0; i < cache_lines_num; ++i)
-      m_lines[i] = new line_cache_block();
+      m_lines[i] = &m_line_blocks[i];
   } else if (config.m_cache_type == SECTOR) {
+    m_sector_blocks = new sector_cache_block[cache_lines_num];
     for (unsigned i = 0; i < cache_lines_num; ++i)
-      m_lines[i] = new sector_cache_block();
+      m_lines[i] = &m_sector_blocks[i];
   } else
     assert(0);
+  m_tags = new new_addr_type[cache_lines_num];
+  for (unsigned i = 0; i < cache_lines_num; ++i) m_tags[i] = m_lines[i]->m_tag;
 
   init(core_id, type_id);
 }
@@ -249,50 +265,67 @@ enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx,
   // assert( m_config.m_write_policy == READ_ONLY );
   unsigned set_index = m_config.set_index(addr);
   new_addr_type tag = m_config.tag(addr);
+  if (m_config.m_cache_type == SECTOR)
+    return probe_set<sector_cache_block>(set_index, tag, idx, mask, is_write);
+  return probe_set<line_cache_block>(set_index, tag, idx, mask, is_write);
+}
+
+template <class BLOCK>
+enum cache_request_status tag_array::probe_set(unsigned set_index,
+                                               new_addr_type tag,
+                                               unsigned &idx,
+                                               mem_access_sector_mask_t mask,
+                                               bool is_write) const {
+  const unsigned assoc = m_config.m_assoc;
+  const unsigned first = set_index * assoc;
+  const new_addr_type *tags = m_tags + first;
+
+  // check for hit or pending hit; a way whose tag matches but that holds no
+  // valid sector is skipped, as is any way whose tag does not match
+  for (unsigned way = 0; way < assoc; way++) {
+    if (tags[way] != tag) continue;
+    unsigned index = first + way;
+    BLOCK *line = static_cast<BLOCK *>(m_lines[index]);
+    enum cache_block_state status = line->get_status(mask);
+    if (status == RESERVED) {
+      idx = index;
+      return HIT_RESERVED;
+    } else if (status == VALID) {
+      idx = index;
+      return HIT;
+    } else if (status == MODIFIED) {
+      idx = index;
+      if ((!is_write && line->is_readable(mask)) || is_write) {
+        return HIT;
+      } else {
+        return SECTOR_MISS;
+      }
+    } else if (line->is_valid_line()) {
+      idx = index;
+      return SECTOR_MISS;
+    }
+  }
+
+  // percentage of dirty lines in the cache
+  // number of dirty lines / total lines in the cache
+  float dirty_line_percentage =
+      ((float)m_dirty / (m_config.m_nset * m_config.m_assoc)) * 100;
+  bool evict_dirty = dirty_line_percentage >= m_config.m_wr_percent;
 
   unsigned invalid_line = (unsigned)-1;
   unsigned valid_line = (unsigned)-1;
   unsigned long long valid_timestamp = (unsigned)-1;
 
   bool all_reserved = true;
-  // check for hit or pending hit
-  for (unsigned way = 0; way < m_config.m_assoc; way++) {
-    unsigned index = set_index * m_config.m_assoc + way;
-    cache_block_t *line = m_lines[index];
-    if (line->m_tag == tag) {
-      if (line->get_status(mask) == RESERVED) {
-        idx = index;
-        return HIT_RESERVED;
-      } else if (line->get_status(mask) == VALID) {
-        idx = index;
-        return HIT;
-      } else if (line->get_status(mask) == MODIFIED) {
-        if ((!is_write && line->is_readable(mask)) || is_write) {
-          idx = index;
-          return HIT;
-        } else {
-          idx = index;
-          return SECTOR_MISS;
-        }
-
-      } else if (line->is_valid_line() && line->get_status(mask) == INVALID) {
-        idx = index;
-        return SECTOR_MISS;
-      } else {
-        assert(line->get_status(mask) == INVALID);
-      }
-    }
+  for (unsigned way = 0; way < assoc; way++) {
+    unsigned index = first + way;
+    BLOCK *line = static_cast<BLOCK *>(m_lines[index]);
     if (!line->is_reserved_line()) {
-      // percentage of dirty lines in the cache
-      // number of dirty lines / total lines in the cache
-      float dirty_line_percentage =
-          ((float)m_dirty / (m_config.m_nset * m_config.m_assoc)) * 100;
-      // If the cacheline is from a load op (not modified), 
+      // If the cacheline is from a load op (not modified),
       // or the total dirty cacheline is above a specific value,
       // Then this cacheline is eligible to be considered for replacement candidate
       // i.e. Only evict clean cachelines until total dirty cachelines reach the limit.
-      if (!line->is_modified_line() ||
-          dirty_line_percentage >= m_config.m_wr_percent) {
+      if (!line->is_modified_line() || evict_dirty) {
         all_reserved = false;
         if (line->is_invalid_line()) {
           invalid_line = index;
@@ -330,6 +363,13 @@ enum cache_request_status tag_array::probe(new_addr_type addr, unsigned &idx,
   return MISS;
 }
 
+void tag_array::allocate_line(unsigned idx, new_addr_type addr, unsigned time,
+                              mem_access_sector_mask_t mask) {
+  new_addr_type tag = m_config.tag(addr);
+  m_lines[idx]->allocate(tag, m_config.block_addr(addr), time, mask);
+  m_tags[idx] = tag;
+}
+
 enum cache_request_status tag_array::access(new_addr_type addr, unsigned time,
                                             unsigned &idx, mem_fetch *mf) {
   bool wb = false;
@@ -366,8 +406,7 @@ enum cache_request_status tag_array::access(new_addr_type addr, unsigned time,
                            m_lines[idx]->get_dirty_sector_mask());
           m_dirty--;
         }
-        m_lines[idx]->allocate(m_config.tag(addr), m_config.block_addr(addr),
-                               time, mf->get_access_sector_mask());
+        allocate_line(idx, addr, time, mf->get_access_sector_mask());
       }
       break;
     case SECTOR_MISS:
@@ -418,8 +457,7 @@ void tag_array::fill(new_addr_type addr, unsigned time,
   // assert(status==MISS||status==SECTOR_MISS); // MSHR should have prevented
   // redundant memory request
   if (status == MISS) {
-    m_lines[idx]->allocate(m_config.tag(addr), m_config.block_addr(addr), time,
-                           mask);
+    allocate_line(idx, addr, time, mask);
   } else if (status == SECTOR_MISS) {
     assert(m_config.m_cache_type == SECTOR);
     ((sector_cache_block *)m_lines[idx])->allocate_sector(time, mask);
@@ -547,39 +585,107 @@ bool was_writeallocate_sent(const std::list<cache_event> &events) {
 /****************************************************************** MSHR
  * ******************************************************************/
 
+const unsigned mshr_table::NO_ENTRY;
+
+mshr_table::mshr_table(unsigned num_entries, unsigned max_merged)
+    : m_num_entries(num_entries),
+      m_max_merged(max_merged),
+      m_entries(num_entries),
+      m_merged(num_entries * max_merged, (mem_fetch *)NULL),
+      m_current_response(num_entries ? num_entries : 1),
+      m_response_head(0),
+      m_response_count(0) {
+  m_free.reserve(num_entries);
+  for (unsigned e = num_entries; e > 0; e--) m_free.push_back(e - 1);
+  unsigned bits = 1;
+  while ((1u << bits) < 2 * num_entries) bits++;
+  m_index.assign(1u << bits, NO_ENTRY);
+  m_index_mask = (1u << bits) - 1;
+  m_index_shift = 64 - bits;
+}
+
+unsigned mshr_table::home_slot(new_addr_type block_addr) const {
+  // Fibonacci hashing; block addresses have their low bits clear, so take
+  // the high bits of the product
+  return (unsigned)(((unsigned long long)block_addr * 0x9E3779B97F4A7C15ULL) >>
+                    m_index_shift);
+}
+
+unsigned mshr_table::find_slot(new_addr_type block_addr) const {
+  for (unsigned slot = home_slot(block_addr);;
+       slot = (slot + 1) & m_index_mask) {
+    unsigned e = m_index[slot];
+    if (e == NO_ENTRY) return NO_ENTRY;
+    if (m_entries[e].m_block_addr == block_addr) return slot;
+  }
+}
+
+unsigned mshr_table::allocate(new_addr_type block_addr) {
+  assert(!m_free.empty());
+  unsigned e = m_free.back();
+  m_free.pop_back();
+  m_entries[e].m_block_addr = block_addr;
+  m_entries[e].m_head = 0;
+  m_entries[e].m_count = 0;
+  m_entries[e].m_has_atomic = false;
+  unsigned slot = home_slot(block_addr);
+  while (m_index[slot] != NO_ENTRY) slot = (slot + 1) & m_index_mask;
+  m_index[slot] = e;
+  return e;
+}
+
+void mshr_table::release(unsigned e) {
+  unsigned hole = find_slot(m_entries[e].m_block_addr);
+  assert(hole != NO_ENTRY && m_index[hole] == e);
+  m_index[hole] = NO_ENTRY;
+  // backward shift: pull later members of the probe run into the hole so
+  // lookups never need tombstones
+  for (unsigned slot = (hole + 1) & m_index_mask; m_index[slot] != NO_ENTRY;
+       slot = (slot + 1) & m_index_mask) {
+    unsigned home = home_slot(m_entries[m_index[slot]].m_block_addr);
+    if (((slot - home) & m_index_mask) >= ((slot - hole) & m_index_mask)) {
+      m_index[hole] = m_index[slot];
+      m_index[slot] = NO_ENTRY;
+      hole = slot;
+    }
+  }
+  m_free.push_back(e);
+}
+
 /// Checks if there is a pending request to the lower memory level already
 bool mshr_table::probe(new_addr_type block_addr) const {
-  table::const_iterator a = m_data.find(block_addr);
-  return a != m_data.end();
+  return find_slot(block_addr) != NO_ENTRY;
 }
 
 /// Checks if there is space for tracking a new memory access
 bool mshr_table::full(new_addr_type block_addr) const {
-  table::const_iterator i = m_data.find(block_addr);
-  if (i != m_data.end())
-    return i->second.m_list.size() >= m_max_merged;
+  unsigned e = find(block_addr);
+  if (e != NO_ENTRY)
+    return m_entries[e].m_count >= m_max_merged;
   else
-    return m_data.size() >= m_num_entries;
+    return m_free.empty();
 }
 
 /// Add or merge this access
 void mshr_table::add(new_addr_type block_addr, mem_fetch *mf) {
-  m_data[block_addr].m_list.push_back(mf);
-  assert(m_data.size() <= m_num_entries);
-  assert(m_data[block_addr].m_list.size() <= m_max_merged);
+  unsigned e = find(block_addr);
+  if (e == NO_ENTRY) e = allocate(block_addr);
+  assert(m_entries[e].m_count < m_max_merged);
+  merged(e, m_entries[e].m_count) = mf;
+  m_entries[e].m_count++;
   // indicate that this MSHR entry contains an atomic operation
   if (mf->isatomic()) {
-    m_data[block_addr].m_has_atomic = true;
+    m_entries[e].m_has_atomic = true;
   }
 }
 
 /// check is_read_after_write_pending
 bool mshr_table::is_read_after_write_pending(new_addr_type block_addr) {
-  std::list<mem_fetch *> my_list = m_data[block_addr].m_list;
+  unsigned e = find(block_addr);
+  if (e == NO_ENTRY) return false;
   bool write_found = false;
-  for (std::list<mem_fetch *>::iterator it = my_list.begin();
-       it != my_list.end(); ++it) {
-    if ((*it)->is_write())  // Pending Write Request
+  for (unsigned n = 0; n < m_entries[e].m_count; n++) {
+    if (merged(e, n)->is_write())  // Pending Write Request
       write_found = true;
     else if (write_found)  // Pending Read Request and we found previous Write
       return true;
@@ -591,36 +697,44 @@ bool mshr_table::is_read_after_write_pending(new_addr_type block_addr) {
 /// Accept a new cache fill response: mark entry ready for processing
 void mshr_table::mark_ready(new_addr_type block_addr, bool &has_atomic) {
   assert(!busy());
-  table::iterator a = m_data.find(block_addr);
-  assert(a != m_data.end());
-  m_current_response.push_back(block_addr);
-  has_atomic = a->second.m_has_atomic;
-  assert(m_current_response.size() <= m_data.size());
+  unsigned e = find(block_addr);
+  assert(e != NO_ENTRY);
+  assert(m_response_count < m_num_entries - m_free.size());
+  m_current_response[(m_response_head + m_response_count) %
+                     m_current_response.size()] = e;
+  m_response_count++;
+  has_atomic = m_entries[e].m_has_atomic;
 }
 
 /// Returns next ready access
 mem_fetch *mshr_table::next_access() {
   assert(access_ready());
-  new_addr_type block_addr = m_current_response.front();
-  assert(!m_data[block_addr].m_list.empty());
-  mem_fetch *result = m_data[block_addr].m_list.front();
-  m_data[block_addr].m_list.pop_front();
-  if (m_data[block_addr].m_list.empty()) {
+  unsigned e = m_current_response[m_response_head];
+  mshr_entry &entry = m_entries[e];
+  assert(entry.m_count);
+  mem_fetch *result = merged(e, 0);
+  entry.m_head = (entry.m_head + 1) % m_max_merged;
+  entry.m_count--;
+  if (entry.m_count == 0) {
     // release entry
-    m_data.erase(block_addr);
-    m_current_response.pop_front();
+    release(e);
+    m_response_head = (m_response_head + 1) % m_current_response.size();
+    m_response_count--;
   }
   return result;
 }
 
 void mshr_table::display(FILE *fp) const {
   fprintf(fp, "MSHR contents\n");
-  for (table::const_iterator e = m_data.begin(); e != m_data.end(); ++e) {
-    unsigned block_addr = e->first;
-    fprintf(fp, "MSHR: tag=0x%06x, atomic=%d %zu entries : ", block_addr,
-            e->second.m_has_atomic, e->second.m_list.size());
-    if (!e->second.m_list.empty()) {
-      mem_fetch *mf = e->second.m_list.front();
+  for (unsigned slot = 0; slot < m_index.size(); slot++) {
+    unsigned e = m_index[slot];
+    if (e == NO_ENTRY) continue;
+    const mshr_entry &entry = m_entries[e];
+    unsigned block_addr = entry.m_block_addr;
+    fprintf(fp, "MSHR: tag=0x%06x, atomic=%d %u entries : ", block_addr,
+            entry.m_has_atomic, entry.m_count);
+    if (entry.m_count) {
+      mem_fetch *mf = m_merged[e * m_max_merged + entry.m_head];
       fprintf(fp, "%p :", mf);
       mf->print(fp);
     } else {
@@ -1074,12 +1188,11 @@ void baseline_cache::cycle() {
 void baseline_cache::fill(mem_fetch *mf, unsigned time) {
   if (m_config.m_mshr_type == SECTOR_ASSOC) {
     assert(mf->get_original_mf());
-    extra_mf_fields_lookup::iterator e =
-        m_extra_mf_fields.find(mf->get_original_mf());
-    assert(e != m_extra_mf_fields.end());
-    e->second.pending_read--;
+    mf_cache_fields *e = mf->get_original_mf()->get_cache_fields(this);
+    assert(e);
+    e->pending_read--;
 
-    if (e->second.pending_read > 0) {
+    if (e->pending_read > 0) {
       // wait for the other requests to come back
       delete mf;
       return;
@@ -1090,22 +1203,21 @@ void baseline_cache::fill(mem_fetch *mf, unsigned time) {
     }
   }
 
-  extra_mf_fields_lookup::iterator e = m_extra_mf_fields.find(mf);
-  assert(e != m_extra_mf_fields.end());
-  assert(e->second.m_valid);
-  mf->set_data_size(e->second.m_data_size);
-  mf->set_addr(e->second.m_addr);
+  mf_cache_fields *e = mf->get_cache_fields(this);
+  assert(e);
+  mf->set_data_size(e->m_data_size);
+  mf->set_addr(e->m_addr);
   if (m_config.m_alloc_policy == ON_MISS)
-    m_tag_array->fill(e->second.m_cache_index, time, mf);
+    m_tag_array->fill(e->m_cache_index, time, mf);
   else if (m_config.m_alloc_policy == ON_FILL) {
-    m_tag_array->fill(e->second.m_block_addr, time, mf, mf->is_write());
+    m_tag_array->fill(e->m_block_addr, time, mf, mf->is_write());
   } else
     abort();
   bool has_atomic = false;
-  m_mshrs.mark_ready(e->second.m_block_addr, has_atomic);
+  m_mshrs.mark_ready(e->m_block_addr, has_atomic);
   if (has_atomic) {
     assert(m_config.m_alloc_policy == ON_MISS);
-    cache_block_t *block = m_tag_array->get_block(e->second.m_cache_index);
+    cache_block_t *block = m_tag_array->get_block(e->m_cache_index);
     if (!block->is_modified_line()) {
       m_tag_array->inc_dirty();
     }
@@ -1114,14 +1226,13 @@ void baseline_cache::fill(mem_fetch *mf, unsigned time) {
                                                       // atomic operation
     block->set_byte_mask(mf);
   }
-  m_extra_mf_fields.erase(mf);
+  mf->release_cache_fields(this);
   m_bandwidth_management.use_fill_port(mf);
 }
 
 /// Checks if mf is waiting to be filled by lower memory level
 bool baseline_cache::waiting_for_fill(mem_fetch *mf) {
-  extra_mf_fields_lookup::iterator e = m_extra_mf_fields.find(mf);
-  return e != m_extra_mf_fields.end();
+  return mf->get_cache_fields(this) != NULL;
 }
 
 void baseline_cache::print(FILE *fp, unsigned &accesses,
@@ -1178,8 +1289,14 @@ void baseline_cache::send_read_request(new_addr_type addr,
       m_tag_array->access(block_addr, time, cache_index, wb, evicted, mf);
 
     m_mshrs.add(mshr_addr, mf);
-    m_extra_mf_fields[mf] = extra_mf_fields(
-        mshr_addr, mf->get_addr(), cache_index, mf->get_data_size(), m_config);
+    mf_cache_fields &f = mf->add_cache_fields(this);
+    f.m_block_addr = mshr_addr;
+    f.m_addr = mf->get_addr();
+    f.m_cache_index = cache_index;
+    f.m_data_size = mf->get_data_size();
+    f.pending_read = m_config.m_mshr_type == SECTOR_ASSOC
+                         ? m_config.m_line_sz / SECTOR_SIZE
+                         : 0;
     mf->set_data_size(m_config.get_atom_sz());
     mf->set_addr(mshr_addr);
     m_miss_queue.push_back(mf);
@@ -1817,7 +1934,11 @@ enum cache_request_status tex_cache::access(new_addr_type addr, mem_fetch *mf,
   if (status == MISS) {
     // we need to send a memory request...
     unsigned rob_index = m_rob.push(rob_entry(cache_index, mf, block_addr));
-    m_extra_mf_fields[mf] = extra_mf_fields(rob_index, m_config);
+    mf_cache_fields &f = mf->add_cache_fields(this);
+    f.m_rob_index = rob_index;
+    f.pending_read = m_config.m_mshr_type == SECTOR_TEX_FIFO
+                         ? m_config.m_line_sz / SECTOR_SIZE
+                         : 0;
     mf->set_data_size(m_config.get_line_sz());
     m_tags.fill(cache_index, time, mf);  // mark block as valid
     m_request_fifo.push(mf);
@@ -1877,12 +1998,11 @@ void tex_cache::cycle() {
 void tex_cache::fill(mem_fetch *mf, unsigned time) {
   if (m_config.m_mshr_type == SECTOR_TEX_FIFO) {
     assert(mf->get_original_mf());
-    extra_mf_fields_lookup::iterator e =
-        m_extra_mf_fields.find(mf->get_original_mf());
-    assert(e != m_extra_mf_fields.end());
-    e->second.pending_read--;
+    mf_cache_fields *e = mf->get_original_mf()->get_cache_fields(this);
+    assert(e);
+    e->pending_read--;
 
-    if (e->second.pending_read > 0) {
+    if (e->pending_read > 0) {
       // wait for the other requests to come back
       delete mf;
       return;
@@ -1893,13 +2013,13 @@ void tex_cache::fill(mem_fetch *mf, unsigned time) {
     }
   }
 
-  extra_mf_fields_lookup::iterator e = m_extra_mf_fields.find(mf);
-  assert(e != m_extra_mf_fields.end());
-  assert(e->second.m_valid);
+  mf_cache_fields *e = mf->get_cache_fields(this);
+  assert(e);
   assert(!m_rob.empty());
   mf->set_status(m_rob_status, time);
 
-  unsigned rob_index = e->second.m_rob_index;
+  unsigned rob_index = e->m_rob_index;
+  mf->release_cache_fields(this);
   rob_entry &r = m_rob.peek(rob_index);
   assert(!r.m_ready);
   r.m_ready = true;
@@ -161,7 +161,7 @@ struct cache_block_t {
   new_addr_type m_block_addr;
 };
 
-struct line_cache_block : public cache_block_t {
+struct line_cache_block final : public cache_block_t {
   line_cache_block() {
     m_alloc_time = 0;
     m_fill_time = 0;
@@ -274,7 +274,7 @@ struct line_cache_block : public cache_block_t {
   mem_access_byte_mask_t m_dirty_byte_mask;
 };
 
-struct sector_cache_block : public cache_block_t {
+struct sector_cache_block final : public cache_block_t {
   sector_cache_block() { init(); }
 
   void init() {
@@ -987,11 +987,27 @@ class tag_array {
   tag_array(cache_config &config, int core_id, int type_id,
             cache_block_t **new_lines);
   void init(int core_id, int type_id);
+  // probe() specialised for the concrete block type, so that scanning a set
+  // makes no virtual calls
+  template <class BLOCK>
+  enum cache_request_status probe_set(unsigned set_index, new_addr_type tag,
+                                      unsigned &idx,
+                                      mem_access_sector_mask_t mask,
+                                      bool is_write) const;
+  void allocate_line(unsigned idx, new_addr_type addr, unsigned time,
+                     mem_access_sector_mask_t mask);
 
  protected:
   cache_config &m_config;
 
   cache_block_t **m_lines; /* nbanks x nset x assoc lines in total */
+  // The blocks m_lines points to live in one contiguous array of the
+  // concrete block type (NULL if the lines were supplied by a derived class).
+  line_cache_block *m_line_blocks;
+  sector_cache_block *m_sector_blocks;
+  // m_tags[i] mirrors m_lines[i]->m_tag so the tags of a set can be compared
+  // without touching the blocks themselves
+  new_addr_type *m_tags;
 
   unsigned m_access;
   unsigned m_miss;
@@ -1018,15 +1034,7 @@ class tag_array {
 
 class mshr_table {
  public:
-  mshr_table(unsigned num_entries, unsigned max_merged)
-      : m_num_entries(num_entries),
-        m_max_merged(max_merged)
-#if (tr1_hash_map_ismap == 0)
-        ,
-        m_data(2 * num_entries)
-#endif
-  {
-  }
+  mshr_table(unsigned num_entries, unsigned max_merged);
 
   /// Checks if there is a pending request to the lower memory level already
   bool probe(new_addr_type block_addr) const;
@@ -1039,7 +1047,7 @@ class mshr_table {
   /// Accept a new cache fill response: mark entry ready for processing
   void mark_ready(new_addr_type block_addr, bool &has_atomic);
   /// Returns true if ready accesses exist
-  bool access_ready() const { return !m_current_response.empty(); }
+  bool access_ready() const { return m_response_count != 0; }
   /// Returns next ready access
   mem_fetch *next_access();
   void display(FILE *fp) const;
@@ -1059,19 +1067,43 @@ class mshr_table {
   const unsigned m_num_entries;
   const unsigned m_max_merged;
 
+  // Entries come from a fixed pool of m_num_entries. An open-addressed index
+  // (linear probing, kept at most half full) maps a block address to its
+  // entry. The requests merged into entry e form a ring of m_max_merged
+  // slots starting at m_merged[e * m_max_merged].
   struct mshr_entry {
-    std::list<mem_fetch *> m_list;
+    new_addr_type m_block_addr;
+    unsigned m_head;   // oldest merged request within the ring
+    unsigned m_count;  // number of merged requests
     bool m_has_atomic;
-    mshr_entry() : m_has_atomic(false) {}
   };
-  typedef tr1_hash_map<new_addr_type, mshr_entry> table;
-  typedef tr1_hash_map<new_addr_type, mshr_entry> line_table;
-  table m_data;
-  line_table pending_lines;
-
-  // it may take several cycles to process the merged requests
-  bool m_current_response_ready;
-  std::list<new_addr_type> m_current_response;
+  static const unsigned NO_ENTRY = (unsigned)-1;
+
+  unsigned home_slot(new_addr_type block_addr) const;
+  unsigned find_slot(new_addr_type block_addr) const;
+  unsigned find(new_addr_type block_addr) const {
+    unsigned slot = find_slot(block_addr);
+    return slot == NO_ENTRY ? NO_ENTRY : m_index[slot];
+  }
+  unsigned allocate(new_addr_type block_addr);
+  void release(unsigned e);
+  mem_fetch *&merged(unsigned e, unsigned n) {
+    return m_merged[e * m_max_merged +
+                    (m_entries[e].m_head + n) % m_max_merged];
+  }
+
+  std::vector<mshr_entry> m_entries;
+  std::vector<mem_fetch *> m_merged;
+  std::vector<unsigned> m_free;   // unused entries
+  std::vector<unsigned> m_index;  // entry per slot, NO_ENTRY when empty
+  unsigned m_index_mask;
+  unsigned m_index_shift;
+
+  // it may take several cycles to process the merged requests, entries whose
+  // fill has arrived wait in this ring (at most one slot per entry)
+  std::vector<unsigned> m_current_response;
+  unsigned m_response_head;
+  unsigned m_response_count;
 };
 
 /***************************************************************** Caches
@@ -1370,34 +1402,6 @@ class baseline_cache : public cache_t {
   enum mem_fetch_status m_miss_queue_status;
   mem_fetch_interface *m_memport;
 
-  struct extra_mf_fields {
-    extra_mf_fields() { m_valid = false; }
-    extra_mf_fields(new_addr_type a, new_addr_type ad, unsigned i, unsigned d,
-                    const cache_config &m_config) {
-      m_valid = true;
-      m_block_addr = a;
-      m_addr = ad;
-      m_cache_index = i;
-      m_data_size = d;
-      pending_read = m_config.m_mshr_type == SECTOR_ASSOC
-                         ? m_config.m_line_sz / SECTOR_SIZE
-                         : 0;
-    }
-    bool m_valid;
-    new_addr_type m_block_addr;
-    new_addr_type m_addr;
-    unsigned m_cache_index;
-    unsigned m_data_size;
-    // this variable is used when a load request generates multiple load
-    // transactions For example, a read request from non-sector L1 request sends
-    // a request to sector L2
-    unsigned pending_read;
-  };
-
-  typedef std::map<mem_fetch *, extra_mf_fields> extra_mf_fields_lookup;
-
-  extra_mf_fields_lookup m_extra_mf_fields;
-
   cache_stats m_stats;
 
   /// Checks whether this request can be handled on this cycle. num_miss equals
@@ -1884,25 +1888,7 @@ class tex_cache : public cache_t {
   enum mem_fetch_status m_request_queue_status;
   enum mem_fetch_status m_rob_status;
 
-  struct extra_mf_fields {
-    extra_mf_fields() { m_valid = false; }
-    extra_mf_fields(unsigned i, const cache_config &m_config) {
-      m_valid = true;
-      m_rob_index = i;
-      pending_read = m_config.m_mshr_type == SECTOR_TEX_FIFO
-                         ? m_config.m_line_sz / SECTOR_SIZE
-                         : 0;
-    }
-    bool m_valid;
-    unsigned m_rob_index;
-    unsigned pending_read;
-  };
-
   cache_stats m_stats;
-
-  typedef std::map<mem_fetch *, extra_mf_fields> extra_mf_fields_lookup;
-
-  extra_mf_fields_lookup m_extra_mf_fields;
 };
 
 #endif
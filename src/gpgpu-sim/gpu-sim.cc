@@ -102,6 +102,11 @@ void power_config::reg_options(class OptionParser *opp) {
   option_parser_register(opp, "-accelwattch_xml_file", OPT_CSTR,
                          &g_power_config_name, "AccelWattch XML file",
                          "accelwattch_sass_sim.xml");
+  option_parser_register(
+      opp, "-accelwattch_cache_dir", OPT_CSTR, &g_power_cache_dir,
+      "Directory caching the McPAT/CACTI array solutions of an AccelWattch "
+      "XML file across runs (empty: no caching)",
+      "");
 
   option_parser_register(opp, "-power_simulation_enabled", OPT_BOOL,
                          &g_power_simulation_enabled,
@@ -132,6 +137,10 @@ void power_config::reg_options(class OptionParser *opp) {
   option_parser_register(opp, "-aggregate_power_stats", OPT_BOOL,
                          &g_aggregate_power_stats,
                          "Accumulate power across all kernels", "0");
+  option_parser_register(opp, "-power_eval_async", OPT_BOOL,
+                         &g_power_eval_async,
+                         "Evaluate the power model on a separate host thread, "
+                         "concurrently with the timing simulation", "1");
 
   //Accelwattch Hyrbid Configuration
 
@@ -699,6 +708,17 @@ void gpgpu_sim_config::reg_options(option_parser_t opp) {
                          "Clock Domain Frequencies in MhZ {<Core Clock>:<ICNT "
                          "Clock>:<L2 Clock>:<DRAM Clock>}",
                          "500.0:2000.0:2000.0:2000.0");
+  option_parser_register(
+      opp, "-gpgpu_cta_sample_period", OPT_UINT32, &gpgpu_cta_sample_period,
+      "Simulate only one out of every <period> windows of CTAs in timing "
+      "mode, execute the others functionally and extrapolate the kernel "
+      "cycle count (0 or 1 = time every CTA)",
+      "0");
+  option_parser_register(
+      opp, "-gpgpu_cta_sample_window", OPT_UINT32, &gpgpu_cta_sample_window,
+      "Number of consecutive CTAs in one sampling window "
+      "(see -gpgpu_cta_sample_period)",
+      "16");
   option_parser_register(
       opp, "-gpgpu_max_concurrent_kernel", OPT_INT32, &max_concurrent_kernel,
       "maximum kernels that can run concurrently on GPU, set this value "
@@ -716,6 +736,10 @@ void gpgpu_sim_config::reg_options(option_parser_t opp) {
       opp, "-visualizer_zlevel", OPT_INT32, &g_visualizer_zlevel,
       "Compression level of the visualizer output log (0=no comp, 9=highest)",
       "6");
+  option_parser_register(
+      opp, "-visualizer_binary", OPT_BOOL, &g_visualizer_binary,
+      "Write the visualizer log in the compact binary format instead of text "
+      "(1=On, 0=Off)", "0");
   option_parser_register(opp, "-gpgpu_stack_size_limit", OPT_INT32,
                          &stack_size_limit, "GPU thread stack size", "1024");
   option_parser_register(opp, "-gpgpu_heap_size_limit", OPT_INT32,
@@ -733,6 +757,15 @@ void gpgpu_sim_config::reg_options(option_parser_t opp) {
                          "Complete list found in trace_streams.tup. "
                          "Default none",
                          "none");
+#if TRACING_ON
+  option_parser_register(opp, "-trace_binary_file", OPT_CSTR,
+                         &Trace::binary_file,
+                         "write traces as compressed binary events to this "
+                         "file instead of printing them "
+                         "(scripts/trace2text converts it to text). "
+                         "Default none",
+                         "none");
+#endif
   option_parser_register(
       opp, "-trace_sampling_core", OPT_INT32, &Trace::sampling_core,
       "The core which is printed using CORE_DPRINTF. Default 0", "0");
@@ -923,9 +956,18 @@ gpgpu_sim::gpgpu_sim(const gpgpu_sim_config &config, gpgpu_context *ctx)
   ctx->ptx_parser->set_ptx_warp_size(m_shader_config);
   ptx_file_line_stats_create_exposed_latency_tracker(m_config.num_shader());
 
+  m_mcpat_pipeline = NULL;
 #ifdef GPGPUSIM_POWER_MODEL
-  m_gpgpusim_wrapper = new gpgpu_sim_wrapper(config.g_power_simulation_enabled,
-                                             config.g_power_config_name, config.g_power_simulation_mode, config.g_dvfs_enabled);
+  m_gpgpusim_wrapper = new gpgpu_sim_wrapper(
+      config.g_power_simulation_enabled, config.g_power_config_name,
+      config.g_power_simulation_mode, config.g_dvfs_enabled,
+      config.g_power_cache_dir);
+  // per-cycle power dumps go to stdout and must stay in order with the
+  // rest of the simulator output
+  if (config.g_power_simulation_enabled &&
+      config.g_power_simulation_mode == 0 && config.g_power_eval_async &&
+      !config.g_power_per_cycle_dump)
+    m_mcpat_pipeline = new mcpat_pipeline(m_gpgpusim_wrapper);
 #endif
 
   m_shader_stats = new shader_core_stats(m_shader_config);
@@ -936,12 +978,15 @@ gpgpu_sim::gpgpu_sim(const gpgpu_sim_config &config, gpgpu_context *ctx)
   m_power_stats =
       new power_stat_t(m_shader_config, average_pipeline_duty_cycle, active_sms,
                        m_shader_stats, m_memory_config, m_memory_stats);
+  m_visualizer_log = NULL;
 
   gpu_sim_insn = 0;
   gpu_tot_sim_insn = 0;
   gpu_tot_issued_cta = 0;
   gpu_completed_cta = 0;
+  reset_cta_sample_window();
   m_total_cta_launched = 0;
+  m_active_clusters.assign((m_shader_config->n_simt_clusters + 63) / 64, 0);
   gpu_deadlock = false;
 
   gpu_stall_dramfull = 0;
@@ -1095,6 +1140,7 @@ void gpgpu_sim::init() {
   last_gpu_sim_insn = 0;
   m_total_cta_launched = 0;
   gpu_completed_cta = 0;
+  reset_cta_sample_window();
   partiton_reqs_in_parallel = 0;
   partiton_replys_in_parallel = 0;
   partiton_reqs_in_parallel_util = 0;
@@ -1103,6 +1149,7 @@ void gpgpu_sim::init() {
 // McPAT initialization function. Called on first launch of GPU
 #ifdef GPGPUSIM_POWER_MODEL
   if (m_config.g_power_simulation_enabled) {
+    if (m_mcpat_pipeline) m_mcpat_pipeline->drain();
     init_mcpat(m_config, m_gpgpusim_wrapper, m_config.gpu_stat_sample_freq,
                gpu_tot_sim_insn, gpu_sim_insn);
   }
@@ -1154,6 +1201,7 @@ void gpgpu_sim::update_stats() {
   gpu_sim_insn = 0;
   m_total_cta_launched = 0;
   gpu_completed_cta = 0;
+  reset_cta_sample_window();
   gpu_occupancy = occupancy_stats();
 }
 
@@ -1362,6 +1410,7 @@ void gpgpu_sim::gpu_print_stat() {
                                        (gpu_tot_sim_cycle + gpu_sim_cycle));
   printf("gpu_tot_issued_cta = %lld\n",
          gpu_tot_issued_cta + m_total_cta_launched);
+  print_cta_sampling_estimate();
   printf("gpu_occupancy = %.4f%% \n", gpu_occupancy.get_occ_fraction() * 100);
   printf("gpu_tot_occupancy = %.4f%% \n",
          (gpu_occupancy + gpu_tot_occupancy).get_occ_fraction() * 100);
@@ -1373,6 +1422,12 @@ void gpgpu_sim::gpu_print_stat() {
   printf("gpu_stall_dramfull = %d\n", gpu_stall_dramfull);
   printf("gpu_stall_icnt2sh    = %d\n", gpu_stall_icnt2sh);
 
+  // mem_fetch pool accounting: requests still live once the memory system
+  // has drained at the end of a kernel are leaked
+  printf("mem_fetch_pool_tot_alloc = %llu\n", mem_fetch::pool_num_alloc());
+  printf("mem_fetch_pool_live = %llu\n", mem_fetch::pool_num_live());
+  printf("mem_fetch_pool_reserved = %llu\n", mem_fetch::pool_num_reserved());
+
   // printf("partiton_reqs_in_parallel = %lld\n", partiton_reqs_in_parallel);
   // printf("partiton_reqs_in_parallel_total    = %lld\n",
   // partiton_reqs_in_parallel_total );
@@ -1433,6 +1488,7 @@ void gpgpu_sim::gpu_print_stat() {
   m_shader_stats->print(stdout);
 #ifdef GPGPUSIM_POWER_MODEL
   if (m_config.g_power_simulation_enabled) {
+    if (m_mcpat_pipeline) m_mcpat_pipeline->drain();
     if(m_config.g_power_simulation_mode > 0){
         //if(!m_config.g_aggregate_power_stats)
           mcpat_reset_perf_count(m_gpgpusim_wrapper);
@@ -1760,7 +1816,33 @@ void shader_core_ctx::issue_block2core(kernel_info_t &kernel) {
   function_info *kernel_func_info = kernel.entry();
   symbol_table *symtab = kernel_func_info->get_symtab();
   unsigned ctaid = kernel.get_next_cta_id_single();
-  checkpoint *g_checkpoint = new checkpoint();
+  bool resume_cta = m_gpu->resume_option == 1 &&
+                    kernel.get_uid() == m_gpu->resume_kernel &&
+                    ctaid >= m_gpu->resume_CTA &&
+                    ctaid < m_gpu->checkpoint_CTA_t;
+  // open every memory image of the CTA before any thread state is restored,
+  // so a missing or unreadable checkpoint stops the run up front
+  std::vector<mem_image *> local_images;
+  mem_image *shared_image = NULL;
+  if (resume_cta) {
+    checkpoint g_checkpoint;
+    bool ok = true;
+    for (unsigned i = start_thread; i < end_thread; i++) {
+      char f1name[2048];
+      snprintf(f1name, 2048, "checkpoint_files/local_mem_thread_%d_%d.bin",
+               i % cta_size, ctaid);
+      local_images.push_back(g_checkpoint.open_image(f1name));
+      ok = ok && local_images.back() != NULL;
+    }
+    char f1name[2048];
+    snprintf(f1name, 2048, "checkpoint_files/shared_mem_%d.bin", ctaid);
+    shared_image = g_checkpoint.open_image(f1name);
+    if (!ok || shared_image == NULL) {
+      printf("GPGPU-Sim: ERROR ** cannot resume CTA %u of kernel %u\n", ctaid,
+             kernel.get_uid());
+      exit(1);
+    }
+  }
   for (unsigned i = start_thread; i < end_thread; i++) {
     m_threadState[i].m_cta_id = free_cta_hw_id;
     unsigned warp_id = i / m_config->warp_size;
@@ -1770,16 +1852,13 @@ void shader_core_ctx::issue_block2core(kernel_info_t &kernel) {
         m_cluster->get_gpu());
     m_threadState[i].m_active = true;
     // load thread local memory and register file
-    if (m_gpu->resume_option == 1 && kernel.get_uid() == m_gpu->resume_kernel &&
-        ctaid >= m_gpu->resume_CTA && ctaid < m_gpu->checkpoint_CTA_t) {
+    if (resume_cta) {
       char fname[2048];
       snprintf(fname, 2048, "checkpoint_files/thread_%d_%d_reg.txt",
                i % cta_size, ctaid);
       m_thread[i]->resume_reg_thread(fname, symtab);
-      char f1name[2048];
-      snprintf(f1name, 2048, "checkpoint_files/local_mem_thread_%d_%d_reg.txt",
-               i % cta_size, ctaid);
-      g_checkpoint->load_global_mem(m_thread[i]->m_local_mem, f1name);
+      m_thread[i]->m_local_mem->attach_image(
+          local_images[i - start_thread]);
     }
     //
     warps.set(warp_id);
@@ -1790,13 +1869,8 @@ void shader_core_ctx::issue_block2core(kernel_info_t &kernel) {
                                               // less than max
   m_cta_status[free_cta_hw_id] = nthreads_in_block;
 
-  if (m_gpu->resume_option == 1 && kernel.get_uid() == m_gpu->resume_kernel &&
-      ctaid >= m_gpu->resume_CTA && ctaid < m_gpu->checkpoint_CTA_t) {
-    char f1name[2048];
-    snprintf(f1name, 2048, "checkpoint_files/shared_mem_%d.txt", ctaid);
-
-    g_checkpoint->load_global_mem(m_thread[start_thread]->m_shared_mem, f1name);
-  }
+  if (resume_cta)
+    m_thread[start_thread]->m_shared_mem->attach_image(shared_image);
   // now that we know which warps are used in this CTA, we can allocate
   // resources for use in CTA-wide barrier operations
   m_barriers.allocate_barrier(free_cta_hw_id, warps);
@@ -1848,18 +1922,138 @@ int gpgpu_sim::next_clock_domain(void) {
   return mask;
 }
 
+bool gpgpu_sim::cta_sampling_enabled() const {
+  // CTAs executed functionally cannot launch child kernels into the timing
+  // model, so sampling is only applied without dynamic parallelism
+  return m_config.gpgpu_cta_sample_period > 1 &&
+         m_config.gpgpu_cta_sample_window > 0 &&
+         !gpgpu_ctx->device_runtime->g_cdp_enabled;
+}
+
+// CTAs are grouped into windows of consecutive linear ids and the first window
+// of every sampling period is simulated in timing mode. Window 0 is always
+// timed, so every kernel is selected for execution by the timing model.
+bool gpgpu_sim::cta_is_sampled(unsigned ctaid) const {
+  return (ctaid / m_config.gpgpu_cta_sample_window) %
+             m_config.gpgpu_cta_sample_period ==
+         0;
+}
+
+void gpgpu_sim::record_sampled_cta() { m_sampled_cta++; }
+
+// A timed window ends when the functional simulator takes over after its last
+// CTA was issued. The cycles it took are the samples the error bound of the
+// extrapolated cycle count is computed from.
+void gpgpu_sim::reset_cta_sample_window() {
+  m_sampled_cta = 0;
+  m_functional_cta = 0;
+  m_sample_window_start = 0;
+  m_sample_window_cta = 0;
+  m_sample_window_last = 0;
+  m_sample_windows = 0;
+  m_sample_window_cycles = 0;
+  m_sample_window_cycles_sq = 0;
+}
+
+void gpgpu_sim::end_sample_window() {
+  double cycles = gpu_sim_cycle - m_sample_window_start;
+  m_sample_windows++;
+  m_sample_window_cycles += cycles;
+  m_sample_window_cycles_sq += cycles * cycles;
+  m_sample_window_start = gpu_sim_cycle;
+  m_sample_window_cta = m_total_cta_launched;
+  m_sample_window_last = cycles;
+}
+
+// Fast-forward the running kernels over the CTAs that fall outside the sampled
+// windows by executing them with the functional simulator, so the next CTA of
+// each kernel handed to the shader cores is a sampled one.
+void gpgpu_sim::run_unsampled_ctas() {
+  bool window_ended = false;
+  for (unsigned n = 0; n < m_running_kernels.size(); n++) {
+    kernel_info_t *kernel = m_running_kernels[n];
+    if (kernel == NULL || kernel->m_kernel_TB_latency) continue;
+    bool ran = false;
+    while (kernel_more_cta_left(kernel) &&
+           !cta_is_sampled(kernel->get_next_cta_id_single())) {
+      functionalCoreSim cta(kernel, this, m_shader_config->warp_size);
+      cta.execute(0, kernel->get_next_cta_id_single());
+      m_functional_cta++;
+      ran = true;
+    }
+    // the functional CTAs were the last ones and every timed CTA has already
+    // exited, so no shader core is left to retire the kernel
+    if (ran && kernel->done()) set_kernel_done(kernel);
+    window_ended = window_ended || ran;
+  }
+  if (window_ended) end_sample_window();
+}
+
+void gpgpu_sim::print_cta_sampling_estimate() const {
+  if (!cta_sampling_enabled() || m_sampled_cta == 0) return;
+  unsigned long long n_cta = m_sampled_cta + m_functional_cta;
+  double scale = (double)n_cta / m_sampled_cta;
+  double estimate = gpu_sim_cycle * scale;
+  printf("gpu_sampled_cta = %llu\n", m_sampled_cta);
+  printf("gpu_functional_cta = %llu\n", m_functional_cta);
+  printf("gpu_sim_cycle_estimate = %.0f\n", estimate);
+  // The cycles after the last window ended are a sample of their own if timed
+  // CTAs were issued since, otherwise they drain the last window and belong to
+  // it. Either way the windows' cycles add up to gpu_sim_cycle.
+  double tail = gpu_sim_cycle - m_sample_window_start;
+  double k = m_sample_windows;
+  double sum = m_sample_window_cycles + tail;
+  double sum_sq = m_sample_window_cycles_sq;
+  if (m_sample_windows == 0 || m_total_cta_launched > m_sample_window_cta) {
+    k += 1;
+    sum_sq += tail * tail;
+  } else {
+    double last = m_sample_window_last + tail;
+    sum_sq += last * last - m_sample_window_last * m_sample_window_last;
+  }
+  if (k < 2) {
+    printf("gpu_sim_cycle_estimate_err95 = n/a\n");
+    return;
+  }
+  // 95% confidence interval of the estimate, taken from the relative standard
+  // error of the mean cycles per timed window, with a finite population
+  // correction for the windows that were not timed.
+  double mean = sum / k;
+  double var = (sum_sq - k * mean * mean) / (k - 1);
+  if (var < 0) var = 0;
+  double n_windows = k * scale;
+  double fpc = n_windows > 1 ? (n_windows - k) / (n_windows - 1) : 0;
+  double rel_err = mean > 0 ? 1.96 * sqrt(var * fpc / k) / mean : 0;
+  printf("gpu_sim_cycle_estimate_err95 = %.0f (%.2f%%)\n", estimate * rel_err,
+         rel_err * 100);
+}
+
 void gpgpu_sim::issue_block2core() {
+  if (cta_sampling_enabled()) run_unsampled_ctas();
   unsigned last_issued = m_last_cluster_issue;
   for (unsigned i = 0; i < m_shader_config->n_simt_clusters; i++) {
     unsigned idx = (i + last_issued + 1) % m_shader_config->n_simt_clusters;
     unsigned num = m_cluster[idx]->issue_block2core();
     if (num) {
+      activate_cluster(idx);
       m_last_cluster_issue = idx;
       m_total_cta_launched += num;
     }
   }
 }
 
+/// Returns the first cluster at or after i in the active set, or
+/// n_simt_clusters if there is none
+unsigned gpgpu_sim::next_active_cluster(unsigned i) const {
+  unsigned n = m_shader_config->n_simt_clusters;
+  while (i < n) {
+    unsigned long long bits = m_active_clusters[i / 64] >> (i % 64);
+    if (bits) return i + __builtin_ctzll(bits);
+    i = (i / 64 + 1) * 64;
+  }
+  return n;
+}
+
 unsigned long long g_single_step =
     0;  // set this in gdb to single step the pipeline
 
@@ -1921,7 +2115,6 @@ void gpgpu_sim::cycle() {
   // L2 operations follow L2 clock domain
   unsigned partiton_reqs_in_parallel_per_cycle = 0;
   if (clock_mask & L2) {
-    m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
     for (unsigned i = 0; i < m_memory_config->m_n_mem_sub_partition; i++) {
       // move memory request from interconnect into memory partition (if not
       // backed up) Note:This needs to be called in DRAM clock domain if there
@@ -1935,8 +2128,14 @@ void gpgpu_sim::cycle() {
         if (mf) partiton_reqs_in_parallel_per_cycle++;
       }
       m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle + gpu_tot_sim_cycle);
-      m_memory_sub_partition[i]->accumulate_L2cache_stats(
-          m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+    }
+    // the aggregate is rebuilt every cycle and only read by the power model
+    if (m_config.g_power_simulation_enabled) {
+      m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
+      for (unsigned i = 0; i < m_memory_config->m_n_mem_sub_partition; i++) {
+        m_memory_sub_partition[i]->accumulate_L2cache_stats(
+            m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+      }
     }
   }
   partiton_reqs_in_parallel += partiton_reqs_in_parallel_per_cycle;
@@ -1950,22 +2149,36 @@ void gpgpu_sim::cycle() {
   }
 
   if (clock_mask & CORE) {
-    // L1 cache + shader core pipeline stages
-    m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
-    for (unsigned i = 0; i < m_shader_config->n_simt_clusters; i++) {
-      if (m_cluster[i]->get_not_completed() || get_more_cta_left()) {
+    // L1 cache + shader core pipeline stages. While CTAs are left to issue
+    // every cluster is cycled; otherwise only the active set is visited.
+    // Drained clusters have no active warps and add nothing to occupancy.
+    bool more_cta_left = get_more_cta_left();
+    unsigned n_clusters = m_shader_config->n_simt_clusters;
+    for (unsigned i = more_cta_left ? 0 : next_active_cluster(0);
+         i < n_clusters;
+         i = more_cta_left ? i + 1 : next_active_cluster(i + 1)) {
+      if (m_cluster[i]->get_not_completed() || more_cta_left) {
         m_cluster[i]->core_cycle();
         *active_sms += m_cluster[i]->get_n_active_sms();
       }
-      // Update core icnt/cache stats for AccelWattch
-      m_cluster[i]->get_icnt_stats(
-          m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
-      m_cluster[i]->get_cache_stats(
-          m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
-      m_cluster[i]->get_current_occupancy(
-          gpu_occupancy.aggregate_warp_slot_filled,
-          gpu_occupancy.aggregate_theoretical_warp_slots);
+      if (m_cluster[i]->get_not_completed()) {
+        m_cluster[i]->get_current_occupancy(
+            gpu_occupancy.aggregate_warp_slot_filled,
+            gpu_occupancy.aggregate_theoretical_warp_slots);
+      } else {
+        deactivate_cluster(i);
+      }
+    }
+    // Update core icnt/cache stats for AccelWattch
+    if (m_config.g_power_simulation_enabled) {
+      m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+      for (unsigned i = 0; i < n_clusters; i++) {
+        m_cluster[i]->get_icnt_stats(
+            m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i],
+            m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
+        m_cluster[i]->get_cache_stats(
+            m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
+      }
     }
     float temp = 0;
     for (unsigned i = 0; i < m_shader_config->num_shader(); i++) {
@@ -1991,7 +2204,7 @@ void gpgpu_sim::cycle() {
       mcpat_cycle(m_config, getShaderCoreConfig(), m_gpgpusim_wrapper,
                   m_power_stats, m_config.gpu_stat_sample_freq,
                   gpu_tot_sim_cycle, gpu_sim_cycle, gpu_tot_sim_insn,
-                  gpu_sim_insn, m_config.g_dvfs_enabled);
+                  gpu_sim_insn, m_config.g_dvfs_enabled, m_mcpat_pipeline);
       }
     }
 #endif
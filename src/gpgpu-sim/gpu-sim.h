@@ -139,6 +139,7 @@ struct power_config {
   void reg_options(class OptionParser *opp);
 
   char *g_power_config_name;
+  char *g_power_cache_dir;
 
   bool m_valid;
   bool g_power_simulation_enabled;
@@ -161,6 +162,7 @@ struct power_config {
   int g_power_simulation_mode;
   bool g_dvfs_enabled;
   bool g_aggregate_power_stats;
+  bool g_power_eval_async;
   bool accelwattch_hybrid_configuration[hw_perf_t::HW_TOTAL_STATS];
 
   // Nonlinear power model
@@ -441,11 +443,14 @@ class gpgpu_sim_config : public power_config,
   int gpgpu_cflog_interval;
   char *gpgpu_clock_domains;
   unsigned max_concurrent_kernel;
+  unsigned gpgpu_cta_sample_period;
+  unsigned gpgpu_cta_sample_window;
 
   // visualizer
   bool g_visualizer_enabled;
   char *g_visualizer_filename;
   int g_visualizer_zlevel;
+  bool g_visualizer_binary;
 
   // statistics collection
   int gpu_stat_sample_freq;
@@ -544,6 +549,9 @@ class gpgpu_sim : public gpgpu_t {
   void update_stats();
   void deadlock_check();
   void inc_completed_cta() { gpu_completed_cta++; }
+  bool cta_sampling_enabled() const;
+  bool cta_is_sampled(unsigned ctaid) const;
+  void record_sampled_cta();
   void get_pdom_stack_top_info(unsigned sid, unsigned tid, unsigned *pc,
                                unsigned *rpc);
 
@@ -609,6 +617,10 @@ class gpgpu_sim : public gpgpu_t {
   void reinit_clock_domains(void);
   int next_clock_domain(void);
   void issue_block2core();
+  void run_unsampled_ctas();
+  void reset_cta_sample_window();
+  void end_sample_window();
+  void print_cta_sampling_estimate() const;
   void print_dram_stats(FILE *fout) const;
   void shader_print_runtime_stat(FILE *fout);
   void shader_print_l1_miss_stat(FILE *fout) const;
@@ -635,7 +647,34 @@ class gpgpu_sim : public gpgpu_t {
   unsigned long long gpu_tot_issued_cta;
   unsigned gpu_completed_cta;
 
+  // CTA sampling (-gpgpu_cta_sample_period): number of CTAs simulated in
+  // timing mode and executed functionally in the current kernel, and the
+  // count, sum and sum of squares of the cycles of the timed windows (see
+  // end_sample_window())
+  unsigned long long m_sampled_cta;
+  unsigned long long m_functional_cta;
+  unsigned long long m_sample_window_start;
+  unsigned long long m_sample_window_cta;
+  double m_sample_window_last;
+  unsigned m_sample_windows;
+  double m_sample_window_cycles;
+  double m_sample_window_cycles_sq;
+
   unsigned m_last_cluster_issue;
+
+  // Clusters that may still have threads to run, one bit per cluster. Every
+  // cluster with get_not_completed() > 0 has its bit set: bits are set when
+  // issue_block2core() hands a cluster a CTA and cleared by cycle() once the
+  // cluster has drained, so idle clusters drop out of the core loop.
+  std::vector<unsigned long long> m_active_clusters;
+  void activate_cluster(unsigned i) {
+    m_active_clusters[i / 64] |= 1ULL << (i % 64);
+  }
+  void deactivate_cluster(unsigned i) {
+    m_active_clusters[i / 64] &= ~(1ULL << (i % 64));
+  }
+  unsigned next_active_cluster(unsigned i) const;
+
   float *average_pipeline_duty_cycle;
   float *active_sms;
   // time of next rising edge
@@ -658,7 +697,11 @@ class gpgpu_sim : public gpgpu_t {
   class shader_core_stats *m_shader_stats;
   class memory_stats_t *m_memory_stats;
   class power_stat_t *m_power_stats;
+  class visualizer_log *m_visualizer_log;
   class gpgpu_sim_wrapper *m_gpgpusim_wrapper;
+  // evaluates power samples off the simulation thread (NULL when
+  // -power_eval_async is off)
+  class mcpat_pipeline *m_mcpat_pipeline;
   unsigned long long last_gpu_sim_insn;
 
   unsigned long long last_liveness_message_time;
@@ -47,6 +47,7 @@
 #include "mem_fetch.h"
 #include "mem_latency_stat.h"
 #include "shader.h"
+#include "visualizer_log.h"
 
 mem_fetch *partition_mf_allocator::alloc(new_addr_type addr,
                                          mem_access_type type, unsigned size,
@@ -204,11 +205,11 @@ void memory_partition_unit::cache_cycle(unsigned cycle) {
   }
 }
 
-void memory_partition_unit::visualizer_print(gzFile visualizer_file) const {
-  m_dram->visualizer_print(visualizer_file);
+void memory_partition_unit::visualizer_print(visualizer_log *log) const {
+  m_dram->visualizer_print(log);
   for (unsigned p = 0; p < m_config->m_n_sub_partition_per_memory_channel;
        p++) {
-    m_sub_partition[p]->visualizer_print(visualizer_file);
+    m_sub_partition[p]->visualizer_print(log);
   }
 }
 
@@ -627,28 +628,33 @@ void memory_sub_partition::print_cache_stat(unsigned &accesses,
 void memory_sub_partition::print(FILE *fp) const {
   if (!m_request_tracker.empty()) {
     fprintf(fp, "Memory Sub Parition %u: pending memory requests:\n", m_id);
-    for (std::set<mem_fetch *>::const_iterator r = m_request_tracker.begin();
-         r != m_request_tracker.end(); ++r) {
-      mem_fetch *mf = *r;
-      if (mf)
-        mf->print(fp);
-      else
-        fprintf(fp, " <NULL mem_fetch?>\n");
-    }
+    for (mem_fetch *mf = m_request_tracker.first(); mf;
+         mf = mem_fetch_tracker::next(mf))
+      mf->print(fp);
   }
   if (!m_config->m_L2_config.disabled()) m_L2cache->display_state(fp);
 }
 
-void memory_stats_t::visualizer_print(gzFile visualizer_file) {
-  gzprintf(visualizer_file, "Ltwowritemiss: %d\n", L2_write_miss);
-  gzprintf(visualizer_file, "Ltwowritehit: %d\n", L2_write_hit);
-  gzprintf(visualizer_file, "Ltworeadmiss: %d\n", L2_read_miss);
-  gzprintf(visualizer_file, "Ltworeadhit: %d\n", L2_read_hit);
+void memory_stats_t::visualizer_print(visualizer_log *log) {
+  log->begin_row("Ltwowritemiss");
+  log->add(L2_write_miss);
+  log->end_row();
+  log->begin_row("Ltwowritehit");
+  log->add(L2_write_hit);
+  log->end_row();
+  log->begin_row("Ltworeadmiss");
+  log->add(L2_read_miss);
+  log->end_row();
+  log->begin_row("Ltworeadhit");
+  log->add(L2_read_hit);
+  log->end_row();
   clear_L2_stats_pw();
 
-  if (num_mfs)
-    gzprintf(visualizer_file, "averagemflatency: %lld\n",
-             mf_total_lat / num_mfs);
+  if (num_mfs) {
+    log->begin_row("averagemflatency");
+    log->add((long long)(mf_total_lat / num_mfs));
+    log->end_row();
+  }
 }
 
 void memory_stats_t::clear_L2_stats_pw() {
@@ -863,7 +869,7 @@ void memory_sub_partition::clear_L2cache_stats_pw() {
   }
 }
 
-void memory_sub_partition::visualizer_print(gzFile visualizer_file) {
+void memory_sub_partition::visualizer_print(visualizer_log *log) {
   // Support for L2 AerialVision stats
   // Per-sub-partition stats would be trivial to extend from this
   cache_sub_stats_pw temp_sub_stats;
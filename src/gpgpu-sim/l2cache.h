@@ -33,6 +33,7 @@
 
 #include "../abstract_hardware_model.h"
 #include "dram.h"
+#include "mem_fetch.h"
 
 #include <list>
 #include <queue>
@@ -83,7 +84,7 @@ class memory_partition_unit {
 
   void set_done(mem_fetch *mf);
 
-  void visualizer_print(gzFile visualizer_file) const;
+  void visualizer_print(class visualizer_log *log) const;
   void print_stat(FILE *fp) { m_dram->print_stat(fp); }
   void visualize() const { m_dram->visualize(); }
   void print(FILE *fp) const;
@@ -188,7 +189,7 @@ class memory_sub_partition {
   bool dram_L2_queue_full() const;
   void dram_L2_queue_push(class mem_fetch *mf);
 
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
   void print_cache_stat(unsigned &accesses, unsigned &misses) const;
   void print(FILE *fp) const;
 
@@ -232,7 +233,7 @@ class memory_sub_partition {
 
   class memory_stats_t *m_stats;
 
-  std::set<mem_fetch *> m_request_tracker;
+  mem_fetch_tracker m_request_tracker;
 
   friend class L2interface;
 
@@ -44,24 +44,40 @@
 
 // Intended to be called from inside components of a memory partition
 // Depends on a get_mpid() function
-#define MEMPART_DPRINTF(...)                                                   \
-  do {                                                                         \
-    if (MEMPART_DTRACE(MEMORY_PARTITION_UNIT)) {                               \
-      printf(                                                                  \
-          MEMPART_PRINT_STR, m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,  \
-          Trace::trace_streams_str[Trace::MEMORY_PARTITION_UNIT], get_mpid()); \
-      printf(__VA_ARGS__);                                                     \
-    }                                                                          \
+#define MEMPART_DPRINTF(...)                                                 \
+  do {                                                                       \
+    if (MEMPART_DTRACE(MEMORY_PARTITION_UNIT)) {                             \
+      if (Trace::binary_enabled) {                                           \
+        Trace::record(Trace::MEMORY_PARTITION_UNIT,                          \
+                      Trace::TRACE_PREFIX_MEMPART, get_mpid(), -1,           \
+                      m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,       \
+                      __VA_ARGS__);                                          \
+      } else {                                                               \
+        printf(MEMPART_PRINT_STR,                                            \
+               m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,              \
+               Trace::trace_streams_str[Trace::MEMORY_PARTITION_UNIT],       \
+               get_mpid());                                                  \
+        printf(__VA_ARGS__);                                                 \
+      }                                                                      \
+    }                                                                        \
   } while (0)
 
-#define MEM_SUBPART_DPRINTF(...)                                               \
-  do {                                                                         \
-    if (MEM_SUBPART_DTRACE(MEMORY_PARTITION_UNIT)) {                           \
-      printf(MEM_SUBPART_PRINT_STR,                                            \
-             m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,                  \
-             Trace::trace_streams_str[Trace::MEMORY_SUBPARTITION_UNIT], m_id); \
-      printf(__VA_ARGS__);                                                     \
-    }                                                                          \
+#define MEM_SUBPART_DPRINTF(...)                                             \
+  do {                                                                       \
+    if (MEM_SUBPART_DTRACE(MEMORY_PARTITION_UNIT)) {                         \
+      if (Trace::binary_enabled) {                                           \
+        Trace::record(Trace::MEMORY_SUBPARTITION_UNIT,                       \
+                      Trace::TRACE_PREFIX_MEMPART, m_id, -1,                 \
+                      m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,       \
+                      __VA_ARGS__);                                          \
+      } else {                                                               \
+        printf(MEM_SUBPART_PRINT_STR,                                        \
+               m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,              \
+               Trace::trace_streams_str[Trace::MEMORY_SUBPARTITION_UNIT],    \
+               m_id);                                                        \
+        printf(__VA_ARGS__);                                                 \
+      }                                                                      \
+    }                                                                        \
   } while (0)
 
 #else
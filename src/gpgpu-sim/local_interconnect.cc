@@ -37,6 +37,42 @@
 #include "local_interconnect.h"
 #include "mem_fetch.h"
 
+// First set bit of mask in [from, end), or end if there is none.
+static unsigned find_next_bit(const unsigned long long* mask, unsigned from,
+                              unsigned end) {
+  if (from >= end) return end;
+  unsigned w = from / 64;
+  unsigned long long bits = mask[w] & (~0ULL << (from % 64));
+  while (!bits) {
+    if (++w * 64 >= end) return end;
+    bits = mask[w];
+  }
+  unsigned i = w * 64 + __builtin_ctzll(bits);
+  return i < end ? i : end;
+}
+
+// First set bit of mask in round-robin order starting at start, or end if
+// there is none.
+static unsigned find_next_bit_rr(const unsigned long long* mask,
+                                 unsigned start, unsigned end) {
+  unsigned i = find_next_bit(mask, start, end);
+  if (i == end) {
+    i = find_next_bit(mask, 0, start);
+    if (i == start) i = end;
+  }
+  return i;
+}
+
+static bool test_bit(const unsigned long long* mask, unsigned i) {
+  return (mask[i / 64] >> (i % 64)) & 1;
+}
+
+static unsigned count_bits(const vector<unsigned long long>& mask) {
+  unsigned n = 0;
+  for (unsigned w = 0; w < mask.size(); ++w) n += __builtin_popcountll(mask[w]);
+  return n;
+}
+
 xbar_router::xbar_router(unsigned router_id, enum Interconnect_type m_type,
                          unsigned n_shader, unsigned n_mem,
                          const struct inct_config& m_localinct_config) {
@@ -48,11 +84,23 @@ xbar_router::xbar_router(unsigned router_id, enum Interconnect_type m_type,
   verbose = m_localinct_config.verbose;
   grant_cycles = m_localinct_config.grant_cycles;
   grant_cycles_count = m_localinct_config.grant_cycles;
+  in_buffer_limit = m_localinct_config.in_buffer_limit;
+  out_buffer_limit = m_localinct_config.out_buffer_limit;
   in_buffers.resize(total_nodes);
   out_buffers.resize(total_nodes);
+  for (unsigned i = 0; i < total_nodes; ++i) {
+    in_buffers[i].init(in_buffer_limit);
+    out_buffers[i].init(out_buffer_limit);
+  }
+  n_words = (total_nodes + 63) / 64;
+  in_active.resize(n_words, 0);
+  out_requested.resize(n_words, 0);
+  requests.resize(total_nodes * n_words, 0);
+  issued.resize(n_words, 0);
+  in_packets = 0;
+  out_packets = 0;
+  out_full = out_buffer_limit ? 0 : total_nodes;
   next_node.resize(total_nodes, 0);
-  in_buffer_limit = m_localinct_config.in_buffer_limit;
-  out_buffer_limit = m_localinct_config.out_buffer_limit;
   arbit_type = m_localinct_config.arbiter_algo;
   next_node_id = 0;
   if (m_type == REQ_NET) {
@@ -77,20 +125,64 @@ xbar_router::xbar_router(unsigned router_id, enum Interconnect_type m_type,
 
 xbar_router::~xbar_router() {}
 
+void xbar_router::set_request(unsigned input_deviceID,
+                              unsigned output_deviceID) {
+  request_row(output_deviceID)[input_deviceID / 64] |=
+      1ULL << (input_deviceID % 64);
+  out_requested[output_deviceID / 64] |= 1ULL << (output_deviceID % 64);
+}
+
+void xbar_router::clear_request(unsigned input_deviceID,
+                                unsigned output_deviceID) {
+  unsigned long long* row = request_row(output_deviceID);
+  row[input_deviceID / 64] &= ~(1ULL << (input_deviceID % 64));
+  for (unsigned w = 0; w < n_words; ++w)
+    if (row[w]) return;
+  out_requested[output_deviceID / 64] &= ~(1ULL << (output_deviceID % 64));
+}
+
 void xbar_router::Push(unsigned input_deviceID, unsigned output_deviceID,
                        void* data, unsigned int size) {
   assert(input_deviceID < total_nodes);
+  assert(output_deviceID < total_nodes);
+  if (in_buffers[input_deviceID].empty()) {
+    in_active[input_deviceID / 64] |= 1ULL << (input_deviceID % 64);
+    set_request(input_deviceID, output_deviceID);
+  }
   in_buffers[input_deviceID].push(Packet(data, output_deviceID));
+  in_packets++;
   packets_num++;
 }
 
+// Remove the head packet of an input and expose the request of the next one.
+void xbar_router::pop_in(unsigned input_deviceID) {
+  fixed_fifo<Packet>& buffer = in_buffers[input_deviceID];
+  clear_request(input_deviceID, buffer.front().output_deviceID);
+  buffer.pop();
+  in_packets--;
+  if (buffer.empty())
+    in_active[input_deviceID / 64] &= ~(1ULL << (input_deviceID % 64));
+  else
+    set_request(input_deviceID, buffer.front().output_deviceID);
+}
+
+void xbar_router::push_out(const Packet& packet) {
+  fixed_fifo<Packet>& buffer = out_buffers[packet.output_deviceID];
+  buffer.push(packet);
+  out_packets++;
+  if (buffer.size() == out_buffer_limit) out_full++;
+}
+
 void* xbar_router::Pop(unsigned ouput_deviceID) {
   assert(ouput_deviceID < total_nodes);
   void* data = NULL;
 
-  if (!out_buffers[ouput_deviceID].empty()) {
-    data = out_buffers[ouput_deviceID].front().data;
-    out_buffers[ouput_deviceID].pop();
+  fixed_fifo<Packet>& buffer = out_buffers[ouput_deviceID];
+  if (!buffer.empty()) {
+    if (buffer.size() == out_buffer_limit) out_full--;
+    data = buffer.front().data;
+    buffer.pop();
+    out_packets--;
   }
 
   return data;
@@ -112,6 +204,17 @@ bool xbar_router::Has_Buffer_Out(unsigned output_deviceID, unsigned size) {
 }
 
 void xbar_router::Advance() {
+  if (!in_packets && !verbose) {
+    // nothing to arbitrate, only the statistics advance
+    if (arbit_type == NAIVE_RR)
+      next_node_id = (next_node_id + 1) % total_nodes;
+    else
+      out_buffer_full += out_full;
+    out_buffer_util += out_packets;
+    cycles++;
+    return;
+  }
+
   if (arbit_type == NAIVE_RR)
     RR_Advance();
   else if (arbit_type == iSLIP)
@@ -121,30 +224,34 @@ void xbar_router::Advance() {
 }
 
 void xbar_router::RR_Advance() {
-  bool active = false;
-  vector<bool> issued(total_nodes, false);
+  bool active = in_packets > 0;
   unsigned conflict_sub = 0;
   unsigned reqs = 0;
 
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    unsigned node_id = (i + next_node_id) % total_nodes;
-
-    if (!in_buffers[node_id].empty()) {
-      active = true;
+  std::fill(issued.begin(), issued.end(), 0);
+  // visit every input that holds a packet once, starting at next_node_id
+  for (unsigned pass = 0; pass < 2; ++pass) {
+    unsigned begin = pass ? 0 : next_node_id;
+    unsigned end = pass ? next_node_id : total_nodes;
+    for (unsigned node_id = find_next_bit(&in_active[0], begin, end);
+         node_id < end;
+         node_id = find_next_bit(&in_active[0], node_id + 1, end)) {
       Packet _packet = in_buffers[node_id].front();
+      unsigned out = _packet.output_deviceID;
+      bool out_issued = test_bit(&issued[0], out);
       // ensure that the outbuffer has space and not issued before in this cycle
-      if (Has_Buffer_Out(_packet.output_deviceID, 1)) {
-        if (!issued[_packet.output_deviceID]) {
-          out_buffers[_packet.output_deviceID].push(_packet);
-          in_buffers[node_id].pop();
-          issued[_packet.output_deviceID] = true;
+      if (Has_Buffer_Out(out, 1)) {
+        if (!out_issued) {
+          pop_in(node_id);
+          push_out(_packet);
+          issued[out / 64] |= 1ULL << (out % 64);
           reqs++;
         } else
           conflict_sub++;
       } else {
         out_buffer_full++;
 
-        if (issued[_packet.output_deviceID]) conflict_sub++;
+        if (out_issued) conflict_sub++;
       }
     }
   }
@@ -164,10 +271,8 @@ void xbar_router::RR_Advance() {
   }
 
   // collect some stats about buffer util
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    in_buffer_util += in_buffers[i].size();
-    out_buffer_util += out_buffers[i].size();
-  }
+  in_buffer_util += in_packets;
+  out_buffer_util += out_packets;
 
   cycles++;
 }
@@ -177,70 +282,50 @@ void xbar_router::RR_Advance() {
 // IEEE/ACM transactions on networking 2 (1999): 188-201.
 // https://www.cs.rutgers.edu/~sn624/552-F18/papers/islip.pdf
 void xbar_router::iSLIP_Advance() {
-  vector<unsigned> node_tmp;
-  bool active = false;
+  bool active = in_packets > 0;
 
-  unsigned conflict_sub = 0;
   unsigned reqs = 0;
 
-  // calcaulte how many conflicts are there for stats
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (!in_buffers[i].empty()) {
-      Packet _packet_tmp = in_buffers[i].front();
-      if (!node_tmp.empty()) {
-        if (std::find(node_tmp.begin(), node_tmp.end(),
-                      _packet_tmp.output_deviceID) != node_tmp.end()) {
-          conflict_sub++;
-        } else
-          node_tmp.push_back(_packet_tmp.output_deviceID);
-      } else {
-        node_tmp.push_back(_packet_tmp.output_deviceID);
-      }
-      active = true;
-    }
-  }
+  // calcaulte how many conflicts are there for stats: every input whose head
+  // packet targets an output that another input already requested
+  unsigned conflict_sub = count_bits(in_active) - count_bits(out_requested);
 
   conflicts += conflict_sub;
   if (active) {
     conflicts_util += conflict_sub;
     cycles_util++;
   }
-  // do iSLIP
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (Has_Buffer_Out(i, 1)) {
-      for (unsigned j = 0; j < total_nodes; ++j) {
-        unsigned node_id = (j + next_node[i]) % total_nodes;
-
-        if (!in_buffers[node_id].empty()) {
-          Packet _packet = in_buffers[node_id].front();
-          if (_packet.output_deviceID == i) {
-            out_buffers[_packet.output_deviceID].push(_packet);
-            in_buffers[node_id].pop();
-            if (verbose)
-              printf("%d : cycle %llu : send req from %d to %d\n", m_id, cycles,
-                     node_id, i - _n_shader);
-            if (grant_cycles_count == 1)
-              next_node[i] = (++node_id % total_nodes);
-            if (verbose) {
-              for (unsigned k = j + 1; k < total_nodes; ++k) {
-                unsigned node_id2 = (k + next_node[i]) % total_nodes;
-                if (!in_buffers[node_id2].empty()) {
-                  Packet _packet2 = in_buffers[node_id2].front();
-
-                  if (_packet2.output_deviceID == i)
-                    printf("%d : cycle %llu : cannot send req from %d to %d\n",
-                           m_id, cycles, node_id2, i - _n_shader);
-                }
-              }
-            }
-
-            reqs++;
-            break;
-          }
-        }
+  // an output only receives packets in its own grant step, so the outputs
+  // that are full now are the ones found full during the grant loop
+  out_buffer_full += out_full;
+  // do iSLIP; outputs requested by a head packet that moves up within this
+  // loop are still visited in this cycle
+  for (unsigned i = find_next_bit(&out_requested[0], 0, total_nodes);
+       i < total_nodes;
+       i = find_next_bit(&out_requested[0], i + 1, total_nodes)) {
+    if (!Has_Buffer_Out(i, 1)) continue;
+
+    unsigned start = next_node[i];
+    unsigned node_id = find_next_bit_rr(request_row(i), start, total_nodes);
+    assert(node_id < total_nodes);
+    Packet _packet = in_buffers[node_id].front();
+    pop_in(node_id);
+    push_out(_packet);
+    if (verbose)
+      printf("%d : cycle %llu : send req from %d to %d\n", m_id, cycles,
+             node_id, i - _n_shader);
+    if (grant_cycles_count == 1) next_node[i] = (node_id + 1) % total_nodes;
+    if (verbose) {
+      unsigned j = (node_id + total_nodes - start) % total_nodes;
+      for (unsigned k = j + 1; k < total_nodes; ++k) {
+        unsigned node_id2 = (k + next_node[i]) % total_nodes;
+        if (test_bit(request_row(i), node_id2))
+          printf("%d : cycle %llu : cannot send req from %d to %d\n", m_id,
+                 cycles, node_id2, i - _n_shader);
       }
-    } else
-      out_buffer_full++;
+    }
+
+    reqs++;
   }
 
   if (active) {
@@ -261,22 +346,13 @@ void xbar_router::iSLIP_Advance() {
   }
 
   // collect some stats about buffer util
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    in_buffer_util += in_buffers[i].size();
-    out_buffer_util += out_buffers[i].size();
-  }
+  in_buffer_util += in_packets;
+  out_buffer_util += out_packets;
 
   cycles++;
 }
 
-bool xbar_router::Busy() const {
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (!in_buffers[i].empty()) return true;
-
-    if (!out_buffers[i].empty()) return true;
-  }
-  return false;
-}
+bool xbar_router::Busy() const { return in_packets || out_packets; }
 
 ////////////////////////////////////////////////////
 /////////////LocalInterconnect/////////////////////
@@ -29,9 +29,9 @@
 #ifndef _LOCAL_INTERCONNECT_HPP_
 #define _LOCAL_INTERCONNECT_HPP_
 
+#include <assert.h>
 #include <iostream>
 #include <map>
-#include <queue>
 #include <vector>
 using namespace std;
 
@@ -49,6 +49,35 @@ struct inct_config {
   unsigned grant_cycles;
 };
 
+// Fixed-capacity FIFO. The crossbar buffers never hold more packets than
+// their configured limit, so they are allocated once at construction.
+template <class T>
+class fixed_fifo {
+ public:
+  fixed_fifo() : m_head(0), m_size(0) {}
+  void init(unsigned capacity) { m_slots.resize(capacity ? capacity : 1); }
+
+  bool empty() const { return m_size == 0; }
+  unsigned size() const { return m_size; }
+  const T& front() const { return m_slots[m_head]; }
+  void push(const T& v) {
+    assert(m_size < m_slots.size());
+    unsigned tail = m_head + m_size;
+    if (tail >= m_slots.size()) tail -= m_slots.size();
+    m_slots[tail] = v;
+    m_size++;
+  }
+  void pop() {
+    assert(m_size);
+    if (++m_head == m_slots.size()) m_head = 0;
+    m_size--;
+  }
+
+ private:
+  vector<T> m_slots;
+  unsigned m_head, m_size;
+};
+
 class xbar_router {
  public:
   xbar_router(unsigned router_id, enum Interconnect_type m_type,
@@ -82,6 +111,7 @@ class xbar_router {
   void RR_Advance();
 
   struct Packet {
+    Packet() : data(NULL), output_deviceID(0) {}
     Packet(void* m_data, unsigned m_output_deviceID) {
       data = m_data;
       output_deviceID = m_output_deviceID;
@@ -89,8 +119,27 @@ class xbar_router {
     void* data;
     unsigned output_deviceID;
   };
-  vector<queue<Packet> > in_buffers;
-  vector<queue<Packet> > out_buffers;
+  void push_out(const Packet& packet);
+  void pop_in(unsigned input_deviceID);
+  void set_request(unsigned input_deviceID, unsigned output_deviceID);
+  void clear_request(unsigned input_deviceID, unsigned output_deviceID);
+  unsigned long long* request_row(unsigned output_deviceID) {
+    return &requests[output_deviceID * n_words];
+  }
+
+  vector<fixed_fifo<Packet> > in_buffers;
+  vector<fixed_fifo<Packet> > out_buffers;
+  // Node bitmasks of n_words 64-bit words: inputs holding a packet, outputs
+  // targeted by the head packet of some input, and (one row per output) the
+  // inputs whose head packet targets that output. Arbitration only visits
+  // the set bits.
+  unsigned n_words;
+  vector<unsigned long long> in_active;
+  vector<unsigned long long> out_requested;
+  vector<unsigned long long> requests;
+  vector<unsigned long long> issued;  // outputs granted this cycle (RR)
+  // packets in all in/out buffers and number of full out buffers
+  unsigned in_packets, out_packets, out_full;
   unsigned _n_shader, _n_mem, total_nodes;
   unsigned in_buffer_limit, out_buffer_limit;
   vector<unsigned> next_node;  // used for iSLIP arbit
@@ -27,6 +27,11 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "mem_fetch.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
 #include "gpu-sim.h"
 #include "mem_latency_stat.h"
 #include "shader.h"
@@ -34,6 +39,154 @@
 
 unsigned mem_fetch::sm_next_mf_request_uid = 1;
 
+// Memory-bound kernels create and destroy millions of mem_fetch objects.
+// Storage is carved out of slabs that are never returned to malloc. Every host
+// thread owns the slabs it allocates and recycles their objects through a
+// private free list, so allocation never takes a lock. Slabs are aligned to
+// their size and start with a pointer to their owner. An object freed by
+// another thread is pushed onto the owner's lock-free remote list, which the
+// owner takes over once its own list runs dry, so objects always go back to
+// the slab they came from.
+#define MEM_FETCH_POOL_SLAB_MIN_OBJS 1024
+
+struct mem_fetch_free_slot {
+  mem_fetch_free_slot *next;
+};
+
+struct mem_fetch_pool {
+  mem_fetch_pool() : free_list(NULL), remote_free(NULL) {
+    num_alloc = 0;
+    num_free = 0;
+    num_reserved = 0;
+  }
+  mem_fetch_free_slot *free_list;                  // owner only
+  std::atomic<mem_fetch_free_slot *> remote_free;  // pushed by other threads
+  // statistics, each only written by the thread owning the pool (frees are
+  // counted by the freeing thread) and summed for the report
+  std::atomic<unsigned long long> num_alloc;
+  std::atomic<unsigned long long> num_free;
+  std::atomic<unsigned long long> num_reserved;
+};
+
+// start of every slab, padded so that the objects stay aligned
+union mem_fetch_slab_header {
+  mem_fetch_pool *owner;
+  char pad[64];
+};
+
+// Pools are never destroyed: objects of a pool whose thread has exited may
+// still be freed by others.
+static pthread_mutex_t g_mf_pools_lock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<mem_fetch_pool *> g_mf_pools;
+static thread_local mem_fetch_pool *tl_mf_pool = NULL;
+
+static mem_fetch_pool *mf_thread_pool() {
+  if (tl_mf_pool == NULL) {
+    tl_mf_pool = new mem_fetch_pool();
+    pthread_mutex_lock(&g_mf_pools_lock);
+    g_mf_pools.push_back(tl_mf_pool);
+    pthread_mutex_unlock(&g_mf_pools_lock);
+  }
+  return tl_mf_pool;
+}
+
+// Slab size: the power of two that holds at least
+// MEM_FETCH_POOL_SLAB_MIN_OBJS objects after the header.
+static size_t mf_slab_bytes() {
+  static const size_t bytes = [] {
+    size_t min_bytes = sizeof(mem_fetch_slab_header) +
+                       MEM_FETCH_POOL_SLAB_MIN_OBJS * sizeof(mem_fetch);
+    size_t b = 1;
+    while (b < min_bytes) b <<= 1;
+    return b;
+  }();
+  return bytes;
+}
+
+// Counters are only written by their owner, so a plain load and store is
+// enough; no locked read-modify-write is needed.
+static void mf_pool_count(std::atomic<unsigned long long> &counter,
+                          unsigned long long n) {
+  counter.store(counter.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+}
+
+void *mem_fetch::operator new(size_t size) {
+  assert(size == sizeof(mem_fetch));
+  mem_fetch_pool *pool = mf_thread_pool();
+  if (pool->free_list == NULL)
+    pool->free_list =
+        pool->remote_free.exchange(NULL, std::memory_order_acquire);
+  if (pool->free_list == NULL) {
+    size_t slab_bytes = mf_slab_bytes();
+    void *mem;
+    if (posix_memalign(&mem, slab_bytes, slab_bytes) != 0)
+      throw std::bad_alloc();
+    char *slab = (char *)mem;
+    ((mem_fetch_slab_header *)slab)->owner = pool;
+    unsigned n_objs =
+        (slab_bytes - sizeof(mem_fetch_slab_header)) / sizeof(mem_fetch);
+    char *objs = slab + sizeof(mem_fetch_slab_header);
+    for (unsigned i = n_objs; i > 0; i--) {
+      mem_fetch_free_slot *slot =
+          (mem_fetch_free_slot *)(objs + (i - 1) * sizeof(mem_fetch));
+      slot->next = pool->free_list;
+      pool->free_list = slot;
+    }
+    mf_pool_count(pool->num_reserved, n_objs);
+  }
+  mem_fetch_free_slot *slot = pool->free_list;
+  pool->free_list = slot->next;
+  mf_pool_count(pool->num_alloc, 1);
+  return slot;
+}
+
+void mem_fetch::operator delete(void *p) {
+  if (p == NULL) return;
+  mem_fetch_free_slot *slot = (mem_fetch_free_slot *)p;
+  uintptr_t slab_mask = ~(uintptr_t)(mf_slab_bytes() - 1);
+  mem_fetch_pool *owner =
+      ((mem_fetch_slab_header *)((uintptr_t)p & slab_mask))->owner;
+  mem_fetch_pool *pool = mf_thread_pool();
+  if (owner == pool) {
+    slot->next = pool->free_list;
+    pool->free_list = slot;
+  } else {
+    mem_fetch_free_slot *head =
+        owner->remote_free.load(std::memory_order_relaxed);
+    do {
+      slot->next = head;
+    } while (!owner->remote_free.compare_exchange_weak(
+        head, slot, std::memory_order_release, std::memory_order_relaxed));
+  }
+  mf_pool_count(pool->num_free, 1);
+}
+
+// Sums a counter over all pools. Only meaningful while no other thread is
+// allocating, e.g. between cycles.
+static unsigned long long mf_pool_sum(
+    std::atomic<unsigned long long> mem_fetch_pool::*counter) {
+  unsigned long long sum = 0;
+  pthread_mutex_lock(&g_mf_pools_lock);
+  for (unsigned i = 0; i < g_mf_pools.size(); i++)
+    sum += (g_mf_pools[i]->*counter).load(std::memory_order_relaxed);
+  pthread_mutex_unlock(&g_mf_pools_lock);
+  return sum;
+}
+
+unsigned long long mem_fetch::pool_num_alloc() {
+  return mf_pool_sum(&mem_fetch_pool::num_alloc);
+}
+
+unsigned long long mem_fetch::pool_num_live() {
+  return mf_pool_sum(&mem_fetch_pool::num_alloc) -
+         mf_pool_sum(&mem_fetch_pool::num_free);
+}
+
+unsigned long long mem_fetch::pool_num_reserved() {
+  return mf_pool_sum(&mem_fetch_pool::num_reserved);
+}
+
 mem_fetch::mem_fetch(const mem_access_t &access, const warp_inst_t *inst,
                      unsigned ctrl_size, unsigned wid, unsigned sid,
                      unsigned tpc, const memory_config *config,
@@ -65,13 +218,21 @@ mem_fetch::mem_fetch(const mem_access_t &access, const warp_inst_t *inst,
   icnt_flit_size = config->icnt_flit_size;
   original_mf = m_original_mf;
   original_wr_mf = m_original_wr_mf;
+  for (unsigned i = 0; i < MF_MAX_PENDING_CACHES; i++)
+    m_cache_fields[i].m_owner = NULL;
+  m_tracker_prev = NULL;
+  m_tracker_next = NULL;
+  m_tracker = NULL;
   if (m_original_mf) {
     m_raw_addr.chip = m_original_mf->get_tlx_addr().chip;
     m_raw_addr.sub_partition = m_original_mf->get_tlx_addr().sub_partition;
   }
 }
 
-mem_fetch::~mem_fetch() { m_status = MEM_FETCH_DELETED; }
+mem_fetch::~mem_fetch() {
+  if (m_tracker) m_tracker->erase(this);
+  m_status = MEM_FETCH_DELETED;
+}
 
 #define MF_TUP_BEGIN(X) static const char *Status_str[] = {
 #define MF_TUP(X) #X
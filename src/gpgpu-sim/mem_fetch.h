@@ -50,7 +50,26 @@ enum mf_type {
 #undef MF_TUP
 #undef MF_TUP_END
 
+// Bookkeeping a cache keeps for a miss it sent to the next memory level. It
+// lives in the request itself, so a fill finds it without a lookup. A request
+// can be pending in at most two caches at once (an L1 miss that also misses
+// in the L2).
+#define MF_MAX_PENDING_CACHES 2
+struct mf_cache_fields {
+  const void *m_owner;  // cache that sent the miss, NULL if the slot is free
+  new_addr_type m_block_addr;
+  new_addr_type m_addr;
+  unsigned m_cache_index;
+  unsigned m_data_size;
+  unsigned m_rob_index;  // texture cache reorder buffer entry
+  // this variable is used when a load request generates multiple load
+  // transactions For example, a read request from non-sector L1 request sends
+  // a request to sector L2
+  unsigned pending_read;
+};
+
 class memory_config;
+class mem_fetch_tracker;
 class mem_fetch {
  public:
   mem_fetch(const mem_access_t &access, const warp_inst_t *inst,
@@ -59,6 +78,14 @@ class mem_fetch {
             mem_fetch *original_mf = NULL, mem_fetch *original_wr_mf = NULL);
   ~mem_fetch();
 
+  // mem_fetch objects are recycled through a free list instead of going
+  // back to malloc (see mem_fetch.cc)
+  static void *operator new(size_t size);
+  static void operator delete(void *p);
+  static unsigned long long pool_num_alloc();
+  static unsigned long long pool_num_live();
+  static unsigned long long pool_num_reserved();
+
   void set_status(enum mem_fetch_status status, unsigned long long cycle);
   void set_reply() {
     assert(m_access.get_type() != L1_WRBK_ACC &&
@@ -100,6 +127,25 @@ class mem_fetch {
   enum mf_type get_type() const { return m_type; }
   bool isatomic() const;
 
+  // per-cache miss bookkeeping, see mf_cache_fields
+  mf_cache_fields *get_cache_fields(const void *owner) {
+    for (unsigned i = 0; i < MF_MAX_PENDING_CACHES; i++)
+      if (m_cache_fields[i].m_owner == owner) return &m_cache_fields[i];
+    return NULL;
+  }
+  mf_cache_fields &add_cache_fields(const void *owner) {
+    assert(get_cache_fields(owner) == NULL);
+    mf_cache_fields *f = get_cache_fields(NULL);
+    assert(f != NULL);  // pending in more caches than MF_MAX_PENDING_CACHES
+    f->m_owner = owner;
+    return *f;
+  }
+  void release_cache_fields(const void *owner) {
+    mf_cache_fields *f = get_cache_fields(owner);
+    assert(f != NULL);
+    f->m_owner = NULL;
+  }
+
   void set_return_timestamp(unsigned t) { m_timestamp2 = t; }
   void set_icnt_receive_time(unsigned t) { m_icnt_receive_time = t; }
   unsigned get_timestamp() const { return m_timestamp; }
@@ -168,6 +214,14 @@ class mem_fetch {
   const memory_config *m_mem_config;
   unsigned icnt_flit_size;
 
+  mf_cache_fields m_cache_fields[MF_MAX_PENDING_CACHES];
+
+  // links of the mem_fetch_tracker holding this request
+  friend class mem_fetch_tracker;
+  mem_fetch *m_tracker_prev;
+  mem_fetch *m_tracker_next;
+  mem_fetch_tracker *m_tracker;
+
   mem_fetch
       *original_mf;  // this pointer is set up when a request is divided into
                      // sector requests at L2 cache (if the req size > L2 sector
@@ -176,4 +230,41 @@ class mem_fetch {
                               // when fetch-on-write policy is used
 };
 
+// Set of requests linked through the requests themselves, so inserting and
+// erasing never allocate. A request can be held by one tracker at a time and
+// unlinks itself when it is deleted.
+class mem_fetch_tracker {
+ public:
+  mem_fetch_tracker() : m_head(NULL), m_size(0) {}
+
+  void insert(mem_fetch *mf) {
+    if (mf->m_tracker) return;
+    mf->m_tracker = this;
+    mf->m_tracker_prev = NULL;
+    mf->m_tracker_next = m_head;
+    if (m_head) m_head->m_tracker_prev = mf;
+    m_head = mf;
+    m_size++;
+  }
+  void erase(mem_fetch *mf) {
+    if (!mf || mf->m_tracker != this) return;
+    mf->m_tracker = NULL;
+    if (mf->m_tracker_prev)
+      mf->m_tracker_prev->m_tracker_next = mf->m_tracker_next;
+    else
+      m_head = mf->m_tracker_next;
+    if (mf->m_tracker_next)
+      mf->m_tracker_next->m_tracker_prev = mf->m_tracker_prev;
+    m_size--;
+  }
+  bool empty() const { return m_size == 0; }
+  unsigned size() const { return m_size; }
+  mem_fetch *first() const { return m_head; }
+  static mem_fetch *next(const mem_fetch *mf) { return mf->m_tracker_next; }
+
+ private:
+  mem_fetch *m_head;
+  unsigned m_size;
+};
+
 #endif
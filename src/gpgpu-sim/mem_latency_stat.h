@@ -47,7 +47,7 @@ class memory_stats_t {
   void memlatstat_lat_pw();
   void memlatstat_print(unsigned n_mem, unsigned gpu_mem_n_bk);
 
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
 
   // Reset local L2 stats that are aggregated each sampling window
   void clear_L2_stats_pw();
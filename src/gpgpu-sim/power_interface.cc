@@ -49,12 +49,228 @@ void init_mcpat(const gpgpu_sim_config &config,
       config.num_shader());
 }
 
+static void mcpat_collect(const shader_core_config *shdr_config,
+                          class power_stat_t *power_stats,
+                          unsigned stat_sample_freq, unsigned tot_inst,
+                          unsigned inst, bool dvfs_enabled, mcpat_sample &s) {
+  s.set_model_voltage = dvfs_enabled;
+  s.clk_gated_lanes = shdr_config->gpgpu_clock_gated_lanes;
+  s.stat_sample_freq = stat_sample_freq;
+  s.tot_inst = power_stats->get_total_inst(0);
+  s.int_inst = power_stats->get_total_int_inst(0);
+  s.fp_inst = power_stats->get_total_fp_inst(0);
+  s.load_inst = power_stats->get_l1d_read_accesses(0);
+  s.store_inst = power_stats->get_l1d_write_accesses(0);
+  s.committed_inst = power_stats->get_committed_inst(0);
+
+  // Single RF for both int and fp ops
+  s.regfile_reads = power_stats->get_regfile_reads(0);
+  s.regfile_writes = power_stats->get_regfile_writes(0);
+  s.non_regfile_operands = power_stats->get_non_regfile_operands(0);
+
+  // Instruction cache stats
+  s.icache_hits = power_stats->get_inst_c_hits(0);
+  s.icache_misses = power_stats->get_inst_c_misses(0);
+
+  // Constant Cache, shared memory, texture cache
+  s.ccache_accesses = power_stats->get_const_accessess(0);
+  s.tcache_hits = power_stats->get_texture_c_hits();
+  s.tcache_misses = power_stats->get_texture_c_misses();
+  s.shmem_accesses = power_stats->get_shmem_access(0);
+
+  s.l1_read_hits = power_stats->get_l1d_read_hits(0);
+  s.l1_read_misses = power_stats->get_l1d_read_misses(0);
+  s.l1_write_hits = power_stats->get_l1d_write_hits(0);
+  s.l1_write_misses = power_stats->get_l1d_write_misses(0);
+
+  s.l2_read_hits = power_stats->get_l2_read_hits(0);
+  s.l2_read_misses = power_stats->get_l2_read_misses(0);
+  s.l2_write_hits = power_stats->get_l2_write_hits(0);
+  s.l2_write_misses = power_stats->get_l2_write_misses(0);
+
+  float active_sms = (*power_stats->m_active_sms) / stat_sample_freq;
+  s.num_cores = shdr_config->num_shader();
+  s.num_idle_core = s.num_cores - active_sms;
+
+  // pipeline power - pipeline_duty_cycle *= percent_active_sms;
+  s.pipeline_duty_cycle =
+      ((*power_stats->m_average_pipeline_duty_cycle / (stat_sample_freq)) <
+       0.8)
+          ? ((*power_stats->m_average_pipeline_duty_cycle) / stat_sample_freq)
+          : 0.8;
+
+  // Memory Controller
+  s.dram_rd = power_stats->get_dram_rd(0);
+  s.dram_wr = power_stats->get_dram_wr(0);
+  s.dram_pre = power_stats->get_dram_pre(0);
+
+  // Execution pipeline accesses
+  // FPU (SP) accesses, Integer ALU (not present in Tesla), Sfu accesses
+  s.ialu = power_stats->get_ialu_accessess(0);
+  s.intmul24 = power_stats->get_intmul24_accessess(0);
+  s.intmul32 = power_stats->get_intmul32_accessess(0);
+  s.intmul = power_stats->get_intmul_accessess(0);
+  s.intdiv = power_stats->get_intdiv_accessess(0);
+
+  s.dp = power_stats->get_dp_accessess(0);
+  s.dpmul = power_stats->get_dpmul_accessess(0);
+  s.dpdiv = power_stats->get_dpdiv_accessess(0);
+
+  s.fp = power_stats->get_fp_accessess(0);
+  s.fpmul = power_stats->get_fpmul_accessess(0);
+  s.fpdiv = power_stats->get_fpdiv_accessess(0);
+
+  s.sqrt_acc = power_stats->get_sqrt_accessess(0);
+  s.log_acc = power_stats->get_log_accessess(0);
+  s.sin_acc = power_stats->get_sin_accessess(0);
+  s.exp_acc = power_stats->get_exp_accessess(0);
+
+  s.tensor = power_stats->get_tensor_accessess(0);
+  s.tex = power_stats->get_tex_accessess(0);
+
+  s.tot_fpu = power_stats->get_tot_fpu_accessess(0);
+  s.tot_sfu = power_stats->get_tot_sfu_accessess(0);
+
+  s.active_threads = power_stats->get_active_threads(0);
+
+  // Average active lanes for sp and sfu pipelines
+  s.avg_sp_active_lanes =
+      (power_stats->get_sp_active_lanes()) / stat_sample_freq;
+  s.avg_sfu_active_lanes =
+      (power_stats->get_sfu_active_lanes()) / stat_sample_freq;
+  if (s.avg_sp_active_lanes > 32.0) s.avg_sp_active_lanes = 32.0;
+  if (s.avg_sfu_active_lanes > 32.0) s.avg_sfu_active_lanes = 32.0;
+  assert(s.avg_sp_active_lanes <= 32);
+  assert(s.avg_sfu_active_lanes <= 32);
+
+  double n_icnt_simt_to_mem =
+      (double)
+          power_stats->get_icnt_simt_to_mem(0);  // # flits from SIMT clusters
+                                                // to memory partitions
+  double n_icnt_mem_to_simt =
+      (double)
+          power_stats->get_icnt_mem_to_simt(0);  // # flits from memory
+                                                // partitions to SIMT clusters
+  // Number of flits traversing the interconnect
+  s.noc_accesses = n_icnt_mem_to_simt + n_icnt_simt_to_mem;
+
+  s.insn = tot_inst + inst;
+}
+
+// Run the McPAT model on one sample and write the power/metric traces.
+static void mcpat_evaluate(class gpgpu_sim_wrapper *wrapper,
+                           const mcpat_sample &s) {
+  if (s.set_model_voltage) {
+    wrapper->set_model_voltage(1);  // performance model needs to support this.
+  }
+
+  wrapper->set_inst_power(s.clk_gated_lanes, s.stat_sample_freq,
+                          s.stat_sample_freq, s.tot_inst, s.int_inst,
+                          s.fp_inst, s.load_inst, s.store_inst,
+                          s.committed_inst);
+  wrapper->set_regfile_power(s.regfile_reads, s.regfile_writes,
+                             s.non_regfile_operands);
+  wrapper->set_icache_power(s.icache_hits, s.icache_misses);
+  // assuming all HITS in constant cache for now
+  wrapper->set_ccache_power(s.ccache_accesses, 0);
+  wrapper->set_tcache_power(s.tcache_hits, s.tcache_misses);
+  wrapper->set_shrd_mem_power(s.shmem_accesses);
+  wrapper->set_l1cache_power(s.l1_read_hits, s.l1_read_misses,
+                             s.l1_write_hits, s.l1_write_misses);
+  wrapper->set_l2cache_power(s.l2_read_hits, s.l2_read_misses,
+                             s.l2_write_hits, s.l2_write_misses);
+  wrapper->set_num_cores(s.num_cores);
+  wrapper->set_idle_core_power(s.num_idle_core);
+  wrapper->set_duty_cycle_power(s.pipeline_duty_cycle);
+  wrapper->set_mem_ctrl_power(s.dram_rd, s.dram_wr, s.dram_pre);
+  wrapper->set_int_accesses(s.ialu, s.intmul24, s.intmul32, s.intmul,
+                            s.intdiv);
+  wrapper->set_dp_accesses(s.dp, s.dpmul, s.dpdiv);
+  wrapper->set_fp_accesses(s.fp, s.fpmul, s.fpdiv);
+  wrapper->set_trans_accesses(s.sqrt_acc, s.log_acc, s.sin_acc, s.exp_acc);
+  wrapper->set_tensor_accesses(s.tensor);
+  wrapper->set_tex_accesses(s.tex);
+  wrapper->set_exec_unit_power(s.tot_fpu, s.ialu, s.tot_sfu);
+  wrapper->set_avg_active_threads(s.active_threads);
+  wrapper->set_active_lanes_power(s.avg_sp_active_lanes,
+                                  s.avg_sfu_active_lanes);
+  wrapper->set_NoC_power(s.noc_accesses);
+
+  wrapper->compute();
+
+  wrapper->update_components_power();
+  wrapper->print_trace_files();
+
+  wrapper->detect_print_steady_state(0, s.insn);
+
+  wrapper->power_metrics_calculations();
+
+  wrapper->dump();
+}
+
+mcpat_pipeline::mcpat_pipeline(class gpgpu_sim_wrapper *wrapper)
+    : m_wrapper(wrapper), m_busy(false), m_exit(false) {
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_cond, NULL);
+  int err = pthread_create(&m_thread, NULL, worker_main, this);
+  assert(err == 0);
+}
+
+mcpat_pipeline::~mcpat_pipeline() {
+  pthread_mutex_lock(&m_lock);
+  m_exit = true;
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+  pthread_join(m_thread, NULL);
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+void mcpat_pipeline::push(const mcpat_sample &sample) {
+  pthread_mutex_lock(&m_lock);
+  // bound how far the simulation can run ahead of the power model
+  while (m_queue.size() >= MCPAT_PIPELINE_DEPTH)
+    pthread_cond_wait(&m_cond, &m_lock);
+  m_queue.push_back(sample);
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+}
+
+void mcpat_pipeline::drain() {
+  pthread_mutex_lock(&m_lock);
+  while (!m_queue.empty() || m_busy) pthread_cond_wait(&m_cond, &m_lock);
+  pthread_mutex_unlock(&m_lock);
+}
+
+void *mcpat_pipeline::worker_main(void *arg) {
+  mcpat_pipeline *pipeline = (mcpat_pipeline *)arg;
+  pthread_mutex_lock(&pipeline->m_lock);
+  while (true) {
+    while (pipeline->m_queue.empty() && !pipeline->m_exit)
+      pthread_cond_wait(&pipeline->m_cond, &pipeline->m_lock);
+    if (pipeline->m_queue.empty()) break;
+    mcpat_sample sample = pipeline->m_queue.front();
+    pipeline->m_queue.pop_front();
+    pipeline->m_busy = true;
+    pthread_mutex_unlock(&pipeline->m_lock);
+
+    mcpat_evaluate(pipeline->m_wrapper, sample);
+
+    pthread_mutex_lock(&pipeline->m_lock);
+    pipeline->m_busy = false;
+    pthread_cond_broadcast(&pipeline->m_cond);
+  }
+  pthread_mutex_unlock(&pipeline->m_lock);
+  return NULL;
+}
+
 void mcpat_cycle(const gpgpu_sim_config &config,
                  const shader_core_config *shdr_config,
                  class gpgpu_sim_wrapper *wrapper,
                  class power_stat_t *power_stats, unsigned stat_sample_freq,
                  unsigned tot_cycle, unsigned cycle, unsigned tot_inst,
-                 unsigned inst, bool dvfs_enabled) {
+                 unsigned inst, bool dvfs_enabled,
+                 class mcpat_pipeline *pipeline) {
   static bool mcpat_init = true;
 
   if (mcpat_init) {  // If first cycle, don't have any power numbers yet
@@ -63,126 +279,15 @@ void mcpat_cycle(const gpgpu_sim_config &config,
   }
 
   if ((tot_cycle + cycle) % stat_sample_freq == 0) {
-    if(dvfs_enabled){
-      wrapper->set_model_voltage(1); //performance model needs to support this.
-    }
-
-    wrapper->set_inst_power(
-        shdr_config->gpgpu_clock_gated_lanes, stat_sample_freq,
-        stat_sample_freq, power_stats->get_total_inst(0),
-        power_stats->get_total_int_inst(0), power_stats->get_total_fp_inst(0),
-        power_stats->get_l1d_read_accesses(0),
-        power_stats->get_l1d_write_accesses(0),
-        power_stats->get_committed_inst(0));
-
-    // Single RF for both int and fp ops
-    wrapper->set_regfile_power(power_stats->get_regfile_reads(0),
-                               power_stats->get_regfile_writes(0),
-                               power_stats->get_non_regfile_operands(0));
-
-    // Instruction cache stats
-    wrapper->set_icache_power(power_stats->get_inst_c_hits(0),
-                              power_stats->get_inst_c_misses(0));
-
-    // Constant Cache, shared memory, texture cache
-    wrapper->set_ccache_power(power_stats->get_const_accessess(0), 0); //assuming all HITS in constant cache for now
-    wrapper->set_tcache_power(power_stats->get_texture_c_hits(),
-                              power_stats->get_texture_c_misses());
-    wrapper->set_shrd_mem_power(power_stats->get_shmem_access(0));
-
-    wrapper->set_l1cache_power(
-        power_stats->get_l1d_read_hits(0), power_stats->get_l1d_read_misses(0),
-        power_stats->get_l1d_write_hits(0), power_stats->get_l1d_write_misses(0));
-
-    wrapper->set_l2cache_power(
-        power_stats->get_l2_read_hits(0), power_stats->get_l2_read_misses(0),
-        power_stats->get_l2_write_hits(0), power_stats->get_l2_write_misses(0));
-
-    float active_sms = (*power_stats->m_active_sms) / stat_sample_freq;
-    float num_cores = shdr_config->num_shader();
-    float num_idle_core = num_cores - active_sms;
-    wrapper->set_num_cores(num_cores);
-    wrapper->set_idle_core_power(num_idle_core);
-
-    // pipeline power - pipeline_duty_cycle *= percent_active_sms;
-    float pipeline_duty_cycle =
-        ((*power_stats->m_average_pipeline_duty_cycle / (stat_sample_freq)) <
-         0.8)
-            ? ((*power_stats->m_average_pipeline_duty_cycle) / stat_sample_freq)
-            : 0.8;
-    wrapper->set_duty_cycle_power(pipeline_duty_cycle);
-
-    // Memory Controller
-    wrapper->set_mem_ctrl_power(power_stats->get_dram_rd(0),
-                                power_stats->get_dram_wr(0),
-                                power_stats->get_dram_pre(0));
-
-    // Execution pipeline accesses
-    // FPU (SP) accesses, Integer ALU (not present in Tesla), Sfu accesses
-
-    wrapper->set_int_accesses(power_stats->get_ialu_accessess(0), 
-                              power_stats->get_intmul24_accessess(0), 
-                              power_stats->get_intmul32_accessess(0), 
-                              power_stats->get_intmul_accessess(0), 
-                              power_stats->get_intdiv_accessess(0));
-
-    wrapper->set_dp_accesses(power_stats->get_dp_accessess(0), 
-                              power_stats->get_dpmul_accessess(0), 
-                              power_stats->get_dpdiv_accessess(0));
-
-    wrapper->set_fp_accesses(power_stats->get_fp_accessess(0), 
-                            power_stats->get_fpmul_accessess(0), 
-                            power_stats->get_fpdiv_accessess(0));
-
-    wrapper->set_trans_accesses(power_stats->get_sqrt_accessess(0), 
-                                power_stats->get_log_accessess(0), 
-                                power_stats->get_sin_accessess(0), 
-                                power_stats->get_exp_accessess(0));
-
-    wrapper->set_tensor_accesses(power_stats->get_tensor_accessess(0));
-
-    wrapper->set_tex_accesses(power_stats->get_tex_accessess(0));
-
-    wrapper->set_exec_unit_power(power_stats->get_tot_fpu_accessess(0),
-                                 power_stats->get_ialu_accessess(0),
-                                 power_stats->get_tot_sfu_accessess(0));
-
-    wrapper->set_avg_active_threads(power_stats->get_active_threads(0));
-
-    // Average active lanes for sp and sfu pipelines
-    float avg_sp_active_lanes =
-        (power_stats->get_sp_active_lanes()) / stat_sample_freq;
-    float avg_sfu_active_lanes =
-        (power_stats->get_sfu_active_lanes()) / stat_sample_freq;
-    if(avg_sp_active_lanes >32.0 )
-      avg_sp_active_lanes = 32.0;
-    if(avg_sfu_active_lanes >32.0 )
-      avg_sfu_active_lanes = 32.0;
-    assert(avg_sp_active_lanes <= 32);
-    assert(avg_sfu_active_lanes <= 32);
-    wrapper->set_active_lanes_power(avg_sp_active_lanes, avg_sfu_active_lanes);
-
-    double n_icnt_simt_to_mem =
-        (double)
-            power_stats->get_icnt_simt_to_mem(0);  // # flits from SIMT clusters
-                                                  // to memory partitions
-    double n_icnt_mem_to_simt =
-        (double)
-            power_stats->get_icnt_mem_to_simt(0);  // # flits from memory
-                                                  // partitions to SIMT clusters
-    wrapper->set_NoC_power(n_icnt_mem_to_simt + n_icnt_simt_to_mem);  // Number of flits traversing the interconnect
-
-    wrapper->compute();
-
-    wrapper->update_components_power();
-    wrapper->print_trace_files();
+    mcpat_sample sample;
+    mcpat_collect(shdr_config, power_stats, stat_sample_freq, tot_inst, inst,
+                  dvfs_enabled, sample);
     power_stats->save_stats();
 
-    wrapper->detect_print_steady_state(0, tot_inst + inst);
-
-    wrapper->power_metrics_calculations();
-
-    wrapper->dump();
+    if (pipeline)
+      pipeline->push(sample);
+    else
+      mcpat_evaluate(wrapper, sample);
   }
   // wrapper->close_files();
 }
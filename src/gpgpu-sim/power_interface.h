@@ -37,6 +37,68 @@
 
 #include "gpgpu_sim_wrapper.h"
 
+#include <pthread.h>
+#include <deque>
+
+// samples the simulation may run ahead of the power model
+#define MCPAT_PIPELINE_DEPTH 64
+
+// Counter values of one power sample. They are read from power_stat_t on the
+// simulation thread and handed to the McPAT model as is, so evaluating a
+// sample later (on the mcpat_pipeline thread) gives the same result.
+struct mcpat_sample {
+  bool set_model_voltage;
+  bool clk_gated_lanes;
+  double stat_sample_freq;
+  double tot_inst, int_inst, fp_inst, load_inst, store_inst, committed_inst;
+  double regfile_reads, regfile_writes, non_regfile_operands;
+  double icache_hits, icache_misses;
+  double ccache_accesses;
+  double tcache_hits, tcache_misses;
+  double shmem_accesses;
+  double l1_read_hits, l1_read_misses, l1_write_hits, l1_write_misses;
+  double l2_read_hits, l2_read_misses, l2_write_hits, l2_write_misses;
+  float num_cores, num_idle_core;
+  float pipeline_duty_cycle;
+  double dram_rd, dram_wr, dram_pre;
+  double ialu, intmul24, intmul32, intmul, intdiv;
+  double dp, dpmul, dpdiv;
+  double fp, fpmul, fpdiv;
+  double sqrt_acc, log_acc, sin_acc, exp_acc;
+  double tensor, tex;
+  double tot_fpu, tot_sfu;
+  float active_threads;
+  float avg_sp_active_lanes, avg_sfu_active_lanes;
+  double noc_accesses;
+  unsigned insn;  // tot_inst + inst, for steady state detection
+};
+
+// Evaluates power samples on a dedicated host thread (-power_eval_async).
+// The simulation thread only gathers the counters of a sample; the McPAT
+// model and the power/metric trace output run concurrently with the
+// following cycles, one sample at a time and in order. Any other use of the
+// wrapper must be preceded by drain().
+class mcpat_pipeline {
+ public:
+  mcpat_pipeline(class gpgpu_sim_wrapper *wrapper);
+  ~mcpat_pipeline();
+
+  void push(const mcpat_sample &sample);
+  // wait until every queued sample has been evaluated
+  void drain();
+
+ private:
+  static void *worker_main(void *arg);
+
+  class gpgpu_sim_wrapper *m_wrapper;
+  pthread_t m_thread;
+  pthread_mutex_t m_lock;
+  pthread_cond_t m_cond;
+  std::deque<mcpat_sample> m_queue;
+  bool m_busy;  // worker is evaluating a sample taken off the queue
+  bool m_exit;
+};
+
 void init_mcpat(const gpgpu_sim_config &config,
                 class gpgpu_sim_wrapper *wrapper, unsigned stat_sample_freq,
                 unsigned tot_inst, unsigned inst);
@@ -45,7 +107,8 @@ void mcpat_cycle(const gpgpu_sim_config &config,
                  class gpgpu_sim_wrapper *wrapper,
                  class power_stat_t *power_stats, unsigned stat_sample_freq,
                  unsigned tot_cycle, unsigned cycle, unsigned tot_inst,
-                 unsigned inst, bool dvfs_enabled);
+                 unsigned inst, bool dvfs_enabled,
+                 class mcpat_pipeline *pipeline);
 
 void calculate_hw_mcpat(const gpgpu_sim_config &config,
                  const shader_core_config *shdr_config,
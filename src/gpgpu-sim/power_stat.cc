@@ -167,7 +167,7 @@ void power_mem_stat_t::save_stats() {
   }
 }
 
-void power_mem_stat_t::visualizer_print(gzFile power_visualizer_file) {}
+void power_mem_stat_t::visualizer_print(visualizer_log *log) {}
 
 void power_mem_stat_t::print(FILE *fout) const {
   fprintf(fout, "\n\n==========Power Metrics -- Memory==========\n");
@@ -199,7 +199,7 @@ power_core_stat_t::power_core_stat_t(const shader_core_config *shader_config,
   init();
 }
 
-void power_core_stat_t::visualizer_print(gzFile visualizer_file) {}
+void power_core_stat_t::visualizer_print(visualizer_log *log) {}
 
 void power_core_stat_t::print(FILE *fout) {
   // per core statistics
@@ -428,9 +428,9 @@ power_stat_t::power_stat_t(const shader_core_config *shader_config,
   sfu_active_lanes_execution = 0;
 }
 
-void power_stat_t::visualizer_print(gzFile visualizer_file) {
-  pwr_core_stat->visualizer_print(visualizer_file);
-  pwr_mem_stat->visualizer_print(visualizer_file);
+void power_stat_t::visualizer_print(visualizer_log *log) {
+  pwr_core_stat->visualizer_print(log);
+  pwr_mem_stat->visualizer_print(log);
 }
 
 void power_stat_t::print(FILE *fout) const {
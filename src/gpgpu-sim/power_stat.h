@@ -93,7 +93,7 @@ class power_core_stat_t : public shader_core_power_stats_pod {
  public:
   power_core_stat_t(const shader_core_config *shader_config,
                     shader_core_stats *core_stats);
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
   void print(FILE *fout);
   void init();
   void save_stats();
@@ -132,7 +132,7 @@ class power_mem_stat_t : public mem_power_stats_pod {
   power_mem_stat_t(const memory_config *mem_config,
                    const shader_core_config *shdr_config,
                    memory_stats_t *mem_stats, shader_core_stats *shdr_stats);
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
   void print(FILE *fout) const;
   void init();
   void save_stats();
@@ -150,7 +150,7 @@ class power_stat_t {
                float *average_pipeline_duty_cycle, float *active_sms,
                shader_core_stats *shader_stats, const memory_config *mem_config,
                memory_stats_t *memory_stats);
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
   void print(FILE *fout) const;
   void save_stats() {
     pwr_core_stat->save_stats();
@@ -31,32 +31,53 @@
 #include "shader.h"
 #include "shader_trace.h"
 
+// Initial width of the register bitmasks, widened on demand to the highest
+// register number reserved
+#define SCOREBOARD_INIT_REGS 256
+
 // Constructor
-Scoreboard::Scoreboard(unsigned sid, unsigned n_warps, class gpgpu_t* gpu)
-    : longopregs() {
+Scoreboard::Scoreboard(unsigned sid, unsigned n_warps, class gpgpu_t* gpu) {
   m_sid = sid;
+  m_n_warps = n_warps;
+  m_words = SCOREBOARD_INIT_REGS / 64;
   // Initialize size of table
-  reg_table.resize(n_warps);
-  longopregs.resize(n_warps);
+  reg_table.assign(n_warps * m_words, 0);
+  longopregs.assign(n_warps * m_words, 0);
+  m_n_pending.assign(n_warps, 0);
 
   m_gpu = gpu;
 }
 
+void Scoreboard::grow(unsigned regnum) {
+  unsigned words = m_words;
+  while (regnum / 64 >= words) words *= 2;
+  std::vector<reg_mask_t> pending(m_n_warps * words, 0);
+  std::vector<reg_mask_t> longop(m_n_warps * words, 0);
+  for (unsigned wid = 0; wid < m_n_warps; wid++) {
+    for (unsigned w = 0; w < m_words; w++) {
+      pending[wid * words + w] = reg_table[wid * m_words + w];
+      longop[wid * words + w] = longopregs[wid * m_words + w];
+    }
+  }
+  reg_table.swap(pending);
+  longopregs.swap(longop);
+  m_words = words;
+}
+
 // Print scoreboard contents
 void Scoreboard::printContents() const {
   printf("scoreboard contents (sid=%d): \n", m_sid);
-  for (unsigned i = 0; i < reg_table.size(); i++) {
-    if (reg_table[i].size() == 0) continue;
+  for (unsigned i = 0; i < m_n_warps; i++) {
+    if (m_n_pending[i] == 0) continue;
     printf("  wid = %2d: ", i);
-    std::set<unsigned>::const_iterator it;
-    for (it = reg_table[i].begin(); it != reg_table[i].end(); it++)
-      printf("%u ", *it);
+    for (unsigned r = 0; r < m_words * 64; r++)
+      if (test(reg_table, i, r)) printf("%u ", r);
     printf("\n");
   }
 }
 
 void Scoreboard::reserveRegister(unsigned wid, unsigned regnum) {
-  if (!(reg_table[wid].find(regnum) == reg_table[wid].end())) {
+  if (test(reg_table, wid, regnum)) {
     printf(
         "Error: trying to reserve an already reserved register (sid=%d, "
         "wid=%d, regnum=%d).",
@@ -65,19 +86,21 @@ void Scoreboard::reserveRegister(unsigned wid, unsigned regnum) {
   }
   SHADER_DPRINTF(SCOREBOARD, "Reserved Register - warp:%d, reg: %d\n", wid,
                  regnum);
-  reg_table[wid].insert(regnum);
+  set(reg_table, wid, regnum);
+  m_n_pending[wid]++;
 }
 
 // Unmark register as write-pending
 void Scoreboard::releaseRegister(unsigned wid, unsigned regnum) {
-  if (!(reg_table[wid].find(regnum) != reg_table[wid].end())) return;
+  if (!test(reg_table, wid, regnum)) return;
   SHADER_DPRINTF(SCOREBOARD, "Release register - warp:%d, reg: %d\n", wid,
                  regnum);
-  reg_table[wid].erase(regnum);
+  clear(reg_table, wid, regnum);
+  m_n_pending[wid]--;
 }
 
 const bool Scoreboard::islongop(unsigned warp_id, unsigned regnum) {
-  return longopregs[warp_id].find(regnum) != longopregs[warp_id].end();
+  return test(longopregs, warp_id, regnum);
 }
 
 void Scoreboard::reserveRegisters(const class warp_inst_t* inst) {
@@ -100,7 +123,7 @@ void Scoreboard::reserveRegisters(const class warp_inst_t* inst) {
       if (inst->out[r] > 0) {
         SHADER_DPRINTF(SCOREBOARD, "New longopreg marked - warp:%d, reg: %d\n",
                        inst->warp_id(), inst->out[r]);
-        longopregs[inst->warp_id()].insert(inst->out[r]);
+        set(longopregs, inst->warp_id(), inst->out[r]);
       }
     }
   }
@@ -113,7 +136,7 @@ void Scoreboard::releaseRegisters(const class warp_inst_t* inst) {
       SHADER_DPRINTF(SCOREBOARD, "Register Released - warp:%d, reg: %d\n",
                      inst->warp_id(), inst->out[r]);
       releaseRegister(inst->warp_id(), inst->out[r]);
-      longopregs[inst->warp_id()].erase(inst->out[r]);
+      clear(longopregs, inst->warp_id(), inst->out[r]);
     }
   }
 }
@@ -126,29 +149,21 @@ void Scoreboard::releaseRegisters(const class warp_inst_t* inst) {
  * true if WAW or RAW hazard (no WAR since in-order issue)
  **/
 bool Scoreboard::checkCollision(unsigned wid, const class inst_t* inst) const {
-  // Get list of all input and output registers
-  std::set<int> inst_regs;
+  if (m_n_pending[wid] == 0) return false;
 
+  // Check for collision: test the reserved bit of every input and output
+  // register of the instruction
+  bool collision = false;
   for (unsigned iii = 0; iii < inst->outcount; iii++)
-    inst_regs.insert(inst->out[iii]);
-
+    collision |= test(reg_table, wid, inst->out[iii]);
   for (unsigned jjj = 0; jjj < inst->incount; jjj++)
-    inst_regs.insert(inst->in[jjj]);
-
-  if (inst->pred > 0) inst_regs.insert(inst->pred);
-  if (inst->ar1 > 0) inst_regs.insert(inst->ar1);
-  if (inst->ar2 > 0) inst_regs.insert(inst->ar2);
-
-  // Check for collision, get the intersection of reserved registers and
-  // instruction registers
-  std::set<int>::const_iterator it2;
-  for (it2 = inst_regs.begin(); it2 != inst_regs.end(); it2++)
-    if (reg_table[wid].find(*it2) != reg_table[wid].end()) {
-      return true;
-    }
-  return false;
+    collision |= test(reg_table, wid, inst->in[jjj]);
+  if (inst->pred > 0) collision |= test(reg_table, wid, inst->pred);
+  if (inst->ar1 > 0) collision |= test(reg_table, wid, inst->ar1);
+  if (inst->ar2 > 0) collision |= test(reg_table, wid, inst->ar2);
+  return collision;
 }
 
 bool Scoreboard::pendingWrites(unsigned wid) const {
-  return !reg_table[wid].empty();
+  return m_n_pending[wid] != 0;
 }
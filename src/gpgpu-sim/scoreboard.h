@@ -28,7 +28,6 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <set>
 #include <vector>
 #include "assert.h"
 
@@ -54,13 +53,33 @@ class Scoreboard {
   void reserveRegister(unsigned wid, unsigned regnum);
   int get_sid() const { return m_sid; }
 
+  // one bit per register number, warp wid owns words
+  // [wid * m_words, (wid + 1) * m_words) of a table
+  typedef unsigned long long reg_mask_t;
+  bool test(const std::vector<reg_mask_t> &table, unsigned wid,
+            unsigned regnum) const {
+    unsigned w = regnum / 64;
+    return w < m_words && ((table[wid * m_words + w] >> (regnum % 64)) & 1);
+  }
+  void set(std::vector<reg_mask_t> &table, unsigned wid, unsigned regnum) {
+    if (regnum / 64 >= m_words) grow(regnum);
+    table[wid * m_words + regnum / 64] |= 1ULL << (regnum % 64);
+  }
+  void clear(std::vector<reg_mask_t> &table, unsigned wid, unsigned regnum) {
+    if (regnum / 64 < m_words)
+      table[wid * m_words + regnum / 64] &= ~(1ULL << (regnum % 64));
+  }
+  void grow(unsigned regnum);
+
   unsigned m_sid;
+  unsigned m_n_warps;
+  unsigned m_words;
 
   // keeps track of pending writes to registers
-  // indexed by warp id, reg_id => pending write count
-  std::vector<std::set<unsigned> > reg_table;
+  std::vector<reg_mask_t> reg_table;
+  std::vector<unsigned> m_n_pending;  // pending writes per warp
   // Register that depend on a long operation (global, local or tex memory)
-  std::vector<std::set<unsigned> > longopregs;
+  std::vector<reg_mask_t> longopregs;
 
   class gpgpu_t *m_gpu;
 };
@@ -49,6 +49,7 @@
 #include "stat-tool.h"
 #include "traffic_breakdown.h"
 #include "visualizer.h"
+#include "visualizer_log.h"
 
 #define PRIORITIZE_MSHR_OVER_WB 1
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
@@ -757,38 +758,37 @@ void shader_core_stats::event_warp_issued(unsigned s_id, unsigned warp_id,
   }
 }
 
-void shader_core_stats::visualizer_print(gzFile visualizer_file) {
+void shader_core_stats::visualizer_print(visualizer_log *log) {
   // warp divergence breakdown
-  gzprintf(visualizer_file, "WarpDivergenceBreakdown:");
+  log->begin_row("WarpDivergenceBreakdown");
   unsigned int total = 0;
   unsigned int cf =
       (m_config->gpgpu_warpdistro_shader == -1) ? m_config->num_shader() : 1;
-  gzprintf(visualizer_file, " %d",
-           (shader_cycle_distro[0] - last_shader_cycle_distro[0]) / cf);
-  gzprintf(visualizer_file, " %d",
-           (shader_cycle_distro[1] - last_shader_cycle_distro[1]) / cf);
-  gzprintf(visualizer_file, " %d",
-           (shader_cycle_distro[2] - last_shader_cycle_distro[2]) / cf);
+  log->add((shader_cycle_distro[0] - last_shader_cycle_distro[0]) / cf);
+  log->add((shader_cycle_distro[1] - last_shader_cycle_distro[1]) / cf);
+  log->add((shader_cycle_distro[2] - last_shader_cycle_distro[2]) / cf);
   for (unsigned i = 0; i < m_config->warp_size + 3; i++) {
     if (i >= 3) {
       total += (shader_cycle_distro[i] - last_shader_cycle_distro[i]);
       if (((i - 3) % (m_config->warp_size / 8)) ==
           ((m_config->warp_size / 8) - 1)) {
-        gzprintf(visualizer_file, " %d", total / cf);
+        log->add(total / cf);
         total = 0;
       }
     }
     last_shader_cycle_distro[i] = shader_cycle_distro[i];
   }
-  gzprintf(visualizer_file, "\n");
+  log->end_row();
 
-  gzprintf(visualizer_file, "ctas_completed: %d\n", ctas_completed);
+  log->begin_row("ctas_completed");
+  log->add(ctas_completed);
+  log->end_row();
   ctas_completed = 0;
   // warp issue breakdown
   unsigned sid = m_config->gpgpu_warp_issue_shader;
   unsigned count = 0;
   unsigned warp_id_issued_sum = 0;
-  gzprintf(visualizer_file, "WarpIssueSlotBreakdown:");
+  log->begin_row("WarpIssueSlotBreakdown");
   if (m_shader_warp_slot_issue_distro[sid].size() > 0) {
     for (std::vector<unsigned>::const_iterator iter =
              m_shader_warp_slot_issue_distro[sid].begin();
@@ -796,20 +796,20 @@ void shader_core_stats::visualizer_print(gzFile visualizer_file) {
       unsigned diff = count < m_last_shader_warp_slot_issue_distro.size()
                           ? *iter - m_last_shader_warp_slot_issue_distro[count]
                           : *iter;
-      gzprintf(visualizer_file, " %d", diff);
+      log->add(diff);
       warp_id_issued_sum += diff;
     }
     m_last_shader_warp_slot_issue_distro = m_shader_warp_slot_issue_distro[sid];
   } else {
-    gzprintf(visualizer_file, " 0");
+    log->add(0u);
   }
-  gzprintf(visualizer_file, "\n");
+  log->end_row();
 
 #define DYNAMIC_WARP_PRINT_RESOLUTION 32
   unsigned total_issued_this_resolution = 0;
   unsigned dynamic_id_issued_sum = 0;
   count = 0;
-  gzprintf(visualizer_file, "WarpIssueDynamicIdBreakdown:");
+  log->begin_row("WarpIssueDynamicIdBreakdown");
   if (m_shader_dynamic_warp_issue_distro[sid].size() > 0) {
     for (std::vector<unsigned>::const_iterator iter =
              m_shader_dynamic_warp_issue_distro[sid].begin();
@@ -821,44 +821,43 @@ void shader_core_stats::visualizer_print(gzFile visualizer_file) {
               : *iter;
       total_issued_this_resolution += diff;
       if ((count + 1) % DYNAMIC_WARP_PRINT_RESOLUTION == 0) {
-        gzprintf(visualizer_file, " %d", total_issued_this_resolution);
+        log->add(total_issued_this_resolution);
         dynamic_id_issued_sum += total_issued_this_resolution;
         total_issued_this_resolution = 0;
       }
     }
     if (count % DYNAMIC_WARP_PRINT_RESOLUTION != 0) {
-      gzprintf(visualizer_file, " %d", total_issued_this_resolution);
+      log->add(total_issued_this_resolution);
       dynamic_id_issued_sum += total_issued_this_resolution;
     }
     m_last_shader_dynamic_warp_issue_distro =
         m_shader_dynamic_warp_issue_distro[sid];
     assert(warp_id_issued_sum == dynamic_id_issued_sum);
   } else {
-    gzprintf(visualizer_file, " 0");
+    log->add(0u);
   }
-  gzprintf(visualizer_file, "\n");
+  log->end_row();
 
   // overall cache miss rates
-  gzprintf(visualizer_file, "gpgpu_n_l1cache_bkconflict: %d\n",
-           gpgpu_n_l1cache_bkconflict);
-  gzprintf(visualizer_file, "gpgpu_n_shmem_bkconflict: %d\n",
-           gpgpu_n_shmem_bkconflict);
+  log->begin_row("gpgpu_n_l1cache_bkconflict");
+  log->add(gpgpu_n_l1cache_bkconflict);
+  log->end_row();
+  log->begin_row("gpgpu_n_shmem_bkconflict");
+  log->add(gpgpu_n_shmem_bkconflict);
+  log->end_row();
 
   // instruction count per shader core
-  gzprintf(visualizer_file, "shaderinsncount:  ");
-  for (unsigned i = 0; i < m_config->num_shader(); i++)
-    gzprintf(visualizer_file, "%u ", m_num_sim_insn[i]);
-  gzprintf(visualizer_file, "\n");
+  log->begin_row("shaderinsncount");
+  log->add(m_num_sim_insn, m_config->num_shader());
+  log->end_row();
   // warp instruction count per shader core
-  gzprintf(visualizer_file, "shaderwarpinsncount:  ");
-  for (unsigned i = 0; i < m_config->num_shader(); i++)
-    gzprintf(visualizer_file, "%u ", m_num_sim_winsn[i]);
-  gzprintf(visualizer_file, "\n");
+  log->begin_row("shaderwarpinsncount");
+  log->add(m_num_sim_winsn, m_config->num_shader());
+  log->end_row();
   // warp divergence per shader core
-  gzprintf(visualizer_file, "shaderwarpdiv: ");
-  for (unsigned i = 0; i < m_config->num_shader(); i++)
-    gzprintf(visualizer_file, "%u ", m_n_diverge[i]);
-  gzprintf(visualizer_file, "\n");
+  log->begin_row("shaderwarpdiv");
+  log->add(m_n_diverge, m_config->num_shader());
+  log->end_row();
 }
 
 #define PROGRAM_MEM_START                                      \
@@ -1993,12 +1992,12 @@ mem_stage_stall_type ldst_unit::process_cache_access(
     inst.accessq_pop_back();
     if (inst.is_load()) {
       for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++)
-        if (inst.out[r] > 0) m_pending_writes[inst.warp_id()][inst.out[r]]--;
+        if (inst.out[r] > 0) pending_writes(inst.warp_id(), inst.out[r])--;
       
       // release LDGSTS
       if (inst.m_is_ldgsts) {
-        m_pending_ldgsts[inst.warp_id()][inst.pc][inst.get_addr(0)]--;
-        if (m_pending_ldgsts[inst.warp_id()][inst.pc][inst.get_addr(0)] == 0) {
+        if (--m_pending_ldgsts.counter(inst.warp_id(), inst.pc,
+                                       inst.get_addr(0)) == 0) {
           m_core->unset_depbar(inst);
         }
       }
@@ -2117,14 +2116,12 @@ void ldst_unit::L1_latency_queue_cycle() {
         if (mf_next->get_inst().is_load()) {
           for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++)
             if (mf_next->get_inst().out[r] > 0) {
-              assert(m_pending_writes[mf_next->get_inst().warp_id()]
-                                     [mf_next->get_inst().out[r]] > 0);
+              assert(pending_writes_count(mf_next->get_inst().warp_id(),
+                                          mf_next->get_inst().out[r]) > 0);
               unsigned still_pending =
-                  --m_pending_writes[mf_next->get_inst().warp_id()]
-                                    [mf_next->get_inst().out[r]];
+                  --pending_writes(mf_next->get_inst().warp_id(),
+                                   mf_next->get_inst().out[r]);
               if (!still_pending) {
-                m_pending_writes[mf_next->get_inst().warp_id()].erase(
-                    mf_next->get_inst().out[r]);
                 m_scoreboard->releaseRegister(mf_next->get_inst().warp_id(),
                                               mf_next->get_inst().out[r]);
                 m_core->warp_inst_complete(mf_next->get_inst());
@@ -2133,8 +2130,10 @@ void ldst_unit::L1_latency_queue_cycle() {
 
           // release LDGSTS
           if (mf_next->get_inst().m_is_ldgsts) {
-            m_pending_ldgsts[mf_next->get_inst().warp_id()][mf_next->get_inst().pc][mf_next->get_inst().get_addr(0)]--;
-            if (m_pending_ldgsts[mf_next->get_inst().warp_id()][mf_next->get_inst().pc][mf_next->get_inst().get_addr(0)] == 0) {
+            if (--m_pending_ldgsts.counter(mf_next->get_inst().warp_id(),
+                                           mf_next->get_inst().pc,
+                                           mf_next->get_inst().get_addr(0)) ==
+                0) {
               m_core->unset_depbar(mf_next->get_inst());
             }
           }
@@ -2201,7 +2200,8 @@ bool ldst_unit::constant_cycle(warp_inst_t &inst, mem_stage_stall_type &rc_fail,
     while (inst.accessq_count() > 0) inst.accessq_pop_back();
     if (inst.is_load()) {
       for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++)
-        if (inst.out[r] > 0) m_pending_writes[inst.warp_id()][inst.out[r]] -= access_count;
+        if (inst.out[r] > 0)
+          pending_writes(inst.warp_id(), inst.out[r]) -= access_count;
     }
   } else {
     fail = process_memory_access_queue(m_L1C, inst);
@@ -2271,7 +2271,7 @@ bool ldst_unit::memory_cycle(warp_inst_t &inst,
       if (inst.is_load()) {
         for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++)
           if (inst.out[r] > 0)
-            assert(m_pending_writes[inst.warp_id()][inst.out[r]] > 0);
+            assert(pending_writes_count(inst.warp_id(), inst.out[r]) > 0);
       } else if (inst.is_store())
         m_core->inc_store_req(inst.warp_id());
     }
@@ -2584,6 +2584,50 @@ void ldst_unit::init(mem_fetch_interface *icnt,
   m_next_global = NULL;
   m_last_inst_gpu_sim_cycle = 0;
   m_last_inst_gpu_tot_sim_cycle = 0;
+  m_pending_writes.resize(config->max_warps_per_shader);
+}
+
+unsigned pending_ldgsts_table::find(unsigned warp_id, unsigned pc,
+                                    unsigned addr) const {
+  unsigned long long h = warp_id * 0x9e3779b97f4a7c15ULL;
+  h ^= pc * 0xc2b2ae3d27d4eb4fULL;
+  h ^= addr * 0x165667b19e3779f9ULL;
+  h ^= h >> 29;
+  unsigned mask = m_slots.size() - 1;
+  for (unsigned i = h & mask;; i = (i + 1) & mask) {
+    const slot_t &slot = m_slots[i];
+    if (!slot.used ||
+        (slot.warp_id == warp_id && slot.pc == pc && slot.addr == addr))
+      return i;
+  }
+}
+
+unsigned &pending_ldgsts_table::counter(unsigned warp_id, unsigned pc,
+                                        unsigned addr) {
+  unsigned i = find(warp_id, pc, addr);
+  if (m_slots[i].used) return m_slots[i].count;
+  if (2 * (m_used + 1) > m_slots.size()) {
+    std::vector<slot_t> old(2 * m_slots.size());
+    m_slots.swap(old);
+    for (unsigned j = 0; j < old.size(); j++)
+      if (old[j].used)
+        m_slots[find(old[j].warp_id, old[j].pc, old[j].addr)] = old[j];
+    i = find(warp_id, pc, addr);
+  }
+  slot_t &slot = m_slots[i];
+  slot.used = true;
+  slot.warp_id = warp_id;
+  slot.pc = pc;
+  slot.addr = addr;
+  slot.count = 0;
+  m_used++;
+  return slot.count;
+}
+
+unsigned pending_ldgsts_table::count(unsigned warp_id, unsigned pc,
+                                     unsigned addr) const {
+  const slot_t &slot = m_slots[find(warp_id, pc, addr)];
+  return slot.used ? slot.count : 0;
 }
 
 ldst_unit::ldst_unit(mem_fetch_interface *icnt,
@@ -2639,7 +2683,7 @@ void ldst_unit::issue(register_set &reg_set) {
     for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++) {
       unsigned reg_id = inst->out[r];
       if (reg_id > 0) {
-        m_pending_writes[warp_id][reg_id] += n_accesses;
+        pending_writes(warp_id, reg_id) += n_accesses;
       }
     }
   }
@@ -2659,11 +2703,11 @@ void ldst_unit::writeback() {
       for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++) {
         if (m_next_wb.out[r] > 0) {
           if (m_next_wb.space.get_type() != shared_space) {
-            assert(m_pending_writes[m_next_wb.warp_id()][m_next_wb.out[r]] > 0);
+            assert(pending_writes_count(m_next_wb.warp_id(),
+                                        m_next_wb.out[r]) > 0);
             unsigned still_pending =
-                --m_pending_writes[m_next_wb.warp_id()][m_next_wb.out[r]];
+                --pending_writes(m_next_wb.warp_id(), m_next_wb.out[r]);
             if (!still_pending) {
-              m_pending_writes[m_next_wb.warp_id()].erase(m_next_wb.out[r]);
               m_scoreboard->releaseRegister(m_next_wb.warp_id(),
                                             m_next_wb.out[r]);
               insn_completed = true;
@@ -2675,8 +2719,8 @@ void ldst_unit::writeback() {
           }
         }
         else if (m_next_wb.m_is_ldgsts) { // for LDGSTS instructions where no output register is used
-          m_pending_ldgsts[m_next_wb.warp_id()][m_next_wb.pc][m_next_wb.get_addr(0)]--;
-          if (m_pending_ldgsts[m_next_wb.warp_id()][m_next_wb.pc][m_next_wb.get_addr(0)] == 0) {
+          if (--m_pending_ldgsts.counter(m_next_wb.warp_id(), m_next_wb.pc,
+                                         m_next_wb.get_addr(0)) == 0) {
             insn_completed = true;
           }
           break;
@@ -2895,15 +2939,10 @@ void ldst_unit::cycle() {
         for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++) {
           unsigned reg_id = pipe_reg.out[r];
           if (reg_id > 0) {
-            if (m_pending_writes[warp_id].find(reg_id) !=
-                m_pending_writes[warp_id].end()) {
-              if (m_pending_writes[warp_id][reg_id] > 0) {
-                pending_requests = true;
-                break;
-              } else {
-                // this instruction is done already
-                m_pending_writes[warp_id].erase(reg_id);
-              }
+            // a count of 0 means this instruction is done already
+            if (pending_writes_count(warp_id, reg_id) > 0) {
+              pending_requests = true;
+              break;
             }
           }
         }
@@ -2914,7 +2953,9 @@ void ldst_unit::cycle() {
           // release LDGSTS
           if (m_dispatch_reg->m_is_ldgsts) {
             // m_pending_ldgsts[m_dispatch_reg->warp_id()][m_dispatch_reg->pc][m_dispatch_reg->get_addr(0)]--;
-            if (m_pending_ldgsts[m_dispatch_reg->warp_id()][m_dispatch_reg->pc][m_dispatch_reg->get_addr(0)] == 0) {
+            if (m_pending_ldgsts.count(m_dispatch_reg->warp_id(),
+                                       m_dispatch_reg->pc,
+                                       m_dispatch_reg->get_addr(0)) == 0) {
               m_core->unset_depbar(*m_dispatch_reg);
             }
           }
@@ -2939,6 +2980,7 @@ void shader_core_ctx::register_cta_thread_exit(unsigned cta_num,
     // Increment the completed CTAs
     m_stats->ctas_completed++;
     m_gpu->inc_completed_cta();
+    if (m_gpu->cta_sampling_enabled()) m_gpu->record_sampled_cta();
     m_n_active_cta--;
     m_barriers.deallocate_barrier(cta_num);
     shader_CTA_count_unlog(m_sid, 1);
@@ -3349,20 +3391,16 @@ void ldst_unit::print(FILE *fout) const {
       "Last LD/ST writeback @ %llu + %llu (gpu_sim_cycle+gpu_tot_sim_cycle)\n",
       m_last_inst_gpu_sim_cycle, m_last_inst_gpu_tot_sim_cycle);
   fprintf(fout, "Pending register writes:\n");
-  std::map<unsigned /*warp_id*/,
-           std::map<unsigned /*regnum*/, unsigned /*count*/> >::const_iterator
-      w;
-  for (w = m_pending_writes.begin(); w != m_pending_writes.end(); w++) {
-    unsigned warp_id = w->first;
-    const std::map<unsigned /*regnum*/, unsigned /*count*/> &warp_info =
-        w->second;
-    if (warp_info.empty()) continue;
-    fprintf(fout, "  w%2u : ", warp_id);
-    std::map<unsigned /*regnum*/, unsigned /*count*/>::const_iterator r;
-    for (r = warp_info.begin(); r != warp_info.end(); ++r) {
-      fprintf(fout, "  %u(%u)", r->first, r->second);
+  for (unsigned warp_id = 0; warp_id < m_pending_writes.size(); warp_id++) {
+    const std::vector<unsigned> &warp_info = m_pending_writes[warp_id];
+    bool printed = false;
+    for (unsigned reg_id = 0; reg_id < warp_info.size(); reg_id++) {
+      if (!warp_info[reg_id]) continue;
+      if (!printed) fprintf(fout, "  w%2u : ", warp_id);
+      printed = true;
+      fprintf(fout, "  %u(%u)", reg_id, warp_info[reg_id]);
     }
-    fprintf(fout, "\n");
+    if (printed) fprintf(fout, "\n");
   }
   m_L1C->display_state(fout);
   m_L1T->display_state(fout);
@@ -3638,89 +3676,20 @@ void shader_core_ctx::cache_flush() { m_ldst_unit->flush(); }
 void shader_core_ctx::cache_invalidate() { m_ldst_unit->invalidate(); }
 
 // modifiers
-std::list<opndcoll_rfu_t::op_t> opndcoll_rfu_t::arbiter_t::allocate_reads() {
-  std::list<op_t>
-      result;  // a list of registers that (a) are in different register banks,
-               // (b) do not go to the same operand collector
-
-  int input;
-  int output;
-  int _inputs = m_num_banks;
-  int _outputs = m_num_collectors;
-  int _square = (_inputs > _outputs) ? _inputs : _outputs;
-  assert(_square > 0);
-  int _pri = (int)m_last_cu;
-
-  // Clear matching
-  for (int i = 0; i < _inputs; ++i) _inmatch[i] = -1;
-  for (int j = 0; j < _outputs; ++j) _outmatch[j] = -1;
-
-  for (unsigned i = 0; i < m_num_banks; i++) {
-    for (unsigned j = 0; j < m_num_collectors; j++) {
-      assert(i < (unsigned)_inputs);
-      assert(j < (unsigned)_outputs);
-      _request[i][j] = 0;
-    }
-    if (!m_queue[i].empty()) {
-      const op_t &op = m_queue[i].front();
-      int oc_id = op.get_oc_id();
-      assert(i < (unsigned)_inputs);
-      assert(oc_id < _outputs);
-      _request[i][oc_id] = 1;
-    }
-    if (m_allocated_bank[i].is_write()) {
-      assert(i < (unsigned)_inputs);
-      _inmatch[i] = 0;  // write gets priority
-    }
+// Collects the registers that (a) are in different register banks and (b) are
+// not blocked by a bank write. Collector units may read several banks in the
+// same cycle, so the wavefront allocator this replaces granted every bank
+// with a pending request that was not allocated for a write; the grants come
+// out in bank order.
+void opndcoll_rfu_t::arbiter_t::allocate_reads(std::vector<op_t> &result) {
+  result.clear();
+  for (unsigned bank = 0; bank < m_num_banks; bank++) {
+    // write gets priority
+    if (m_queue[bank].empty() || m_allocated_bank[bank].is_write()) continue;
+    assert(m_queue[bank].front().get_oc_id() < m_num_collectors);
+    result.push_back(m_queue[bank].front());
+    m_queue[bank].pop_front();
   }
-
-  ///// wavefront allocator from booksim... --->
-
-  // Loop through diagonals of request matrix
-  // printf("####\n");
-
-  for (int p = 0; p < _square; ++p) {
-    output = (_pri + p) % _outputs;
-
-    // Step through the current diagonal
-    for (input = 0; input < _inputs; ++input) {
-      assert(input < _inputs);
-      assert(output < _outputs);
-      if ((output < _outputs) && (_inmatch[input] == -1) &&
-          //( _outmatch[output] == -1 ) &&   //allow OC to read multiple reg
-          // banks at the same cycle
-          (_request[input][output] /*.label != -1*/)) {
-        // Grant!
-        _inmatch[input] = output;
-        _outmatch[output] = input;
-        // printf("Register File: granting bank %d to OC %d, schedid %d, warpid
-        // %d, Regid %d\n", input, output, (m_queue[input].front()).get_sid(),
-        // (m_queue[input].front()).get_wid(),
-        // (m_queue[input].front()).get_reg());
-      }
-
-      output = (output + 1) % _outputs;
-    }
-  }
-
-  // Round-robin the priority diagonal
-  _pri = (_pri + 1) % _outputs;
-
-  /// <--- end code from booksim
-
-  m_last_cu = _pri;
-  for (unsigned i = 0; i < m_num_banks; i++) {
-    if (_inmatch[i] != -1) {
-      if (!m_allocated_bank[i].is_write()) {
-        unsigned bank = (unsigned)i;
-        op_t &op = m_queue[bank].front();
-        result.push_back(op);
-        m_queue[bank].pop_front();
-      }
-    }
-  }
-
-  return result;
 }
 
 barrier_set_t::barrier_set_t(shader_core_ctx *shader,
@@ -4098,15 +4067,20 @@ void shd_warp_t::print_ibuffer(FILE *fout) const {
 
 void opndcoll_rfu_t::add_cu_set(unsigned set_id, unsigned num_cu,
                                 unsigned num_dispatch) {
-  m_cus[set_id].reserve(num_cu);  // this is necessary to stop pointers in m_cu
-                                  // from being invalid do to a resize;
+  // growing m_cus moves the sets but not their collector units, which
+  // m_cu and the dispatch units point to
+  if (set_id >= m_cus.size()) m_cus.resize(set_id + 1);
+  std::vector<collector_unit_t> &cu_set = m_cus[set_id];
+  assert(cu_set.empty());
+  cu_set.reserve(num_cu);  // this is necessary to stop pointers in m_cu
+                           // from being invalid do to a resize;
   for (unsigned i = 0; i < num_cu; i++) {
-    m_cus[set_id].push_back(collector_unit_t());
-    m_cu.push_back(&m_cus[set_id].back());
+    cu_set.push_back(collector_unit_t());
+    m_cu.push_back(&cu_set.back());
   }
   // for now each collector set gets dedicated dispatch units.
   for (unsigned i = 0; i < num_dispatch; i++) {
-    m_dispatch_units.push_back(dispatch_unit_t(&m_cus[set_id]));
+    m_dispatch_units.push_back(dispatch_unit_t(cu_set.data(), num_cu));
   }
 }
 
@@ -4252,6 +4226,7 @@ void opndcoll_rfu_t::allocate_cu(unsigned port_num) {
     if ((*inp.m_in[i]).has_ready()) {
       // find a free cu
       for (unsigned j = 0; j < inp.m_cu_sets.size(); j++) {
+        assert(inp.m_cu_sets[j] < m_cus.size());
         std::vector<collector_unit_t> &cu_set = m_cus[inp.m_cu_sets[j]];
         bool allocated = false;
         unsigned cuLowerBound = 0;
@@ -4288,22 +4263,20 @@ void opndcoll_rfu_t::allocate_cu(unsigned port_num) {
 
 void opndcoll_rfu_t::allocate_reads() {
   // process read requests that do not have conflicts
-  std::list<op_t> allocated = m_arbiter.allocate_reads();
-  std::map<unsigned, op_t> read_ops;
-  for (std::list<op_t>::iterator r = allocated.begin(); r != allocated.end();
-       r++) {
-    const op_t &rr = *r;
+  // the granted reads are in bank order, one per bank
+  m_arbiter.allocate_reads(m_read_ops);
+  for (unsigned r = 0; r < m_read_ops.size(); r++) {
+    const op_t &rr = m_read_ops[r];
     unsigned reg = rr.get_reg();
     unsigned wid = rr.get_wid();
     unsigned bank =
         register_bank(reg, wid, m_num_banks, m_bank_warp_shift, sub_core_model,
                       m_num_banks_per_sched, rr.get_sid());
+    assert(bank == rr.get_bank());
     m_arbiter.allocate_for_read(bank, rr);
-    read_ops[bank] = rr;
   }
-  std::map<unsigned, op_t>::iterator r;
-  for (r = read_ops.begin(); r != read_ops.end(); ++r) {
-    op_t &op = r->second;
+  for (unsigned r = 0; r < m_read_ops.size(); r++) {
+    op_t &op = m_read_ops[r];
     unsigned cu = op.get_oc_id();
     unsigned operand = op.get_operand();
     m_cu[cu]->collect_operand(operand);
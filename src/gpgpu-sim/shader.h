@@ -815,6 +815,47 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     op_t m_op;
   };
 
+  // FIFO of read requests waiting for one register bank. The ring only
+  // grows (doubling) if a bank ever holds more requests than its initial
+  // depth, so the steady state does not allocate.
+  class op_queue_t {
+   public:
+    op_queue_t() : m_head(0), m_size(0) {}
+    void init(unsigned depth) { m_ops.resize(depth ? depth : 1); }
+
+    bool empty() const { return m_size == 0; }
+    unsigned size() const { return m_size; }
+    const op_t &front() const { return m_ops[m_head]; }
+    const op_t &at(unsigned i) const { return m_ops[index(i)]; }
+
+    void push_back(const op_t &op) {
+      if (m_size == m_ops.size()) grow();
+      m_ops[index(m_size)] = op;
+      m_size++;
+    }
+    void pop_front() {
+      assert(m_size);
+      m_head = index(1);
+      m_size--;
+    }
+
+   private:
+    unsigned index(unsigned i) const {
+      unsigned n = m_head + i;
+      return n < m_ops.size() ? n : n - m_ops.size();
+    }
+    void grow() {
+      std::vector<op_t> ops(2 * m_ops.size());
+      for (unsigned i = 0; i < m_size; i++) ops[i] = at(i);
+      m_ops.swap(ops);
+      m_head = 0;
+    }
+
+    std::vector<op_t> m_ops;
+    unsigned m_head;
+    unsigned m_size;
+  };
+
   class arbiter_t {
    public:
     // constructors
@@ -822,22 +863,14 @@ class opndcoll_rfu_t {  // operand collector based register file unit
       m_queue = NULL;
       m_allocated_bank = NULL;
       m_allocator_rr_head = NULL;
-      _inmatch = NULL;
-      _outmatch = NULL;
-      _request = NULL;
-      m_last_cu = 0;
     }
     void init(unsigned num_cu, unsigned num_banks) {
       assert(num_cu > 0);
       assert(num_banks > 0);
       m_num_collectors = num_cu;
       m_num_banks = num_banks;
-      _inmatch = new int[m_num_banks];
-      _outmatch = new int[m_num_collectors];
-      _request = new int *[m_num_banks];
-      for (unsigned i = 0; i < m_num_banks; i++)
-        _request[i] = new int[m_num_collectors];
-      m_queue = new std::list<op_t>[num_banks];
+      m_queue = new op_queue_t[num_banks];
+      for (unsigned b = 0; b < num_banks; b++) m_queue[b].init(2 * num_cu);
       m_allocated_bank = new allocation_t[num_banks];
       m_allocator_rr_head = new unsigned[num_cu];
       for (unsigned n = 0; n < num_cu; n++)
@@ -852,9 +885,8 @@ class opndcoll_rfu_t {  // operand collector based register file unit
       fprintf(fp, "  requests:\n");
       for (unsigned b = 0; b < m_num_banks; b++) {
         fprintf(fp, "    bank %u : ", b);
-        std::list<op_t>::const_iterator o = m_queue[b].begin();
-        for (; o != m_queue[b].end(); o++) {
-          o->dump(fp);
+        for (unsigned o = 0; o < m_queue[b].size(); o++) {
+          m_queue[b].at(o).dump(fp);
         }
         fprintf(fp, "\n");
       }
@@ -867,8 +899,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     }
 
     // modifiers
-    std::list<op_t> allocate_reads();
-
+    void allocate_reads(std::vector<op_t> &result);
     void add_read_requests(collector_unit_t *cu) {
       const op_t *src = cu->get_operands();
       for (unsigned i = 0; i < MAX_REG_OPERANDS * 2; i++) {
@@ -899,15 +930,10 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     unsigned m_num_collectors;
 
     allocation_t *m_allocated_bank;  // bank # -> register that wins
-    std::list<op_t> *m_queue;
+    op_queue_t *m_queue;
 
     unsigned *
         m_allocator_rr_head;  // cu # -> next bank to check for request (rr-arb)
-    unsigned m_last_cu;       // first cu to check while arb-ing banks (rr)
-
-    int *_inmatch;
-    int *_outmatch;
-    int **_request;
   };
 
   class input_port_t {
@@ -983,10 +1009,10 @@ class opndcoll_rfu_t {  // operand collector based register file unit
 
   class dispatch_unit_t {
    public:
-    dispatch_unit_t(std::vector<collector_unit_t> *cus) {
+    dispatch_unit_t(collector_unit_t *cus, unsigned num_cu) {
       m_last_cu = 0;
       m_collector_units = cus;
-      m_num_collectors = (*cus).size();
+      m_num_collectors = num_cu;
       m_next_cu = 0;
     }
     void init(bool sub_core_model, unsigned num_warp_scheds) {
@@ -1002,9 +1028,9 @@ class opndcoll_rfu_t {  // operand collector based register file unit
                               cusPerSched - (m_last_cu % cusPerSched) : 1;
       for (unsigned n = 0; n < m_num_collectors; n++) {
         unsigned c = (m_last_cu + n + rr_increment) % m_num_collectors;
-        if ((*m_collector_units)[c].ready()) {
+        if (m_collector_units[c].ready()) {
           m_last_cu = c;
-          return &((*m_collector_units)[c]);
+          return &m_collector_units[c];
         }
       }
       return NULL;
@@ -1012,7 +1038,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
 
    private:
     unsigned m_num_collectors;
-    std::vector<collector_unit_t> *m_collector_units;
+    collector_unit_t *m_collector_units;
     unsigned m_last_cu;  // dispatch ready cu's rr
     unsigned m_next_cu;  // for initialization
     bool m_sub_core_model;
@@ -1029,6 +1055,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
   unsigned m_warp_size;
   std::vector<collector_unit_t *> m_cu;
   arbiter_t m_arbiter;
+  std::vector<op_t> m_read_ops;  // reads granted this cycle
 
   unsigned m_num_banks_per_sched;
   unsigned m_num_warp_scheds;
@@ -1041,9 +1068,8 @@ class opndcoll_rfu_t {  // operand collector based register file unit
   // warp_inst_t **m_alu_port;
 
   std::vector<input_port_t> m_in_ports;
-  typedef std::map<unsigned /* collector set */,
-                   std::vector<collector_unit_t> /*collector sets*/>
-      cu_sets_t;
+  // collector set id -> collector units of the set
+  typedef std::vector<std::vector<collector_unit_t> > cu_sets_t;
   cu_sets_t m_cus;
   std::vector<dispatch_unit_t> m_dispatch_units;
 
@@ -1341,6 +1367,33 @@ class shader_memory_interface;
 class shader_core_mem_fetch_allocator;
 class cache_t;
 
+// Counters of outstanding LDGSTS accesses keyed by (warp_id, pc, addr), in an
+// open-addressed hash table with linear probing. Entries are never removed.
+class pending_ldgsts_table {
+ public:
+  pending_ldgsts_table() : m_slots(64), m_used(0) {}
+
+  // the counter for the key, created as 0 if it does not exist
+  unsigned &counter(unsigned warp_id, unsigned pc, unsigned addr);
+  // the value of the counter for the key, 0 if it does not exist
+  unsigned count(unsigned warp_id, unsigned pc, unsigned addr) const;
+
+ private:
+  struct slot_t {
+    slot_t() : used(false), warp_id(0), pc(0), addr(0), count(0) {}
+    bool used;
+    unsigned warp_id;
+    unsigned pc;
+    unsigned addr;
+    unsigned count;
+  };
+  // index of the slot holding the key or of the empty slot it would go to
+  unsigned find(unsigned warp_id, unsigned pc, unsigned addr) const;
+
+  std::vector<slot_t> m_slots;  // power-of-two size, at most half used
+  unsigned m_used;
+};
+
 class ldst_unit : public pipelined_simd_unit {
  public:
   ldst_unit(mem_fetch_interface *icnt,
@@ -1353,12 +1406,9 @@ class ldst_unit : public pipelined_simd_unit {
   // Add a structure to record the LDGSTS instructions,
   // similar to m_pending_writes, but since LDGSTS does not have a output register
   // to write to, so a new structure needs to be added
-  /* A multi-level map: unsigned (warp_id) -> unsigned (pc) -> unsigned (addr) -> unsigned (count)
+  /* (warp_id, pc, addr) -> count
    */
-  std::map<unsigned /*warp_id*/,
-           std::map<unsigned /*pc*/, 
-                  std::map<unsigned /*addr*/, unsigned /*count*/>>>
-      m_pending_ldgsts;
+  pending_ldgsts_table m_pending_ldgsts;
   // modifiers
   virtual void issue(register_set &inst);
   bool is_issue_partitioned() { return false; }
@@ -1448,9 +1498,20 @@ class ldst_unit : public pipelined_simd_unit {
   tex_cache *m_L1T;        // texture cache
   read_only_cache *m_L1C;  // constant cache
   l1_cache *m_L1D;         // data cache
-  std::map<unsigned /*warp_id*/,
-           std::map<unsigned /*regnum*/, unsigned /*count*/>>
-      m_pending_writes;
+  // pending register writes: warp_id -> regnum -> count
+  std::vector<std::vector<unsigned> > m_pending_writes;
+  unsigned &pending_writes(unsigned warp_id, unsigned reg_id) {
+    if (warp_id >= m_pending_writes.size())
+      m_pending_writes.resize(warp_id + 1);
+    std::vector<unsigned> &warp_writes = m_pending_writes[warp_id];
+    if (reg_id >= warp_writes.size()) warp_writes.resize(reg_id + 1, 0);
+    return warp_writes[reg_id];
+  }
+  unsigned pending_writes_count(unsigned warp_id, unsigned reg_id) const {
+    if (warp_id >= m_pending_writes.size()) return 0;
+    const std::vector<unsigned> &warp_writes = m_pending_writes[warp_id];
+    return reg_id < warp_writes.size() ? warp_writes[reg_id] : 0;
+  }
   std::list<mem_fetch *> m_response_fifo;
   opndcoll_rfu_t *m_operand_collector;
   Scoreboard *m_scoreboard;
@@ -2001,7 +2062,7 @@ class shader_core_stats : public shader_core_stats_pod {
   void event_warp_issued(unsigned s_id, unsigned warp_id, unsigned num_issued,
                          unsigned dynamic_warp_id);
 
-  void visualizer_print(gzFile visualizer_file);
+  void visualizer_print(class visualizer_log *log);
 
   void print(FILE *fout) const;
 
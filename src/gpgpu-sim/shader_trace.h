@@ -42,28 +42,44 @@
 
 // Intended to be called from inside components of a shader core.
 // Depends on a get_sid() function
-#define SHADER_DPRINTF(x, ...)                                \
-  do {                                                        \
-    if (SHADER_DTRACE(x)) {                                   \
-      printf(SHADER_PRINT_STR,                                \
-             m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle, \
-             Trace::trace_streams_str[Trace::x], get_sid());  \
-      printf(__VA_ARGS__);                                    \
-    }                                                         \
+#define SHADER_DPRINTF(x, ...)                                    \
+  do {                                                            \
+    if (SHADER_DTRACE(x)) {                                       \
+      if (Trace::binary_enabled) {                                \
+        Trace::record(Trace::x, Trace::TRACE_PREFIX_CORE,         \
+                      get_sid(), -1,                              \
+                      m_gpu->gpu_sim_cycle +                      \
+                          m_gpu->gpu_tot_sim_cycle,               \
+                      __VA_ARGS__);                               \
+      } else {                                                    \
+        printf(SHADER_PRINT_STR,                                  \
+               m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,   \
+               Trace::trace_streams_str[Trace::x], get_sid());    \
+        printf(__VA_ARGS__);                                      \
+      }                                                           \
+    }                                                             \
   } while (0)
 
 // Intended to be called from inside a scheduler_unit.
 // Depends on a m_id member
-#define SCHED_DPRINTF(...)                                               \
-  do {                                                                   \
-    if (SHADER_DTRACE(WARP_SCHEDULER)) {                                 \
-      printf(SCHED_PRINT_STR,                                            \
-             m_shader->get_gpu()->gpu_sim_cycle +                        \
-                 m_shader->get_gpu()->gpu_tot_sim_cycle,                 \
-             Trace::trace_streams_str[Trace::WARP_SCHEDULER], get_sid(), \
-             m_id);                                                      \
-      printf(__VA_ARGS__);                                               \
-    }                                                                    \
+#define SCHED_DPRINTF(...)                                                 \
+  do {                                                                     \
+    if (SHADER_DTRACE(WARP_SCHEDULER)) {                                   \
+      if (Trace::binary_enabled) {                                         \
+        Trace::record(Trace::WARP_SCHEDULER, Trace::TRACE_PREFIX_SCHED,    \
+                      get_sid(), m_id,                                     \
+                      m_shader->get_gpu()->gpu_sim_cycle +                 \
+                          m_shader->get_gpu()->gpu_tot_sim_cycle,          \
+                      __VA_ARGS__);                                        \
+      } else {                                                             \
+        printf(SCHED_PRINT_STR,                                            \
+               m_shader->get_gpu()->gpu_sim_cycle +                        \
+                   m_shader->get_gpu()->gpu_tot_sim_cycle,                 \
+               Trace::trace_streams_str[Trace::WARP_SCHEDULER], get_sid(), \
+               m_id);                                                      \
+        printf(__VA_ARGS__);                                               \
+      }                                                                    \
+    }                                                                      \
   } while (0)
 
 #else
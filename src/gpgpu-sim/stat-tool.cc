@@ -38,6 +38,7 @@
 #include <string>
 #include <vector>
 #include "../../libcuda/gpgpu_context.h"
+#include "visualizer_log.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -175,10 +176,10 @@ void cflog_visualizer_print(FILE *fout) {
   }
 }
 
-void cflog_visualizer_gzprint(gzFile fout) {
+void cflog_visualizer_print(visualizer_log *log) {
   if (thread_CFlogger == NULL) return;  // this means no visualizer output
   for (int i = 0; i < n_thread_CFloggers; i++) {
-    thread_CFlogger[i]->print_visualizer(fout);
+    thread_CFlogger[i]->print_visualizer(log);
   }
 }
 
@@ -462,9 +463,9 @@ void shader_CTA_count_visualizer_print(FILE *fout) {
   s_CTA_count_logger->print_visualizer(fout);
 }
 
-void shader_CTA_count_visualizer_gzprint(gzFile fout) {
+void shader_CTA_count_visualizer_print(visualizer_log *log) {
   if (s_CTA_count_logger == NULL) return;
-  s_CTA_count_logger->print_visualizer(fout);
+  s_CTA_count_logger->print_visualizer(log);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -547,18 +548,19 @@ void thread_insn_span::print_sparse_histo(FILE *fout) const {
   fprintf(fout, "\n");
 }
 
-void thread_insn_span::print_sparse_histo(gzFile fout) const {
+void thread_insn_span::print_sparse_histo(visualizer_log *log) const {
   int n_printed_entries = 0;
   span_count_map::const_iterator i_sc = m_insn_span_count.begin();
   for (; i_sc != m_insn_span_count.end(); ++i_sc) {
     unsigned ptx_lineno = gpgpu_ctx->translate_pc_to_ptxlineno(i_sc->first);
-    gzprintf(fout, "%u %d ", ptx_lineno, i_sc->second);
+    log->add(ptx_lineno);
+    log->add((unsigned)i_sc->second);
     n_printed_entries++;
   }
   if (n_printed_entries == 0) {
-    gzprintf(fout, "0 0 ");
+    log->add(0u);
+    log->add(0u);
   }
-  gzprintf(fout, "\n");
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -622,11 +624,12 @@ void thread_CFlocality::print_visualizer(FILE *fout) {
   }
 }
 
-void thread_CFlocality::print_visualizer(gzFile fout) {
-  gzprintf(fout, "%s: ", m_name.c_str());
+void thread_CFlocality::print_visualizer(visualizer_log *log) {
+  log->begin_row(m_name.c_str());
   if (m_thd_span_archive.empty()) {
     // visualizer do no require snap_shots
-    m_thd_span.print_sparse_histo(fout);
+    m_thd_span.print_sparse_histo(log);
+    log->end_row();
 
     // clean the thread span
     m_thd_span.reset(0);
@@ -743,16 +746,21 @@ void linear_histogram_logger::print_visualizer(FILE *fout) {
   }
 }
 
-void linear_histogram_logger::print_visualizer(gzFile fout) {
+void linear_histogram_snapshot::print_visualizer(visualizer_log *log) const {
+  for (unsigned int i = 0; i < m_linear_histogram.size(); i++) {
+    log->add(m_linear_histogram[i]);
+  }
+}
+
+void linear_histogram_logger::print_visualizer(visualizer_log *log) {
   assert(m_lin_hist_archive.empty());  // don't support snapshot for now
-  gzprintf(fout, "%s", m_name.c_str());
   if (m_id >= 0) {
-    gzprintf(fout, "%02d: ", m_id);
+    log->begin_row(m_name.c_str(), m_id);
   } else {
-    gzprintf(fout, ": ");
+    log->begin_row(m_name.c_str());
   }
-  m_curr_lin_hist.print_visualizer(fout);
-  gzprintf(fout, "\n");
+  m_curr_lin_hist.print_visualizer(log);
+  log->end_row();
   if (m_reset_at_snap_shot) {
     m_curr_lin_hist.reset(0);
   }
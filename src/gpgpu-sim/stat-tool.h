@@ -98,7 +98,7 @@ class thread_insn_span {
   void print_span(FILE *fout) const;
   void print_histo(FILE *fout) const;
   void print_sparse_histo(FILE *fout) const;
-  void print_sparse_histo(gzFile fout) const;
+  void print_sparse_histo(class visualizer_log *log) const;
 
  private:
   gpgpu_context *gpgpu_ctx;
@@ -119,7 +119,7 @@ class thread_CFlocality : public snap_shot_trigger, public spill_log_interface {
   void spill(FILE *fout, bool final);
 
   void print_visualizer(FILE *fout);
-  void print_visualizer(gzFile fout);
+  void print_visualizer(class visualizer_log *log);
   void print_span(FILE *fout) const;
   void print_histo(FILE *fout) const;
 
@@ -226,11 +226,7 @@ class linear_histogram_snapshot {
     }
   }
 
-  void print_visualizer(gzFile fout) const {
-    for (unsigned int i = 0; i < m_linear_histogram.size(); i++) {
-      gzprintf(fout, "%d ", m_linear_histogram[i]);
-    }
-  }
+  void print_visualizer(class visualizer_log *log) const;
 
  private:
   unsigned long long m_cycle;
@@ -255,7 +251,7 @@ class linear_histogram_logger : public snap_shot_trigger,
 
   void print(FILE *fout) const;
   void print_visualizer(FILE *fout);
-  void print_visualizer(gzFile fout);
+  void print_visualizer(class visualizer_log *log);
 
  private:
   int m_n_bins;
@@ -283,7 +279,7 @@ void cflog_snapshot(int logger_id, unsigned long long cycle);
 void cflog_print(FILE *fout);
 void cflog_print_path_expression(FILE *fout);
 void cflog_visualizer_print(FILE *fout);
-void cflog_visualizer_gzprint(gzFile fout);
+void cflog_visualizer_print(class visualizer_log *log);
 
 void insn_warp_occ_create(int n_loggers, int simd_width);
 void insn_warp_occ_log(int logger_id, address_type pc, int warp_occ);
@@ -323,6 +319,6 @@ void shader_CTA_count_unlog(int shader_id, int nCTAdone);
 void shader_CTA_count_resetnow();
 void shader_CTA_count_print(FILE *fout);
 void shader_CTA_count_visualizer_print(FILE *fout);
-void shader_CTA_count_visualizer_gzprint(gzFile fout);
+void shader_CTA_count_visualizer_print(class visualizer_log *log);
 
 #endif /* CFLOGGER_H */
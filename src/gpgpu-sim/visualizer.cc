@@ -37,49 +37,49 @@
 //#include "../../../mcpat/processor.h"
 #include "gpu-cache.h"
 #include "stat-tool.h"
+#include "visualizer_log.h"
 
 #include <string.h>
 #include <time.h>
 #include <zlib.h>
 
-static void time_vector_print_interval2gzfile(gzFile outfile);
+static void time_vector_print_interval(visualizer_log *log);
 
 void gpgpu_sim::visualizer_printstat() {
-  gzFile visualizer_file = NULL;  // gzFile is basically a pointer to a struct,
-                                  // so it is fine to initialize it as NULL
   if (!m_config.g_visualizer_enabled) return;
 
-  // clean the content of the visualizer log if it is the first time, otherwise
-  // attach at the end
-  static bool visualizer_first_printstat = true;
-
-  visualizer_file = gzopen(m_config.g_visualizer_filename,
-                           (visualizer_first_printstat) ? "w" : "a");
-  if (visualizer_file == NULL) {
-    printf("error - could not open visualizer trace file.\n");
-    exit(1);
+  // the log stays open for the whole run; samples are rendered and
+  // compressed by its writer thread
+  if (m_visualizer_log == NULL) {
+    m_visualizer_log = new visualizer_log(m_config.g_visualizer_filename,
+                                          m_config.g_visualizer_zlevel,
+                                          m_config.g_visualizer_binary);
   }
-  gzsetparams(visualizer_file, m_config.g_visualizer_zlevel,
-              Z_DEFAULT_STRATEGY);
-  visualizer_first_printstat = false;
+  visualizer_log *log = m_visualizer_log;
 
-  cflog_visualizer_gzprint(visualizer_file);
-  shader_CTA_count_visualizer_gzprint(visualizer_file);
+  cflog_visualizer_print(log);
+  shader_CTA_count_visualizer_print(log);
 
   for (unsigned i = 0; i < m_memory_config->m_n_mem; i++)
-    m_memory_partition_unit[i]->visualizer_print(visualizer_file);
-  m_shader_stats->visualizer_print(visualizer_file);
-  m_memory_stats->visualizer_print(visualizer_file);
-  m_power_stats->visualizer_print(visualizer_file);
+    m_memory_partition_unit[i]->visualizer_print(log);
+  m_shader_stats->visualizer_print(log);
+  m_memory_stats->visualizer_print(log);
+  m_power_stats->visualizer_print(log);
   // proc->visualizer_print(visualizer_file);
   // other parameters for graphing
-  gzprintf(visualizer_file, "globalcyclecount: %lld\n", gpu_sim_cycle);
-  gzprintf(visualizer_file, "globalinsncount: %lld\n", gpu_sim_insn);
-  gzprintf(visualizer_file, "globaltotinsncount: %lld\n", gpu_tot_sim_insn);
+  log->begin_row("globalcyclecount");
+  log->add(gpu_sim_cycle);
+  log->end_row();
+  log->begin_row("globalinsncount");
+  log->add(gpu_sim_insn);
+  log->end_row();
+  log->begin_row("globaltotinsncount");
+  log->add(gpu_tot_sim_insn);
+  log->end_row();
 
-  time_vector_print_interval2gzfile(visualizer_file);
+  time_vector_print_interval(log);
 
-  gzclose(visualizer_file);
+  log->end_sample();
   /*
      gzprintf(visualizer_file, "CacheMissRate_GlobalLocalL1_All: ");
      for (unsigned i=0;i<m_n_shader;i++)
@@ -338,19 +338,19 @@ class my_time_vector {
     }
     fprintf(outfile, "\n");
   }
-  void print_to_gzfile(gzFile outfile) {
+  void print_to_visualizer(visualizer_log *log) {
     unsigned i;
     calculate_dist();
-    gzprintf(outfile, "LDmemlatdist:");
+    log->begin_row("LDmemlatdist");
     for (i = 0; i < ld_vector_size; i++) {
-      gzprintf(outfile, " %d", (int)ld_time_dist[i]);
+      log->add((int)ld_time_dist[i]);
     }
-    gzprintf(outfile, "\n");
-    gzprintf(outfile, "STmemlatdist:");
+    log->end_row();
+    log->begin_row("STmemlatdist");
     for (i = 0; i < st_vector_size; i++) {
-      gzprintf(outfile, " %d", (int)st_time_dist[i]);
+      log->add((int)st_time_dist[i]);
     }
-    gzprintf(outfile, "\n");
+    log->end_row();
   }
 };
 
@@ -362,8 +362,8 @@ void time_vector_create(int size) {
 
 void time_vector_print(void) { g_my_time_vector->print_dist(); }
 
-void time_vector_print_interval2gzfile(gzFile outfile) {
-  g_my_time_vector->print_to_gzfile(outfile);
+void time_vector_print_interval(visualizer_log *log) {
+  g_my_time_vector->print_to_visualizer(log);
 }
 
 #include "../gpgpu-sim/mem_fetch.h"
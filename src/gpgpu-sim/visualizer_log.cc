@@ -0,0 +1,356 @@
+// Streaming writer for the AerialVision log, see visualizer_log.h.
+//
+// Sample buffers hold a sequence of records, each starting with a u32 kind:
+//   VIS_RECORD_KEY: u32 key id, u32 length, name bytes. Emitted before the
+//     first row that uses the name.
+//   VIS_RECORD_ROW: u32 key id, u32 visualizer_value_type, u32 count, then
+//     count values (4 or 8 bytes each, little endian).
+//
+// A binary log (-visualizer_binary) is "GPGPUVIS", u32 version followed by
+// the samples in columnar form, gzip compressed. The key records are kept and
+// all rows of a sample with the same key and type become one record:
+//   VIS_RECORD_COLUMNS: u32 key id, u32 type, u32 number of rows, u32 values
+//     per row. If every row has that many values, the values follow column
+//     by column (e.g. all partition ids, then all bank ids, then all counts
+//     of the dram access rows). Otherwise the values per row field is
+//     VIS_RAGGED_ROWS and the count of each row is followed by the values
+//     row by row.
+// Rows of different names are independent series for AerialVision, so
+// regrouping them within a sample loses nothing.
+
+#include "visualizer_log.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VIS_FILE_VERSION 1
+#define VIS_RECORD_KEY 1
+#define VIS_RECORD_ROW 2
+#define VIS_RECORD_COLUMNS 3
+#define VIS_RAGGED_ROWS 0xffffffff
+
+// samples the simulation thread may run ahead of the writer
+#define VIS_MAX_QUEUED_SAMPLES 16
+
+static std::vector<visualizer_log *> s_open_logs;
+
+visualizer_log::visualizer_log(const char *filename, int zlevel, bool binary)
+    : m_binary(binary),
+      m_open(true),
+      m_row_start(0),
+      m_row_type(VIS_NO_TYPE),
+      m_row_count(0),
+      m_stop(false) {
+  char mode[8];
+  snprintf(mode, sizeof(mode), "wb%d", zlevel);
+  m_file = gzopen(filename, mode);
+  if (m_file == NULL) {
+    printf("error - could not open visualizer trace file.\n");
+    exit(1);
+  }
+  if (m_binary) {
+    unsigned version = VIS_FILE_VERSION;
+    gzwrite(m_file, "GPGPUVIS", 8);
+    gzwrite(m_file, &version, sizeof(version));
+  }
+  m_sample = new std::vector<unsigned char>();
+
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_cond, NULL);
+  int err = pthread_create(&m_writer, NULL, writer_main, this);
+  assert(err == 0);
+
+  if (s_open_logs.empty()) atexit(close_all);
+  s_open_logs.push_back(this);
+}
+
+visualizer_log::~visualizer_log() {
+  close();
+  delete m_sample;
+}
+
+void visualizer_log::begin_row(const char *name) {
+  std::map<std::string, unsigned>::iterator k = m_key_id.find(name);
+  unsigned id;
+  if (k == m_key_id.end()) {
+    id = m_key_id.size();
+    m_key_id[name] = id;
+    unsigned len = strlen(name);
+    append((unsigned)VIS_RECORD_KEY);
+    append(id);
+    append(len);
+    m_sample->insert(m_sample->end(), name, name + len);
+  } else {
+    id = k->second;
+  }
+  m_row_start = m_sample->size();
+  m_row_type = VIS_NO_TYPE;
+  m_row_count = 0;
+  append((unsigned)VIS_RECORD_ROW);
+  append(id);
+  append(m_row_type);  // type and count are filled in by end_row()
+  append(m_row_count);
+}
+
+void visualizer_log::begin_row(const char *name, int id) {
+  char buf[256];
+  snprintf(buf, sizeof(buf), "%s%02d", name, id);
+  begin_row(buf);
+}
+
+void visualizer_log::put(unsigned type, const void *v, unsigned size) {
+  if (m_row_type == VIS_NO_TYPE) m_row_type = type;
+  assert(m_row_type == type);
+  const unsigned char *p = (const unsigned char *)v;
+  m_sample->insert(m_sample->end(), p, p + size);
+  m_row_count++;
+}
+
+void visualizer_log::add(const unsigned *v, unsigned n) {
+  if (n == 0) return;
+  if (m_row_type == VIS_NO_TYPE) m_row_type = VIS_UINT32;
+  assert(m_row_type == VIS_UINT32);
+  const unsigned char *p = (const unsigned char *)v;
+  m_sample->insert(m_sample->end(), p, p + n * sizeof(unsigned));
+  m_row_count += n;
+}
+
+void visualizer_log::end_row() {
+  if (m_row_type == VIS_NO_TYPE) m_row_type = VIS_INT32;
+  unsigned char *row = &(*m_sample)[m_row_start];
+  memcpy(row + 8, &m_row_type, sizeof(unsigned));
+  memcpy(row + 12, &m_row_count, sizeof(unsigned));
+}
+
+void visualizer_log::end_sample() {
+  if (m_sample->empty()) return;
+  pthread_mutex_lock(&m_lock);
+  while (m_queue.size() >= VIS_MAX_QUEUED_SAMPLES)
+    pthread_cond_wait(&m_cond, &m_lock);
+  m_queue.push_back(m_sample);
+  if (m_free.empty()) {
+    m_sample = new std::vector<unsigned char>();
+  } else {
+    m_sample = m_free.back();
+    m_free.pop_back();
+  }
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+  m_sample->clear();
+}
+
+void visualizer_log::close() {
+  if (!m_open) return;
+  end_sample();
+  pthread_mutex_lock(&m_lock);
+  m_stop = true;
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+  pthread_join(m_writer, NULL);
+  gzclose(m_file);
+  m_open = false;
+
+  for (unsigned i = 0; i < m_free.size(); i++) delete m_free[i];
+  m_free.clear();
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+  for (unsigned i = 0; i < s_open_logs.size(); i++) {
+    if (s_open_logs[i] == this) {
+      s_open_logs.erase(s_open_logs.begin() + i);
+      break;
+    }
+  }
+}
+
+void visualizer_log::close_all() {
+  while (!s_open_logs.empty()) s_open_logs.back()->close();
+}
+
+void *visualizer_log::writer_main(void *arg) {
+  ((visualizer_log *)arg)->writer_loop();
+  return NULL;
+}
+
+void visualizer_log::writer_loop() {
+  pthread_mutex_lock(&m_lock);
+  while (true) {
+    while (m_queue.empty() && !m_stop) pthread_cond_wait(&m_cond, &m_lock);
+    if (m_queue.empty()) break;
+    std::vector<unsigned char> *sample = m_queue.front();
+    m_queue.pop_front();
+    pthread_mutex_unlock(&m_lock);
+
+    write_sample(*sample);
+
+    pthread_mutex_lock(&m_lock);
+    m_free.push_back(sample);
+    pthread_cond_broadcast(&m_cond);
+  }
+  pthread_mutex_unlock(&m_lock);
+}
+
+void visualizer_log::write_sample(const std::vector<unsigned char> &sample) {
+  if (m_binary) {
+    render_columns(sample);
+    if (!m_columns.empty()) gzwrite(m_file, &m_columns[0], m_columns.size());
+  } else {
+    render_text(sample);
+    if (!m_text.empty()) gzwrite(m_file, &m_text[0], m_text.size());
+  }
+  // complete the sample in the file, so a failed assert or a crash, which
+  // skip the atexit handler, lose at most the samples still queued
+  gzflush(m_file, Z_SYNC_FLUSH);
+}
+
+static unsigned read_u32(const unsigned char *p) {
+  unsigned v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static unsigned value_size(unsigned type) {
+  return (type == VIS_INT32 || type == VIS_UINT32) ? 4 : 8;
+}
+
+void visualizer_log::put_column_u32(unsigned v) {
+  const unsigned char *p = (const unsigned char *)&v;
+  m_columns.insert(m_columns.end(), p, p + sizeof(v));
+}
+
+// Regroup the rows of the sample by key and type, see VIS_RECORD_COLUMNS.
+void visualizer_log::render_columns(const std::vector<unsigned char> &sample) {
+  m_columns.clear();
+  const unsigned char *p = &sample[0];
+  const unsigned char *end = p + sample.size();
+  while (p < end) {
+    unsigned kind = read_u32(p);
+    if (kind == VIS_RECORD_KEY) {
+      unsigned len = read_u32(p + 8);
+      m_columns.insert(m_columns.end(), p, p + 12 + len);
+      p += 12 + len;
+      continue;
+    }
+    assert(kind == VIS_RECORD_ROW);
+    unsigned group = read_u32(p + 4) * VIS_NO_TYPE + read_u32(p + 8);
+    if (group >= m_groups.size()) m_groups.resize(group + 1);
+    if (m_groups[group].empty()) m_group_order.push_back(group);
+    m_groups[group].push_back(p);
+    p += 16 + read_u32(p + 12) * value_size(read_u32(p + 8));
+  }
+
+  for (unsigned g = 0; g < m_group_order.size(); g++) {
+    std::vector<const unsigned char *> &rows = m_groups[m_group_order[g]];
+    unsigned type = read_u32(rows[0] + 8);
+    unsigned size = value_size(type);
+    unsigned count = read_u32(rows[0] + 12);
+    for (unsigned r = 1; r < rows.size(); r++) {
+      if (read_u32(rows[r] + 12) != count) count = VIS_RAGGED_ROWS;
+    }
+    put_column_u32(VIS_RECORD_COLUMNS);
+    put_column_u32(read_u32(rows[0] + 4));
+    put_column_u32(type);
+    put_column_u32(rows.size());
+    put_column_u32(count);
+    if (count == VIS_RAGGED_ROWS) {
+      for (unsigned r = 0; r < rows.size(); r++)
+        put_column_u32(read_u32(rows[r] + 12));
+      for (unsigned r = 0; r < rows.size(); r++) {
+        const unsigned char *v = rows[r] + 16;
+        m_columns.insert(m_columns.end(), v, v + read_u32(rows[r] + 12) * size);
+      }
+    } else {
+      for (unsigned c = 0; c < count; c++) {
+        for (unsigned r = 0; r < rows.size(); r++) {
+          const unsigned char *v = rows[r] + 16 + c * size;
+          m_columns.insert(m_columns.end(), v, v + size);
+        }
+      }
+    }
+    rows.clear();
+  }
+  m_group_order.clear();
+}
+
+// " <v>" in decimal, without going through printf
+static unsigned format_integer(char *buf, unsigned long long v, bool negative) {
+  char digits[24];
+  unsigned n = 0;
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  unsigned len = 0;
+  buf[len++] = ' ';
+  if (negative) buf[len++] = '-';
+  while (n) buf[len++] = digits[--n];
+  return len;
+}
+
+static unsigned format_signed(char *buf, long long v) {
+  return v < 0 ? format_integer(buf, -(unsigned long long)v, true)
+               : format_integer(buf, v, false);
+}
+
+// Print the sample as "name: v v v" lines, the format of the text log.
+void visualizer_log::render_text(const std::vector<unsigned char> &sample) {
+  m_text.clear();
+  const unsigned char *p = &sample[0];
+  const unsigned char *end = p + sample.size();
+  char buf[64];
+  while (p < end) {
+    unsigned kind = read_u32(p);
+    unsigned id = read_u32(p + 4);
+    if (kind == VIS_RECORD_KEY) {
+      unsigned len = read_u32(p + 8);
+      if (id >= m_key_name.size()) m_key_name.resize(id + 1);
+      m_key_name[id].assign((const char *)p + 12, len);
+      p += 12 + len;
+      continue;
+    }
+    assert(kind == VIS_RECORD_ROW);
+    unsigned type = read_u32(p + 8);
+    unsigned count = read_u32(p + 12);
+    p += 16;
+    const std::string &name = m_key_name[id];
+    m_text.insert(m_text.end(), name.begin(), name.end());
+    m_text.push_back(':');
+    for (unsigned i = 0; i < count; i++) {
+      unsigned n = 0;
+      switch (type) {
+        case VIS_INT32: {
+          int v;
+          memcpy(&v, p, sizeof(v));
+          n = format_signed(buf, v);
+          p += sizeof(v);
+        } break;
+        case VIS_UINT32:
+          n = format_integer(buf, read_u32(p), false);
+          p += sizeof(unsigned);
+          break;
+        case VIS_INT64: {
+          long long v;
+          memcpy(&v, p, sizeof(v));
+          n = format_signed(buf, v);
+          p += sizeof(v);
+        } break;
+        case VIS_UINT64: {
+          unsigned long long v;
+          memcpy(&v, p, sizeof(v));
+          n = format_integer(buf, v, false);
+          p += sizeof(v);
+        } break;
+        case VIS_DOUBLE: {
+          double v;
+          memcpy(&v, p, sizeof(v));
+          n = snprintf(buf, sizeof(buf), " %f", v);
+          p += sizeof(v);
+        } break;
+        default:
+          assert(0);
+      }
+      m_text.insert(m_text.end(), buf, buf + n);
+    }
+    m_text.push_back('\n');
+  }
+}
@@ -0,0 +1,102 @@
+// Streaming writer for the AerialVision log (-visualizer_outputfile).
+//
+// Statistics are recorded as rows: a name followed by an array of values of
+// a single type (e.g. "dramncmd: <partition> <count>" or one value per
+// shader core). Rows are appended in a compact binary encoding to an
+// in-memory sample buffer on the simulation thread; end_sample() hands the
+// buffer to a background thread, which renders it (either as the traditional
+// "name: v v v" text or, with -visualizer_binary, in a columnar binary form)
+// and compresses it into the log file. AerialVision reads both formats.
+
+#ifndef VISUALIZER_LOG_H
+#define VISUALIZER_LOG_H
+
+#include <pthread.h>
+#include <zlib.h>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+enum visualizer_value_type {
+  VIS_INT32 = 0,
+  VIS_UINT32,
+  VIS_INT64,
+  VIS_UINT64,
+  VIS_DOUBLE,
+  VIS_NO_TYPE  // row without values so far
+};
+
+class visualizer_log {
+ public:
+  // zlevel is the gzip compression level (0-9)
+  visualizer_log(const char *filename, int zlevel, bool binary);
+  ~visualizer_log();
+
+  // Start a row named name, or name followed by a two-digit id (the naming
+  // used for per-core histograms, e.g. "shdrctacount03").
+  void begin_row(const char *name);
+  void begin_row(const char *name, int id);
+
+  // Append values to the current row; all values of a row have one type.
+  void add(int v) { put(VIS_INT32, &v, sizeof(v)); }
+  void add(unsigned v) { put(VIS_UINT32, &v, sizeof(v)); }
+  void add(long long v) { put(VIS_INT64, &v, sizeof(v)); }
+  void add(unsigned long long v) { put(VIS_UINT64, &v, sizeof(v)); }
+  void add(double v) { put(VIS_DOUBLE, &v, sizeof(v)); }
+  void add(const unsigned *v, unsigned n);
+
+  void end_row();
+
+  // Queue the rows recorded since the last call for writing.
+  void end_sample();
+
+  // Write all queued samples and close the file. Called at exit for logs that
+  // are still open.
+  void close();
+
+ private:
+  static void *writer_main(void *arg);
+  static void close_all();
+  void writer_loop();
+  void write_sample(const std::vector<unsigned char> &sample);
+  void render_text(const std::vector<unsigned char> &sample);
+  void render_columns(const std::vector<unsigned char> &sample);
+  void put_column_u32(unsigned v);
+
+  void put(unsigned type, const void *v, unsigned size);
+  template <class T>
+  void append(const T &v) {
+    const unsigned char *p = (const unsigned char *)&v;
+    m_sample->insert(m_sample->end(), p, p + sizeof(T));
+  }
+
+  bool m_binary;
+  gzFile m_file;
+  bool m_open;
+
+  // simulation thread: row names seen so far and the row being built
+  std::map<std::string, unsigned> m_key_id;
+  std::vector<unsigned char> *m_sample;
+  size_t m_row_start;  // offset of the current row record in m_sample
+  unsigned m_row_type;
+  unsigned m_row_count;
+
+  // samples waiting for the writer and buffers it has released
+  pthread_t m_writer;
+  pthread_mutex_t m_lock;
+  pthread_cond_t m_cond;
+  std::deque<std::vector<unsigned char> *> m_queue;
+  std::vector<std::vector<unsigned char> *> m_free;
+  bool m_stop;
+
+  // writer thread: row names by id and the text rendering buffer
+  std::vector<std::string> m_key_name;
+  std::vector<char> m_text;
+  // writer thread: rows of a sample grouped by key and type, binary output
+  std::vector<std::vector<const unsigned char *> > m_groups;
+  std::vector<unsigned> m_group_order;
+  std::vector<unsigned char> m_columns;
+};
+
+#endif
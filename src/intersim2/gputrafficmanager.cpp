@@ -28,6 +28,7 @@
 #include <sstream>
 #include <fstream>
 #include <limits> 
+#include <cmath>
 
 #include "gputrafficmanager.hpp"
 #include "interconnect_interface.hpp"
@@ -47,12 +48,50 @@ GPUTrafficManager::GPUTrafficManager( const Configuration &config, const vector<
       _input_queue[subnet][node].resize(_classes);
     }
   }
+  _queued_nodes.resize(_subnets,
+                       vector<unsigned long long>((_nodes + 63) / 64));
+  _cycle_ejected_flits.resize(_subnets);
+  for ( int subnet = 0; subnet < _subnets; ++subnet) {
+    _cycle_ejected_flits[subnet].reserve(_nodes);
+  }
+  
+  double const speedup = config.GetFloat("internal_speedup");
+  _skip_idle_cycles = (config.GetStr("router") == "iq") &&
+                      (speedup == floor(speedup));
+  _network_idle = false;
 }
 
 GPUTrafficManager::~GPUTrafficManager()
 {
 }
 
+void GPUTrafficManager::_SetQueued(int subnet, int node, bool queued)
+{
+  unsigned long long const bit = 1ULL << (node % 64);
+  if(queued) {
+    _queued_nodes[subnet][node / 64] |= bit;
+  } else {
+    _queued_nodes[subnet][node / 64] &= ~bit;
+  }
+}
+
+int GPUTrafficManager::_NextQueuedNode(int subnet, int node) const
+{
+  vector<unsigned long long> const & queued = _queued_nodes[subnet];
+  size_t w = node / 64;
+  if(w >= queued.size()) {
+    return _nodes;
+  }
+  unsigned long long bits = queued[w] & (~0ULL << (node % 64));
+  while(!bits) {
+    if(++w == queued.size()) {
+      return _nodes;
+    }
+    bits = queued[w];
+  }
+  return w * 64 + __builtin_ctzll(bits);
+}
+
 void GPUTrafficManager::Init()
 {
   _time = 0;
@@ -329,6 +368,7 @@ void GPUTrafficManager::_GeneratePacket(int source, int stype, int cl, int time,
     }
     
     _input_queue[subnet][source][cl].push_back( f );
+    _SetQueued(subnet, source, true);
   }
 }
 
@@ -343,7 +383,18 @@ void GPUTrafficManager::_Step()
     cout << "WARNING: Possible network deadlock.\n";
   }
   
-  vector<map<int, Flit *> > flits(_subnets);
+  // After one idle cycle all channels are drained and all routers are
+  // inactive, so the following idle cycles only advance time.
+  bool const idle = !flits_in_flight && (Credit::OutStanding() == 0);
+  if(idle && _network_idle) {
+    ++_time;
+    assert(_time);
+    if(gTrace){
+      cout<<"TIME "<<_time<<endl;
+    }
+    return;
+  }
+  _network_idle = idle && _skip_idle_cycles;
   
   for ( int subnet = 0; subnet < _subnets; ++subnet ) {
     for ( int n = 0; n < _nodes; ++n ) {
@@ -360,8 +411,11 @@ void GPUTrafficManager::_Step()
         g_icnt_interface->WriteOutBuffer(subnet, n, f);
       }
       
-      g_icnt_interface->Transfer2BoundaryBuffer(subnet, n);
-      Flit* const ejected_flit = g_icnt_interface->GetEjectedFlit(subnet, n);
+      Flit* ejected_flit = NULL;
+      if (g_icnt_interface->HasEjectingFlits(subnet, n)) {
+        g_icnt_interface->Transfer2BoundaryBuffer(subnet, n);
+        ejected_flit = g_icnt_interface->GetEjectedFlit(subnet, n);
+      }
       if (ejected_flit) {
         if(ejected_flit->head)
           assert(ejected_flit->dest == n);
@@ -373,7 +427,7 @@ void GPUTrafficManager::_Step()
           << " VC " << ejected_flit->vc << ")"
           << "from ejection buffer." << endl;
         }
-        flits[subnet].insert(make_pair(n, ejected_flit));
+        _cycle_ejected_flits[subnet].push_back(make_pair(n, ejected_flit));
         if((_sim_state == warming_up) || (_sim_state == running)) {
           ++_accepted_flits[ejected_flit->cl][n];
           if(ejected_flit->tail) {
@@ -411,7 +465,8 @@ void GPUTrafficManager::_Step()
   
   for(int subnet = 0; subnet < _subnets; ++subnet) {
     
-    for(int n = 0; n < _nodes; ++n) {
+    for(int n = _NextQueuedNode(subnet, 0); n < _nodes;
+        n = _NextQueuedNode(subnet, n + 1)) {
       
       Flit * f = NULL;
       
@@ -588,6 +643,11 @@ void GPUTrafficManager::_Step()
         _last_class[n][subnet] = c;
         
         _input_queue[subnet][n][c].pop_front();
+        bool queued = false;
+        for(int qc = 0; qc < _classes; ++qc) {
+          queued |= !_input_queue[subnet][n][qc].empty();
+        }
+        _SetQueued(subnet, n, queued);
         
 #ifdef TRACK_FLOWS
         ++_outstanding_credits[c][subnet][n];
@@ -636,31 +696,30 @@ void GPUTrafficManager::_Step()
   }
   //Send the credit To the network
   for(int subnet = 0; subnet < _subnets; ++subnet) {
-    for(int n = 0; n < _nodes; ++n) {
-      map<int, Flit *>::const_iterator iter = flits[subnet].find(n);
-      if(iter != flits[subnet].end()) {
-        Flit * const f = iter->second;
+    vector<pair<int, Flit *> > const & flits = _cycle_ejected_flits[subnet];
+    for(size_t i = 0; i < flits.size(); ++i) {
+      int const n = flits[i].first;
+      Flit * const f = flits[i].second;
 
-        f->atime = _time;
-        if(f->watch) {
-          *gWatchOut << GetSimTime() << " | "
-          << "node" << n << " | "
-          << "Injecting credit for VC " << f->vc
-          << " into subnet " << subnet
-          << "." << endl;
-        }
-        Credit * const c = Credit::New();
-        c->vc.insert(f->vc);
-        _net[subnet]->WriteCredit(c, n);
-        
+      f->atime = _time;
+      if(f->watch) {
+        *gWatchOut << GetSimTime() << " | "
+        << "node" << n << " | "
+        << "Injecting credit for VC " << f->vc
+        << " into subnet " << subnet
+        << "." << endl;
+      }
+      Credit * const c = Credit::New();
+      c->vc.insert(f->vc);
+      _net[subnet]->WriteCredit(c, n);
+      
 #ifdef TRACK_FLOWS
-        ++_ejected_flits[f->cl][n];
+      ++_ejected_flits[f->cl][n];
 #endif
-        
-        _RetireFlit(f, n);
-      }
+      
+      _RetireFlit(f, n);
     }
-    flits[subnet].clear();
+    _cycle_ejected_flits[subnet].clear();
     // _InteralStep here
     _net[subnet]->Evaluate( );
     _net[subnet]->WriteOutputs( );
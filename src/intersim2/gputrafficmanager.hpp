@@ -49,6 +49,20 @@ protected:
   
   // record size of _partial_packets for each subnet
   vector<vector<vector<list<Flit *> > > > _input_queue;
+  // bitset per subnet of the nodes with flits in _input_queue
+  vector<vector<unsigned long long> > _queued_nodes;
+  void _SetQueued(int subnet, int node, bool queued);
+  // first node >= node with queued flits, _nodes if there is none
+  int _NextQueuedNode(int subnet, int node) const;
+  
+  // (node, flit) pairs ejected by each subnet in the current cycle
+  vector<vector<pair<int, Flit *> > > _cycle_ejected_flits;
+  
+  // idle cycles are skipped once a whole cycle ran without any flit or
+  // credit in the network (only with iq routers and an integral internal
+  // speedup, whose idle cycles change no state)
+  bool _skip_idle_cycles;
+  bool _network_idle;
   
 public:
   
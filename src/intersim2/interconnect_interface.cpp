@@ -347,6 +347,7 @@ void InterconnectInterface::WriteOutBuffer(int subnet, int output_icntID, Flit*
   int vc = flit->vc;
   assert (_ejection_buffer[subnet][output_icntID][vc].size() < _ejection_buffer_capacity);
   _ejection_buffer[subnet][output_icntID][vc].push(flit);
+  ++_ejecting_flits[subnet][output_icntID];
 }
 
 int InterconnectInterface::GetIcntTime() const
@@ -365,6 +366,7 @@ Flit* InterconnectInterface::GetEjectedFlit(int subnet, int node)
   if (!_ejected_flit_queue[subnet][node].empty()) {
     flit = _ejected_flit_queue[subnet][node].front();
     _ejected_flit_queue[subnet][node].pop();
+    --_ejecting_flits[subnet][node];
   }
   return flit;
 }
@@ -377,6 +379,7 @@ void InterconnectInterface::_CreateBuffer()
   _ejection_buffer.resize(_subnets);
   _round_robin_turn.resize(_subnets);
   _ejected_flit_queue.resize(_subnets);
+  _ejecting_flits.resize(_subnets, vector<int>(nodes, 0));
 
   for (int subnet = 0; subnet < _subnets; ++subnet) {
     _ejection_buffer[subnet].resize(nodes);
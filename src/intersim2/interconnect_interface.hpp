@@ -73,6 +73,11 @@ public:
   Stats* GetIcntStats(const string & name) const;
   
   Flit* GetEjectedFlit(int subnet, int node);
+  // node has flits in its ejection buffers that GetEjectedFlit has not
+  // returned yet
+  bool HasEjectingFlits(int subnet, int node) const {
+    return _ejecting_flits[subnet][node] > 0;
+  }
   
 protected:
   
@@ -103,6 +108,8 @@ protected:
   vector<vector<vector<_EjectionBufferItem> > > _ejection_buffer;
   // size:[subnets][nodes]
   vector<vector<queue<Flit* > > > _ejected_flit_queue;
+  // size:[subnets][nodes], flits in _ejection_buffer and _ejected_flit_queue
+  vector<vector<int> > _ejecting_flits;
   
   unsigned int _ejection_buffer_capacity;
   unsigned int _input_buffer_capacity;
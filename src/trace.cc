@@ -53,5 +53,10 @@ void init() {
       trace_streams_enabled[i] = true;
     }
   }
+#if TRACING_ON
+  if (enabled && !binary_enabled && binary_file &&
+      strcmp(binary_file, "none") != 0)
+    binary_open(binary_file);
+#endif
 }
 }  // namespace Trace
@@ -57,24 +57,37 @@ void init();
 
 #if TRACING_ON
 
+#include "trace_binary.h"
+
 #define SIM_PRINT_STR "GPGPU-Sim Cycle %llu: %s - "
 #define DTRACE(x) ((Trace::trace_streams_enabled[Trace::x]) && Trace::enabled)
-#define DPRINTF(x, ...)                                                      \
-  do {                                                                       \
-    if (DTRACE(x)) {                                                         \
-      printf(SIM_PRINT_STR, m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle, \
-             Trace::trace_streams_str[Trace::x]);                            \
-      printf(__VA_ARGS__);                                                   \
-    }                                                                        \
+#define DPRINTF(x, ...)                                                        \
+  do {                                                                         \
+    if (DTRACE(x)) {                                                           \
+      if (Trace::binary_enabled) {                                             \
+        Trace::record(Trace::x, Trace::TRACE_PREFIX_SIM, -1, -1,               \
+                      m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle,         \
+                      __VA_ARGS__);                                            \
+      } else {                                                                 \
+        printf(SIM_PRINT_STR, m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle, \
+               Trace::trace_streams_str[Trace::x]);                            \
+        printf(__VA_ARGS__);                                                   \
+      }                                                                        \
+    }                                                                          \
   } while (0)
 
-#define DPRINTFG(x, ...)                                       \
-  do {                                                         \
-    if (DTRACE(x)) {                                           \
-      printf(SIM_PRINT_STR, gpu_sim_cycle + gpu_tot_sim_cycle, \
-             Trace::trace_streams_str[Trace::x]);              \
-      printf(__VA_ARGS__);                                     \
-    }                                                          \
+#define DPRINTFG(x, ...)                                                 \
+  do {                                                                   \
+    if (DTRACE(x)) {                                                     \
+      if (Trace::binary_enabled) {                                       \
+        Trace::record(Trace::x, Trace::TRACE_PREFIX_SIM, -1, -1,         \
+                      gpu_sim_cycle + gpu_tot_sim_cycle, __VA_ARGS__);   \
+      } else {                                                           \
+        printf(SIM_PRINT_STR, gpu_sim_cycle + gpu_tot_sim_cycle,         \
+               Trace::trace_streams_str[Trace::x]);                      \
+        printf(__VA_ARGS__);                                             \
+      }                                                                  \
+    }                                                                    \
   } while (0)
 
 #else
@@ -0,0 +1,245 @@
+// Binary trace output, see trace_binary.h.
+//
+// File layout (gzip compressed):
+//   "GPGPUTRC", u32 version, u32 number of streams, then per stream a u32
+//   length and the stream name.
+//   A sequence of entries, each starting with a u32 kind:
+//     TRACE_FILE_FORMAT: u32 format id, u32 length, format string bytes.
+//       Written before the first event that uses the format.
+//     TRACE_FILE_EVENT: one event (trace_event_header.size bytes) with its
+//       fmt field replaced by the format id.
+// Events of different threads are interleaved; trace2text sorts them by seq.
+
+#include "trace_binary.h"
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <atomic>
+#include <map>
+#include <vector>
+#include "trace.h"
+
+#define TRACE_FILE_VERSION 1
+#define TRACE_FILE_FORMAT 1
+#define TRACE_FILE_EVENT 2
+
+// slots per producer ring (4 MB)
+#define TRACE_RING_SLOTS (1 << 16)
+
+namespace Trace {
+
+bool binary_enabled = false;
+const char* binary_file;
+
+namespace {
+
+// Single-producer single-consumer ring of event slots. The producing thread
+// owns m_head and the writer thread owns m_tail; an event is published by
+// advancing m_head past all of its slots.
+class trace_ring {
+ public:
+  trace_ring() : m_head(0), m_tail(0) {
+    m_slots = new unsigned char[TRACE_RING_SLOTS * TRACE_SLOT_SIZE];
+  }
+  ~trace_ring() { delete[] m_slots; }
+
+  void push(const unsigned char* event, unsigned size) {
+    unsigned n_slots = (size + TRACE_SLOT_SIZE - 1) / TRACE_SLOT_SIZE;
+    unsigned long long head = m_head.load(std::memory_order_relaxed);
+    // the writer drains continuously; wait for room rather than drop events
+    while (head + n_slots - m_tail.load(std::memory_order_acquire) >
+           TRACE_RING_SLOTS)
+      sched_yield();
+    copy_in(head, event, size);
+    m_head.store(head + n_slots, std::memory_order_release);
+  }
+
+  // Copy the oldest event into buf and release its slots. Returns false if
+  // the ring is empty.
+  bool pop(unsigned char* buf) {
+    unsigned long long tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+    copy_out(tail, buf, sizeof(trace_event_header));
+    unsigned size = ((trace_event_header*)buf)->size;
+    copy_out(tail, buf, size);
+    unsigned n_slots = (size + TRACE_SLOT_SIZE - 1) / TRACE_SLOT_SIZE;
+    m_tail.store(tail + n_slots, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  unsigned offset(unsigned long long slot) const {
+    return (slot % TRACE_RING_SLOTS) * TRACE_SLOT_SIZE;
+  }
+  // events may wrap around the end of the ring
+  void copy_in(unsigned long long slot, const unsigned char* src,
+               unsigned size) {
+    unsigned off = offset(slot);
+    unsigned first = TRACE_RING_SLOTS * TRACE_SLOT_SIZE - off;
+    if (first > size) first = size;
+    memcpy(m_slots + off, src, first);
+    memcpy(m_slots, src + first, size - first);
+  }
+  void copy_out(unsigned long long slot, unsigned char* dst, unsigned size) {
+    unsigned off = offset(slot);
+    unsigned first = TRACE_RING_SLOTS * TRACE_SLOT_SIZE - off;
+    if (first > size) first = size;
+    memcpy(dst, m_slots + off, first);
+    memcpy(dst + first, m_slots, size - first);
+  }
+
+  unsigned char* m_slots;
+  std::atomic<unsigned long long> m_head;
+  std::atomic<unsigned long long> m_tail;
+};
+
+gzFile g_file;
+std::atomic<unsigned long long> g_seq(0);
+pthread_mutex_t g_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+std::vector<trace_ring*> g_rings;
+pthread_t g_writer;
+std::atomic<bool> g_stop(false);
+__thread trace_ring* t_ring = NULL;
+
+// writer thread state; output is batched to keep gzwrite calls large
+std::map<unsigned long long, unsigned> g_format_id;
+std::vector<unsigned char> g_out;
+
+void write_bytes(const void* p, unsigned n) {
+  g_out.insert(g_out.end(), (const unsigned char*)p,
+               (const unsigned char*)p + n);
+}
+void write_u32(unsigned v) { write_bytes(&v, sizeof(v)); }
+void flush_out() {
+  if (!g_out.empty()) gzwrite(g_file, &g_out[0], g_out.size());
+  g_out.clear();
+}
+
+void write_event(unsigned char* event) {
+  trace_event_header& h = *(trace_event_header*)event;
+  std::map<unsigned long long, unsigned>::iterator f =
+      g_format_id.find(h.fmt);
+  unsigned id;
+  if (f == g_format_id.end()) {
+    id = g_format_id.size();
+    g_format_id[h.fmt] = id;
+    const char* fmt = (const char*)h.fmt;
+    unsigned len = strlen(fmt);
+    write_u32(TRACE_FILE_FORMAT);
+    write_u32(id);
+    write_u32(len);
+    write_bytes(fmt, len);
+  } else {
+    id = f->second;
+  }
+  h.fmt = id;
+  write_u32(TRACE_FILE_EVENT);
+  write_bytes(event, h.size);
+  if (g_out.size() >= (1 << 20)) flush_out();
+}
+
+// Drain every ring once; returns the number of events written.
+unsigned drain() {
+  static unsigned long long buf[sizeof(trace_event_header) / 8 +
+                                TRACE_MAX_ARGS + TRACE_MAX_STR_SIZE / 8];
+  unsigned char* event = (unsigned char*)buf;
+  pthread_mutex_lock(&g_rings_lock);
+  std::vector<trace_ring*> rings = g_rings;
+  pthread_mutex_unlock(&g_rings_lock);
+  unsigned n = 0;
+  for (unsigned r = 0; r < rings.size(); r++) {
+    // bound the batch so one busy ring cannot starve the others
+    for (unsigned i = 0; i < TRACE_RING_SLOTS / 4 && rings[r]->pop(event);
+         i++) {
+      write_event(event);
+      n++;
+    }
+  }
+  return n;
+}
+
+void* writer_main(void*) {
+  while (!g_stop.load(std::memory_order_acquire)) {
+    if (!drain()) {
+      flush_out();
+      usleep(100);
+    }
+  }
+  return NULL;
+}
+
+}  // namespace
+
+void event_builder::add(const char* s) {
+  unsigned len = s ? strlen(s) : 0;
+  if (len > TRACE_MAX_STR_SIZE - m_str_len) {
+    len = TRACE_MAX_STR_SIZE - m_str_len;  // truncate very long strings
+  }
+  // a NULL string is recorded as an empty one
+  if (len > 0) memcpy(m_str + m_str_len, s, len);
+  m_str_len += len;
+  put(TRACE_ARG_STR, len);
+}
+
+void event_builder::commit() {
+  if (!t_ring) {
+    t_ring = new trace_ring();
+    pthread_mutex_lock(&g_rings_lock);
+    g_rings.push_back(t_ring);
+    pthread_mutex_unlock(&g_rings_lock);
+  }
+  trace_event_header& h = header();
+  unsigned args_size = sizeof(trace_event_header) + 8 * h.n_args;
+  unsigned size = args_size + m_str_len;
+  h.size = size;
+  h.seq = g_seq.fetch_add(1, std::memory_order_relaxed);
+  if (m_str_len) {
+    // strings directly follow the used arguments
+    unsigned char event[sizeof(m_event) + sizeof(m_str)];
+    memcpy(event, m_event, args_size);
+    memcpy(event + args_size, m_str, m_str_len);
+    t_ring->push(event, size);
+  } else {
+    t_ring->push((const unsigned char*)m_event, size);
+  }
+}
+
+void binary_open(const char* fname) {
+  assert(!binary_enabled);
+  g_file = gzopen(fname, "wb1");
+  if (!g_file) {
+    fprintf(stderr, "GPGPU-Sim: cannot open binary trace file %s\n", fname);
+    exit(1);
+  }
+  write_bytes("GPGPUTRC", 8);
+  write_u32(TRACE_FILE_VERSION);
+  write_u32(NUM_TRACE_STREAMS);
+  for (unsigned i = 0; i < NUM_TRACE_STREAMS; i++) {
+    unsigned len = strlen(trace_streams_str[i]);
+    write_u32(len);
+    write_bytes(trace_streams_str[i], len);
+  }
+  flush_out();
+  int err = pthread_create(&g_writer, NULL, writer_main, NULL);
+  assert(err == 0);
+  binary_enabled = true;
+  atexit(binary_close);
+  printf("GPGPU-Sim: writing binary trace to %s\n", fname);
+}
+
+void binary_close() {
+  if (!binary_enabled) return;
+  binary_enabled = false;
+  g_stop.store(true, std::memory_order_release);
+  pthread_join(g_writer, NULL);
+  while (drain())
+    ;
+  flush_out();
+  gzclose(g_file);
+}
+
+}  // namespace Trace
@@ -0,0 +1,130 @@
+// Binary trace output (-trace_binary_file). Instead of formatting text with
+// printf on the simulation thread, trace macros copy their format string
+// address and raw arguments into a fixed-size event record. Records go to a
+// lock-free ring owned by the producing thread and a background writer thread
+// drains all rings into a gzip-compressed file. scripts/trace2text turns the
+// file back into the text the macros print.
+
+#ifndef __TRACE_BINARY_H__
+#define __TRACE_BINARY_H__
+
+#include <string.h>
+
+namespace Trace {
+
+extern bool binary_enabled;
+extern const char* binary_file;
+
+// Open the trace file and start the writer thread. The trace is flushed and
+// closed at exit.
+void binary_open(const char* fname);
+void binary_close();
+
+// Events are stored in slots of TRACE_SLOT_SIZE bytes; an event occupies as
+// many consecutive slots as its header, arguments and copied strings need.
+#define TRACE_SLOT_SIZE 64
+#define TRACE_MAX_ARGS 16
+#define TRACE_MAX_STR_SIZE 1024  // string argument bytes per event
+
+// text printed before the message, see SIM_PRINT_STR and friends
+enum trace_prefix {
+  TRACE_PREFIX_SIM = 0,  // "GPGPU-Sim Cycle %llu: %s - "
+  TRACE_PREFIX_CORE,     // ... "Core %d - "
+  TRACE_PREFIX_SCHED,    // ... "Core %d - Scheduler %d - "
+  TRACE_PREFIX_MEMPART   // ... " %d - "
+};
+
+enum trace_arg_type {
+  TRACE_ARG_INT = 0,
+  TRACE_ARG_UINT,
+  TRACE_ARG_DOUBLE,
+  TRACE_ARG_PTR,
+  TRACE_ARG_STR  // value is the string length, bytes follow the arguments
+};
+
+struct trace_event_header {
+  unsigned long long seq;    // global order in which events were recorded
+  unsigned long long cycle;  // gpu_sim_cycle + gpu_tot_sim_cycle
+  unsigned long long fmt;    // format string address; format id in the file
+  unsigned short size;       // bytes used by the event (without padding)
+  unsigned char stream;      // trace_streams_type
+  unsigned char prefix;      // trace_prefix
+  int id[2];                 // core/partition and scheduler of the prefix
+  unsigned char n_args;
+  unsigned char arg_type[TRACE_MAX_ARGS];
+};
+
+// Assembles one event on the stack and hands it to the calling thread's ring.
+class event_builder {
+ public:
+  event_builder(unsigned stream, unsigned prefix, int id0, int id1,
+                unsigned long long cycle, const char* fmt) {
+    trace_event_header& h = header();
+    h.cycle = cycle;
+    h.fmt = (unsigned long long)fmt;
+    h.stream = stream;
+    h.prefix = prefix;
+    h.id[0] = id0;
+    h.id[1] = id1;
+    h.n_args = 0;
+    m_str_len = 0;
+  }
+
+  void add(int v) { put(TRACE_ARG_INT, (long long)v); }
+  void add(long v) { put(TRACE_ARG_INT, (long long)v); }
+  void add(long long v) { put(TRACE_ARG_INT, v); }
+  void add(unsigned v) { put(TRACE_ARG_UINT, (unsigned long long)v); }
+  void add(unsigned long v) { put(TRACE_ARG_UINT, (unsigned long long)v); }
+  void add(unsigned long long v) { put(TRACE_ARG_UINT, v); }
+  void add(double v) {
+    unsigned long long bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put(TRACE_ARG_DOUBLE, bits);
+  }
+  void add(const char* s);
+  void add(char* s) { add((const char*)s); }
+  template <class T>
+  void add(const T* p) {
+    put(TRACE_ARG_PTR, (unsigned long long)p);
+  }
+
+  // copy the event into this thread's ring
+  void commit();
+
+ private:
+  trace_event_header& header() { return *(trace_event_header*)m_event; }
+  unsigned char* arg(unsigned i) {
+    return (unsigned char*)m_event + sizeof(trace_event_header) + 8 * i;
+  }
+  void put(unsigned type, unsigned long long v) {
+    trace_event_header& h = header();
+    if (h.n_args == TRACE_MAX_ARGS) return;
+    h.arg_type[h.n_args] = type;
+    memcpy(arg(h.n_args), &v, 8);
+    h.n_args++;
+  }
+
+  // header followed by the arguments, kept 8-byte aligned
+  unsigned long long m_event[sizeof(trace_event_header) / 8 + TRACE_MAX_ARGS];
+  char m_str[TRACE_MAX_STR_SIZE];
+  unsigned m_str_len;
+};
+
+inline void add_args(event_builder&) {}
+template <class T, class... Rest>
+inline void add_args(event_builder& b, T v, Rest... rest) {
+  b.add(v);
+  add_args(b, rest...);
+}
+
+template <class... Args>
+void record(unsigned stream, unsigned prefix, int id0, int id1,
+            unsigned long long cycle, const char* fmt, Args... args) {
+  event_builder b(stream, prefix, id0, id1, cycle, fmt);
+  add_args(b, args...);
+  b.commit();
+}
+
+}  // namespace Trace
+
+#endif